@@ -2,6 +2,7 @@
 #define DIFF_H
 
 #include <stdbool.h>
+#include <stddef.h>
 
 // Apply a unified diff to `orig` -> `out`. Supports single-file diff with multiple hunks.
 // On success, returns true and stores malloc'ed result in `*out` (caller frees).
@@ -10,4 +11,71 @@
 bool apply_unified_diff(const char *orig, const char *diff,
                         char **out, char **errmsg);
 
+// Options for apply_unified_diff_opts. With `fuzzy`, a hunk whose context/deletion
+// lines do not match at its stated "@@ -start" is relocated to the nearest place
+// they do match (searching `window` lines either side, or the whole document when
+// window <= 0). Equally near candidates are reported as ambiguous rather than guessed.
+typedef struct {
+    bool fuzzy;
+    long window;
+    int  relocated;   // out: number of hunks applied away from their stated start
+} diff_apply_opts_t;
+
+bool apply_unified_diff_opts(const char *orig, const char *diff, diff_apply_opts_t *opts,
+                             char **out, char **errmsg);
+
+// Same, for an original that is not NUL-terminated (e.g. a mapped file).
+bool apply_unified_diff_n(const char *orig, size_t orig_len, const char *diff,
+                          diff_apply_opts_t *opts, char **out, char **errmsg);
+
+// ----- Multi-file patches -----
+
+// One "--- old / +++ new" section. Paths have git's a/ b/ prefixes removed;
+// "/dev/null" on either side marks a created or deleted file.
+typedef struct {
+    char *old_path, *new_path;
+    char *body;   // this file's hunks
+    bool skip;    // set by callers that apply this section themselves
+} patch_file_t;
+
+typedef struct {
+    patch_file_t *files;
+    size_t count;
+} patch_set_t;
+
+// Split a (possibly multi-file) unified diff into file sections. Text before the
+// first "--- "/"+++ " pair is ignored; a hunk's body ends where its @@ counts
+// say, so body lines that look like file headers stay in it. Free with patch_set_free.
+bool patch_set_parse(const char *diff, patch_set_t *out, char **errmsg);
+void patch_set_free(patch_set_t *ps);
+
+// Apply every non-skipped section to files under `root`. Paths that leave root,
+// also through a symlinked directory, and symlinks as targets are refused.
+// Sections for the same file apply in order; a section whose old and new names
+// differ renames the file, which no other section may then touch. Files are
+// patched in parallel on `threads` workers (<= 0: one per CPU) into temp files,
+// and renamed into place only if all of them succeeded; a failed rename rolls
+// back the files already replaced. *relocated (optional) sums the fuzzy relocations.
+bool patch_set_apply(const patch_set_t *ps, const char *root, const diff_apply_opts_t *opts,
+                     int threads, int *relocated, char **errmsg);
+
+// ----- Computing diffs (Myers, line level) -----
+
+// One run of changed lines: a[a_start, a_start+a_len) was replaced by
+// b[b_start, b_start+b_len) (0-based line indexes; either length may be 0).
+typedef struct {
+    size_t a_start, a_len;
+    size_t b_start, b_len;
+} diff_range_t;
+
+// Minimal set of changed line ranges between two texts, in order.
+// On success *out is malloc'ed (NULL when the texts are equal); caller frees.
+bool diff_line_ranges(const char *a, size_t alen, const char *b, size_t blen,
+                      diff_range_t **out, size_t *count);
+
+// Unified diff of a -> b with `context` lines around each change, in the form
+// apply_unified_diff consumes. Returns "" for equal texts, NULL on OOM; caller frees.
+char* diff_unified(const char *a, size_t alen, const char *b, size_t blen,
+                   const char *a_name, const char *b_name, int context);
+
 #endif /* DIFF_H */
@@ -0,0 +1,47 @@
+#ifndef DIRWALK_H
+#define DIRWALK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "settings.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Background directory walker for the Context tree.
+ *
+ * Directories are listed on a small work-stealing thread pool, each opened
+ * with openat() relative to the root and typed from d_type (fstatat only
+ * when the file system reports DT_UNKNOWN). Symlinks are listed but never
+ * followed. .gitignore files are honoured per directory (globs, "**", "!"
+ * negation, trailing "/" for directories, "/" anchoring); ".git" is always
+ * skipped and IDY_CTX_IGNORE adds comma-separated root-level patterns.
+ *
+ * The walk streams: dirwalk_poll re-flattens whatever has been listed so
+ * far (dirs first, case-insensitive, same shape as list_dir), so the tree
+ * renders progressively. All calls are from one (the UI) thread. */
+typedef struct dirwalk dirwalk_t;
+
+#define DW_MAX_THREADS 8
+
+dirwalk_t* dirwalk_start(const char *root);          // NULL if root cannot be opened
+bool dirwalk_poll(dirwalk_t *w, file_list_t *out);   // true if *out was rebuilt
+bool dirwalk_done(const dirwalk_t *w);
+void dirwalk_wait(dirwalk_t *w);                     // block until the walk finishes
+size_t dirwalk_entries(const dirwalk_t *w);          // entries found so far
+void dirwalk_free(dirwalk_t *w);                     // stops a running walk
+
+/* Live updates: once the walk is done, dirwalk_watch puts an inotify watch
+ * on every listed directory and starts a reader thread. dirwalk_apply_events
+ * (UI thread) applies what arrived since the last call to the tree and
+ * reports each touched file (path relative to the root) to on_file. Returns
+ * 1 if the tree changed (call dirwalk_poll), 0 if not, -1 if events were
+ * lost (queue overflow): the caller should start a fresh walk. */
+bool dirwalk_watch(dirwalk_t *w);
+int  dirwalk_apply_events(dirwalk_t *w, void (*on_file)(const char *rel, void *user), void *user);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -4,6 +4,20 @@
 #include "idy.h"
 #include <stdbool.h>
 
+// Undo history entry: a document version plus where the caret was.
+typedef struct {
+    buf_snap_t snap;
+    size_t cursor;
+} editor_undo_t;
+
+#define EDITOR_UNDO_MAX 512  // oldest steps are dropped beyond this
+
+typedef enum {
+    EDIT_OP_NONE = 0,
+    EDIT_OP_TYPE,      // consecutive typed chars coalesce into one undo step
+    EDIT_OP_OTHER
+} editor_op_t;
+
 typedef struct {
     buffer_t *doc;
     size_t cursor;     // byte index in doc->data
@@ -17,9 +31,20 @@ typedef struct {
 
     // Dirty flag (modified since last save)
     bool dirty;
+
+    // Undo/redo stacks (snapshots share structure with the live document)
+    editor_undo_t *undo; int undo_n, undo_cap;
+    editor_undo_t *redo; int redo_n, redo_cap;
+    editor_op_t last_op;   // kind of the previous edit (for coalescing)
+    size_t last_cursor;    // caret right after the previous edit
 } editor_t;
 
 void editor_init(editor_t *e, buffer_t *doc);
+void editor_free(editor_t *e);           // releases undo/redo history (not the document)
+void editor_clear_history(editor_t *e);  // call after replacing the document content
+bool editor_undo(editor_t *e);
+bool editor_redo(editor_t *e);
+void editor_replace_all(editor_t *e, const char *s, size_t n); // undoable whole-document replace
 void editor_insert_char(editor_t *e, char c);
 void editor_insert_text(editor_t *e, const char *s);
 void editor_delete_range(editor_t *e, size_t a, size_t b);
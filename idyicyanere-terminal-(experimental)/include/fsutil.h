@@ -2,6 +2,7 @@
 #define FSUTIL_H
 
 #include <stdbool.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -10,6 +11,23 @@ extern "C" {
 bool fs_is_dir(const char *p);
 bool fs_is_file(const char *p);
 
+/* Read-only view of a whole file. Files of at least FS_MAP_MIN_BYTES are
+ * mmap'ed (pages are faulted in on first touch); smaller ones are read into a
+ * NUL-terminated heap buffer. A mapped view is NOT NUL-terminated, and it
+ * reflects the file in place: truncating the file while mapped raises SIGBUS
+ * on access, so writers of the same path must replace it (write + rename)
+ * or stop using the view first. */
+#define FS_MAP_MIN_BYTES ((size_t)1 << 20)
+
+typedef struct {
+    const char *data;
+    size_t len;
+    bool mapped;
+} fs_view_t;
+
+bool fs_view_open(fs_view_t *v, const char *path);
+void fs_view_close(fs_view_t *v);
+
 #ifdef __cplusplus
 }
 #endif
@@ -29,19 +29,83 @@ typedef struct {
     size_t prompt_max_ctx;
 } idy_config_t;
 
+/* ===== Document buffer (piece table) =====
+ * Text lives in two stores: the read-only original (file contents as loaded)
+ * and an append-only add buffer. The document is the in-order sequence of
+ * pieces over those stores, kept in a persistent (path-copying, refcounted)
+ * treap keyed by byte offset. Edits cost O(log n) and never move text; a
+ * snapshot is just a retained root, which makes undo/redo cheap.
+ * Large files are mapped rather than read, and the original's newline index
+ * is one count per BUF_NL_BLOCK bytes, built on demand: only the prefix that
+ * has been viewed or edited is in the tree, the rest of the original is an
+ * unindexed tail read straight from the mapping. Opening is O(1) in file size.
+ */
+#define BUF_NL_BLOCK 4096
+#define BUF_INDEX_STEP ((size_t)64 * BUF_NL_BLOCK) // least tail indexed at a time
+typedef struct buf_node buf_node_t;
+
 typedef struct {
-    char *data;      // zero-terminated edit buffer
-    size_t len;
-    size_t cap;
+    const char *orig;  // original text (owned, never modified; mmap'ed for large files)
+    size_t orig_len;
+    bool   orig_mapped;
+    char  *add;        // append-only add buffer (owned)
+    size_t add_len;
+    size_t add_cap;
+    size_t *orig_ck;   // orig_ck[i] = newlines in orig[0, i*BUF_NL_BLOCK), for blocks up to orig_tail
+    size_t  orig_ck_n, orig_ck_cap;
+    size_t  orig_tail; // orig[orig_tail, orig_len) follows the tree and is not indexed yet
+    size_t *add_nl;    // sorted offsets of '\n' in add (appended with the text)
+    size_t  add_nl_n, add_nl_cap;
+    buf_node_t *root;  // piece tree
+    size_t len;        // document length in bytes
+
+    // Lazily materialized contiguous copy (see buf_data)
+    char  *flat;
+    bool   flat_ok;
 } buffer_t;
 
+// Immutable document version. Valid until the buffer is reloaded or freed.
+typedef struct {
+    buf_node_t *root;
+    size_t len;
+    size_t orig_tail;
+} buf_snap_t;
+
 void buf_init(buffer_t *b);
 void buf_free(buffer_t *b);
-bool buf_load_file(buffer_t *b, const char *path);
+bool buf_load_file(buffer_t *b, const char *path);   // replaces content; stale snapshots must not be restored
 bool buf_save_file(buffer_t *b, const char *path);
 
+// Edits (byte offsets are clamped to the document)
+void buf_insert(buffer_t *b, size_t pos, const char *s, size_t n);
+void buf_delete(buffer_t *b, size_t a, size_t e);     // removes [a, e)
+void buf_replace_all(buffer_t *b, const char *s, size_t n);
+
+// Reads
+size_t buf_chunk(const buffer_t *b, size_t pos, const char **out); // longest contiguous span at pos (0 at EOF)
+int    buf_char_at(const buffer_t *b, size_t pos);                  // -1 past the end
+size_t buf_copy(const buffer_t *b, size_t a, size_t e, char *dst);  // copies [a, e) to dst, returns bytes
+char*  buf_strndup(const buffer_t *b, size_t a, size_t e);          // malloc'ed, NUL-terminated copy of [a, e)
+const char* buf_data(buffer_t *b);  // contiguous, NUL-terminated view; valid until the next edit
+
+// Line index (rows are 0-based; a document has newline count + 1 rows).
+// Queries index the original only as far as they need; the index is a cache,
+// so these take const buffers.
+size_t buf_line_count(const buffer_t *b);            // exact; indexes the whole original on first call
+size_t buf_line_count_known(const buffer_t *b);      // rows indexed so far (== buf_line_count once complete), O(1)
+bool   buf_has_row(const buffer_t *b, size_t row);   // row < buf_line_count, indexing only up to row
+size_t buf_line_of(const buffer_t *b, size_t pos);   // row holding byte pos, O(log n)
+size_t buf_line_start(const buffer_t *b, size_t row);// first byte of row (len if past the end), O(log n)
+
+// Snapshots (undo/redo)
+buf_snap_t buf_snapshot(const buffer_t *b);
+void buf_restore(buffer_t *b, const buf_snap_t *s);  // does not consume s
+void buf_snap_release(buf_snap_t *s);
+
 /* ===== Env helpers (trim whitespace incl. stray \r/\n) ===== */
 char* idy_getenv_trimdup(const char *key);  // malloc'd, trimmed; NULL if unset/empty
 int   idy_env_truthy(const char *key);      // 1 if {1,true,yes,on,y} (case-insensitive), else 0
+size_t idy_env_parse_size(const char *key, size_t def_value); // "64k", "4 MiB", ...; def_value if unset/invalid
+size_t idy_env_parse_count(const char *key, size_t def_value); // plain decimal, 0 allowed; def_value if unset/invalid
 
 #endif
@@ -3,6 +3,7 @@
 
 #include <stdarg.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <time.h>
 
 #ifdef __cplusplus
@@ -17,40 +18,60 @@ typedef enum {
     LOG_ERROR = 4
 } log_level_t;
 
+/* Messages are formatted straight into fixed-size slots of one preallocated
+ * slab; longer ones are cut at a UTF-8 boundary and end with "...[+N bytes]". */
+#define LOG_MSG_MAX 1024   // bytes per message slot, including the NUL
+
 typedef struct {
+    uint64_t seq;      // 1, 2, ... in ring order; never reused (survives log_init)
     log_level_t level;
     struct timespec ts;
     const char *src_file;
     int src_line;
-    const char *msg;   // owned by logger
+    const char *msg;   // owned by logger (points into its slab)
 } log_entry_t;
 
-typedef struct {
-    size_t cap;        // ring capacity
-    size_t count;      // number of valid items (<= cap)
-    size_t head;       // next write index
-    log_level_t min_level;
-    log_entry_t *v;    // ring storage
-} logger_t;
+/* Threads: the thread that calls log_init owns the ring. Its messages go
+ * straight in; other threads push into a lock-free bounded MPSC queue that
+ * the owner empties with log_drain() (log_iter_from drains first). When the
+ * queue is full, messages are dropped and counted, never blocked on.
+ * log_init/log_shutdown must not race with logging threads. */
+#define LOG_QUEUE_CAP 256  // pending cross-thread messages (power of two)
 
 void log_init(size_t capacity);
 void log_shutdown(void);
-void log_set_level(log_level_t lvl);
+size_t log_drain(void);                 // owner thread only; returns messages moved into the ring
+void log_set_level(log_level_t lvl);   // messages below this level are dropped unformatted
 log_level_t log_get_level(void);
 const char* log_level_name(log_level_t lvl);
+log_level_t log_level_parse(const char *name, log_level_t def); // "trace".."error" or "0".."4"
+int log_enabled(log_level_t lvl);
 
-// Adds a message (printf-style). Message is owned by logger and freed when overwritten.
-void log_msg_(log_level_t lvl, const char *file, int line, const char *fmt, ...);
+// Adds a message (printf-style). Text is copied into the ring slot it overwrites.
+void log_msg_(log_level_t lvl, const char *file, int line, const char *fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+
+/* Reader cursor over the ring, in place (owner thread only; log_iter_from
+ * drains first). Entries returned by log_iter_next stay valid until the next
+ * log call on the owner thread. A cursor that the ring has overtaken resumes
+ * at the oldest retained entry. */
+typedef struct {
+    uint64_t seq;         // next sequence number to look at
+    log_level_t filter;   // only entries >= filter
+} log_iter_t;
 
-// Snapshot: returns a heap-allocated array (shallow copies) of entries >= filter.
-// Return value is count; *out receives pointer; caller frees the array (not strings).
-size_t log_snapshot(log_level_t filter, log_entry_t **out);
+log_iter_t log_iter_from(uint64_t seq, log_level_t filter); // seq 0: oldest retained
+const log_entry_t* log_iter_next(log_iter_t *it);           // NULL when caught up
+uint64_t log_oldest_seq(void);  // oldest retained entry (== log_next_seq() if empty)
+uint64_t log_next_seq(void);    // sequence number the next entry will get
 
-#define LOG_TRACE(...) log_msg_(LOG_TRACE,__FILE__,__LINE__,__VA_ARGS__)
-#define LOG_DEBUG(...) log_msg_(LOG_DEBUG,__FILE__,__LINE__,__VA_ARGS__)
-#define LOG_INFO(...)  log_msg_(LOG_INFO, __FILE__,__LINE__,__VA_ARGS__)
-#define LOG_WARN(...)  log_msg_(LOG_WARN, __FILE__,__LINE__,__VA_ARGS__)
-#define LOG_ERROR(...) log_msg_(LOG_ERROR,__FILE__,__LINE__,__VA_ARGS__)
+// Level is tested before the arguments are evaluated or formatted.
+#define LOG_AT_(lvl, ...) do{ if(log_enabled(lvl)) log_msg_(lvl,__FILE__,__LINE__,__VA_ARGS__); }while(0)
+#define LOG_TRACE(...) LOG_AT_(LOG_TRACE,__VA_ARGS__)
+#define LOG_DEBUG(...) LOG_AT_(LOG_DEBUG,__VA_ARGS__)
+#define LOG_INFO(...)  LOG_AT_(LOG_INFO, __VA_ARGS__)
+#define LOG_WARN(...)  LOG_AT_(LOG_WARN, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT_(LOG_ERROR,__VA_ARGS__)
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,54 @@
+#ifndef NETSTATS_H
+#define NETSTATS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <curl/curl.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Per-request timing for HTTP calls (chat streaming, embeddings).
+ *
+ * After each curl_easy_perform the caller hands the handle to netstats_record,
+ * which reads curl's phase times (DNS, TCP connect, TLS, time to first byte,
+ * transfer), logs them in one DEBUG line and keeps the last NET_WINDOW
+ * successful samples per kind. The Logs screen shows rolling percentiles:
+ * large dns/connect/tls/ttfb point at the network or the server, a large
+ * transfer with low tok/s at generation speed. Thread-safe. */
+
+typedef enum { NET_CHAT = 0, NET_EMBED, NET_KINDS } net_kind_t;
+
+typedef enum {
+    NET_DNS = 0,     // name lookup (ms)
+    NET_CONNECT,     // TCP connect after lookup (ms)
+    NET_TLS,         // TLS handshake after connect (ms; 0 for plain HTTP)
+    NET_TTFB,        // request sent -> first response byte (ms)
+    NET_TRANSFER,    // first -> last response byte (ms)
+    NET_TOTAL,       // whole request (ms)
+    NET_UP,          // request body (bytes)
+    NET_DOWN,        // response body (bytes)
+    NET_TPS,         // streamed tokens per second of transfer (chat only)
+    NET_METRICS
+} net_metric_t;
+
+#define NET_WINDOW 64
+
+typedef struct {
+    int total, failed;            // since start
+    int samples;                  // in the window (successful requests)
+    double p50[NET_METRICS], p90[NET_METRICS], p99[NET_METRICS];
+} net_summary_t;
+
+// tokens: generated tokens for a streamed response (0 if not applicable).
+void netstats_record(net_kind_t kind, CURL *curl, size_t up_bytes, size_t down_bytes, long tokens, bool ok);
+
+bool netstats_summary(net_kind_t kind, net_summary_t *out);  // false if nothing recorded yet
+const char* netstats_kind_name(net_kind_t kind);
+const char* netstats_metric_name(net_metric_t m);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -1,17 +1,39 @@
 #ifndef PREVIEW_H
 #define PREVIEW_H
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-// Build the context preview string for the Context panel.
+// Rendered context preview plus a line-start index, so a viewport can be drawn
+// without scanning from the top.
+typedef struct {
+    char   *text;      // NUL-terminated export ("" when empty or out of memory)
+    size_t  len;
+    size_t *line_off;  // line_off[i]: byte offset of line i, for i in [0, lines]
+    int     lines;     // number of newline characters (scroll range)
+} preview_t;
+
+// Build the context preview for the Context panel into *pv (previous contents freed).
 //  - cwd: header root displayed at the top
 //  - paths: absolute file paths to include
 //  - count: number of paths
-// Returns a newly allocated string (caller frees).
-// If out_lines != NULL, it receives the number of newline characters (for scrolling).
-char* preview_build(const char *cwd, char **paths, int count, int *out_lines);
+// Rendered file blocks (and their line offsets) are cached per path and
+// reused while (mtime, size) match.
+void preview_build(preview_t *pv, const char *cwd, char **paths, int count);
+void preview_free(preview_t *pv);
+
+// Line i of pv as [*start, *start + return value), without the newline.
+size_t preview_line(const preview_t *pv, int i, const char **start);
+
+// Frees the per-file block cache.
+void preview_cache_clear(void);
+
+// Forces the next build to re-read path (e.g. it was written within the same
+// mtime tick, which (mtime, size) alone could miss).
+void preview_mark_dirty(const char *path);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,50 @@
+#ifndef RAG_H
+#define RAG_H
+
+#include "idy.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Retrieval-based context for suggestions.
+ *
+ * The selected context files are cut into line-aligned chunks of about
+ * IDY_RAG_CHUNK bytes. Each chunk is embedded once (OpenAI-compatible
+ * embeddings, OPENAI_EMBEDDINGS_MODEL) and stored in an idydb file
+ * (IDY_RAG_DB, default $XDG_CACHE_HOME/idyicyanere/context-<workspace>.idydb,
+ * one per workspace directory), keyed by a hash of model and text, so
+ * unchanged chunks are never re-embedded.
+ * A query embeds the editor selection (or the region around the cursor) and
+ * sends the IDY_RAG_TOPK nearest chunks instead of the whole concatenation.
+ * The file is only open (and locked) from rag_sync until rag_release, so
+ * several instances can share it; one that finds it busy falls back for that
+ * request and tries again on the next. All calls are from the UI thread. */
+typedef struct rag rag_t;
+
+#define RAG_TOPK_DEFAULT  12
+#define RAG_CHUNK_DEFAULT 2048
+
+// NULL db_path: the default file for workspace (a directory). Does not touch
+// the file yet; NULL on failure (logged).
+rag_t* rag_open(const char *db_path, const char *workspace);
+void   rag_close(rag_t *r);
+
+// Opens the index file if needed and brings it in line with paths: chunks
+// them, embeds and stores new chunks, drops rows of chunks no longer
+// selected. False on failure (*err set), e.g. when another instance holds it.
+bool rag_sync(rag_t *r, idy_config_t *cfg, char **paths, int count, size_t chunk_bytes, char **err);
+
+// Context block of the topk chunks nearest to query (at most max_bytes),
+// grouped by file in selection order. NULL on failure (*err set);
+// *out_chunks receives how many chunks it holds.
+char* rag_query(rag_t *r, idy_config_t *cfg, const char *query, int topk, size_t max_bytes,
+                int *out_chunks, char **err);
+
+// Closes the index file (and drops its lock) until the next rag_sync.
+void   rag_release(rag_t *r);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -17,6 +17,7 @@ typedef struct {
 
 // Recursively lists a directory into a flattened tree (dirs first per level).
 // Fills out->items with relative paths and depth for pretty rendering.
+// Honours .gitignore (see dirwalk.h); returns false if path cannot be opened.
 bool list_dir(const char *path, file_list_t *out);
 void free_file_list(file_list_t *fl);
 
@@ -1,6 +1,7 @@
 #ifndef SHA256_H
 #define SHA256_H
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -8,10 +9,34 @@
 extern "C" {
 #endif
 
+// Streaming: init once, update with any number of pieces, final writes the digest.
+typedef struct {
+    uint32_t h[8];
+    uint64_t len;      // bytes fed so far
+    uint8_t buf[64];   // pending partial block
+    size_t nbuf;
+} sha256_ctx_t;
+
+void sha256_init(sha256_ctx_t *c);
+void sha256_update(sha256_ctx_t *c, const void *data, size_t len);
+void sha256_final(sha256_ctx_t *c, uint8_t out[32]);
+
 void sha256_bytes(const uint8_t *data, size_t len, uint8_t out[32]);
 
 // out_hex must have space for 65 bytes (64 hex chars + NUL)
 void sha256_hex(const uint8_t *data, size_t len, char out_hex[65]);
+void sha256_to_hex(const uint8_t dig[32], char out_hex[65]);
+
+// Hashes n independent messages; on AVX2 without SHA-NI, up to SHA256_LANES at once.
+#define SHA256_LANES 8
+void sha256_many(const uint8_t *const *data, const size_t *len, size_t n, uint8_t (*out)[32]);
+
+/* Block kernels are picked at first use from what the CPU supports:
+ * SHA-NI, else portable scalar (with AVX2 multi-buffer for sha256_many).
+ * IDY_SHA256=scalar|sha-ni|avx2|auto overrides; sha256_select does the same
+ * at run time and returns false if the CPU lacks the requested one. */
+bool sha256_select(const char *name);
+const char* sha256_impl_name(void);
 
 #ifdef __cplusplus
 }
@@ -5,6 +5,16 @@
 #include "editor.h"
 #include "log.h"
 #include "settings.h"
+#include "preview.h"
+
+typedef enum {
+    SCREEN_EDITOR   = 0,
+    SCREEN_LOGS     = 1,
+    SCREEN_CONTEXT  = 2   // formerly SCREEN_SETTINGS
+} screen_t;
+
+// Redraws owed by input are coalesced to at most one frame per budget.
+#define TUI_FRAME_MS 16
 
 typedef struct {
     WINDOW *left;
@@ -17,6 +27,21 @@ typedef struct {
 
     // Soft-blink overlay for caret
     bool blink_on;
+
+    /* Damage tracking: the editor screen repaints only rows whose content
+       signature changed since the previous frame. Anything that invalidates
+       what is on screen (resize, another screen painting the panes) forces
+       a full repaint. */
+    screen_t painted;     // screen whose content the panes currently show
+    bool damage_all;      // force a full repaint on the next editor draw
+    uint64_t *row_sig;    // per-row signature of the editor pane (0 = unknown)
+    int row_sig_n;
+    uint64_t title_sig;   // editor title (path + dirty flag)
+    uint64_t diff_sig;    // visible part of the diff pane
+    int caret_y, caret_x; // caret cell in the editor pane (-1 if off-screen)
+    bool caret_lit;       // blink overlay currently applied at caret_y/x
+
+    struct log_rows *log_rows; // Logs screen: sanitized/wrapped entries cache (tui_logs.c)
 } tui_t;
 
 /* -------- Color pair constants (kept stable across modules) --------
@@ -35,14 +60,8 @@ typedef struct {
 #define IDY_PAIR_CFG_VAL  14
 #define IDY_PAIR_TITLE    15
 
-typedef enum {
-    SCREEN_EDITOR   = 0,
-    SCREEN_LOGS     = 1,
-    SCREEN_CONTEXT  = 2   // formerly SCREEN_SETTINGS
-} screen_t;
-
 void tui_init(tui_t *t);
-void tui_end(void);
+void tui_end(tui_t *t);
 void tui_resize(tui_t *t);
 
 // Common status bar painter (exported so draw units can reuse consistently)
@@ -58,6 +77,9 @@ void tui_draw_editor(tui_t *t,
                      const char *status,
                      const char *filepath); // <-- show current file path in title
 
+// Caret blink: flips the overlay on the single caret cell (no repaint).
+void tui_blink_caret(tui_t *t);
+
 // Logs: left pane scroll via *scroll_lines (0 = follow tail / newest)
 //       right pane (Config) scroll via *rhs_scroll (0 = top of Config)
 void tui_draw_logs(tui_t *t,
@@ -65,9 +87,10 @@ void tui_draw_logs(tui_t *t,
                    const char *status,
                    int *scroll_lines,
                    int *rhs_scroll);
+void tui_logs_free(tui_t *t);
 
 // Context (formerly "Settings"): left shows directory with checkboxes;
-// right shows preview (string) scrolled by ctx_scroll.
+// right shows the preview scrolled by ctx_scroll (only visible lines are touched).
 void tui_draw_context(tui_t *t,
                       const char *cwd,
                       const file_list_t *fl,
@@ -75,7 +98,7 @@ void tui_draw_context(tui_t *t,
                       const idy_config_t *cfg,
                       char **ctx_files,
                       int ctx_count,
-                      const char *ctx_preview,
+                      const preview_t *ctx_preview,
                       int ctx_scroll,
                       const char *status);
 
@@ -1,55 +1,602 @@
 #include "idy.h"
+#include "fsutil.h"
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
 
-/* ========= Buffer implementation (moved from util.c) ========= */
+/* ========= Buffer implementation: persistent piece tree =========
 
-void buf_init(buffer_t *b){
-    b->cap = 4096;
-    b->len = 0;
-    b->data = (char*)malloc(b->cap);
-    if(!b->data){
-        b->cap = 0; b->len = 0;
-        return;
+   Each node is one piece (src, off, len) plus the byte and newline counts of
+   its subtree. Newline offsets of the add store are kept in a sorted array;
+   the original only keeps a newline count per BUF_NL_BLOCK bytes and finishes
+   lookups with a memchr over at most one block, so a mapped file is touched
+   only where it is read. Either way the newlines inside any piece are cheap
+   to count and the tree answers row <-> offset queries in O(log n).
+   The original enters the tree lazily: orig[orig_tail, orig_len) is the
+   document's unindexed end, and orig_extend() counts the next blocks and
+   moves them into the tree when a query or edit reaches them.
+   Nodes are refcounted and shared between versions; any mutation first goes
+   through node_mut(), which copies a node only when someone else holds it.
+   With no live snapshots every edit is in place; with snapshots, an edit
+   copies just the O(log n) nodes along its path.
+*/
+
+enum { SRC_ORIG = 0, SRC_ADD = 1 };
+
+struct buf_node {
+    buf_node_t *l, *r;
+    uint32_t prio;     // treap heap priority (max-heap)
+    uint32_t refs;
+    uint8_t  src;      // SRC_ORIG | SRC_ADD
+    size_t   off, len; // piece span inside its store
+    size_t   lf;       // newlines inside this piece
+    size_t   sum;      // bytes in this subtree
+    size_t   lf_sum;   // newlines in this subtree
+};
+
+static uint32_t prio_state = 0x9e3779b9u;
+static uint32_t next_prio(void){
+    // xorshift32: cheap, good enough for treap balancing
+    uint32_t x = prio_state;
+    x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+    return prio_state = x;
+}
+
+/* ---------------- newline index per store ---------------- */
+
+// First index i with v[i] >= x.
+static size_t lower_bound(const size_t *v, size_t n, size_t x){
+    size_t lo = 0, hi = n;
+    while(lo < hi){
+        size_t mid = lo + (hi - lo) / 2;
+        if(v[mid] < x) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+// Newlines in orig[0, x).
+static size_t orig_lf_before(const buffer_t *b, size_t x){
+    size_t blk = x / BUF_NL_BLOCK;
+    size_t n = b->orig_ck[blk];
+    const char *p = b->orig + blk * BUF_NL_BLOCK, *e = b->orig + x;
+    while(p < e && (p = memchr(p, '\n', (size_t)(e - p)))){ n++; p++; }
+    return n;
+}
+
+// Offset of the g-th (0-based) newline of orig; g must be < total newlines.
+static size_t orig_nl_at(const buffer_t *b, size_t g){
+    // Last block whose leading count is <= g holds it
+    size_t lo = 0, hi = b->orig_ck_n;
+    while(hi - lo > 1){
+        size_t mid = lo + (hi - lo) / 2;
+        if(b->orig_ck[mid] <= g) lo = mid; else hi = mid;
+    }
+    const char *p = b->orig + lo * BUF_NL_BLOCK, *e = b->orig + b->orig_len;
+    for(size_t k = g - b->orig_ck[lo]; ; k--, p++){
+        p = memchr(p, '\n', (size_t)(e - p));
+        if(k == 0) return (size_t)(p - b->orig);
+    }
+}
+
+// Newlines inside [off, off+len) of a store.
+static size_t piece_lf(const buffer_t *b, uint8_t src, size_t off, size_t len){
+    if(src == SRC_ORIG) return orig_lf_before(b, off + len) - orig_lf_before(b, off);
+    return lower_bound(b->add_nl, b->add_nl_n, off + len) - lower_bound(b->add_nl, b->add_nl_n, off);
+}
+
+// Store offset of the k-th (1-based) newline at or after off in a store.
+static size_t piece_nl_at(const buffer_t *b, uint8_t src, size_t off, size_t k){
+    if(src == SRC_ORIG) return orig_nl_at(b, orig_lf_before(b, off) + k - 1);
+    return b->add_nl[lower_bound(b->add_nl, b->add_nl_n, off) + k - 1];
+}
+
+// Extend the per-block newline counts of orig to cover orig[0, end).
+static bool orig_index_grow(buffer_t *b, size_t end){
+    size_t nblk = end / BUF_NL_BLOCK + 1;
+    if(nblk > b->orig_ck_cap){
+        size_t cap = b->orig_ck_cap ? b->orig_ck_cap : 64;
+        while(cap < nblk) cap *= 2;
+        size_t *nv = (size_t*)realloc(b->orig_ck, sizeof(size_t) * cap);
+        if(!nv) return false;
+        b->orig_ck = nv; b->orig_ck_cap = cap;
+    }
+    if(b->orig_ck_n == 0) b->orig_ck[b->orig_ck_n++] = 0;
+    for(size_t i = b->orig_ck_n; i < nblk; i++){
+        size_t n = b->orig_ck[i - 1];
+        const char *p = b->orig + (i - 1) * BUF_NL_BLOCK;
+        const char *e = b->orig + (i * BUF_NL_BLOCK < b->orig_len ? i * BUF_NL_BLOCK : b->orig_len);
+        while(p < e && (p = memchr(p, '\n', (size_t)(e - p)))){ n++; p++; }
+        b->orig_ck[i] = n;
+    }
+    if(nblk > b->orig_ck_n) b->orig_ck_n = nblk;
+    return true;
+}
+
+// Append the offsets of newlines in s[0..n) (placed at base) to *v.
+static bool nl_index_append(size_t **v, size_t *vn, size_t *vcap, const char *s, size_t n, size_t base){
+    for(const char *q = s; (q = memchr(q, '\n', n - (size_t)(q - s))); q++){
+        if(*vn == *vcap){
+            size_t nc = *vcap ? *vcap * 2 : 256;
+            size_t *nv = (size_t*)realloc(*v, sizeof(size_t) * nc);
+            if(!nv) return false;
+            *v = nv; *vcap = nc;
+        }
+        (*v)[(*vn)++] = base + (size_t)(q - s);
     }
-    b->data[0] = '\0';
+    return true;
+}
+
+/* ---------------- tree nodes ---------------- */
+
+static size_t node_sum(const buf_node_t *t){ return t ? t->sum : 0; }
+static size_t node_lf_sum(const buf_node_t *t){ return t ? t->lf_sum : 0; }
+static void node_update(buf_node_t *t){
+    t->sum    = node_sum(t->l) + t->len + node_sum(t->r);
+    t->lf_sum = node_lf_sum(t->l) + t->lf + node_lf_sum(t->r);
+}
+
+static buf_node_t *node_new(const buffer_t *b, uint8_t src, size_t off, size_t len){
+    buf_node_t *t = (buf_node_t*)malloc(sizeof(*t));
+    if(!t) return NULL;
+    t->l = t->r = NULL;
+    t->prio = next_prio();
+    t->refs = 1;
+    t->src = src; t->off = off; t->len = len;
+    t->lf = piece_lf(b, src, off, len);
+    t->sum = len; t->lf_sum = t->lf;
+    return t;
+}
+
+static buf_node_t *node_retain(buf_node_t *t){ if(t) t->refs++; return t; }
+
+static void node_release(buf_node_t *t){
+    while(t && --t->refs == 0){
+        buf_node_t *l = t->l, *r = t->r;
+        free(t);
+        node_release(l);
+        t = r; // iterate on the right spine
+    }
+}
+
+// Return a node we may modify in place. Consumes the caller's reference to t.
+static buf_node_t *node_mut(buf_node_t *t){
+    if(t->refs == 1) return t;
+    buf_node_t *c = (buf_node_t*)malloc(sizeof(*c));
+    if(!c) abort(); // a half-copied tree cannot be recovered
+    *c = *t;
+    c->refs = 1;
+    node_retain(c->l); node_retain(c->r);
+    t->refs--;
+    return c;
+}
+
+// Split t (consumed) into [0, pos) -> *a and [pos, end) -> *b.
+static void node_split(const buffer_t *buf, buf_node_t *t, size_t pos, buf_node_t **a, buf_node_t **b){
+    if(!t){ *a = *b = NULL; return; }
+    t = node_mut(t);
+    size_t ls = node_sum(t->l);
+    if(pos <= ls){
+        node_split(buf, t->l, pos, a, &t->l);
+        node_update(t); *b = t;
+    } else if(pos >= ls + t->len){
+        node_split(buf, t->r, pos - ls - t->len, &t->r, b);
+        node_update(t); *a = t;
+    } else {
+        // Cut inside this piece: left half keeps the left subtree, right half the right one
+        size_t k = pos - ls;
+        buf_node_t *rt = node_new(buf, t->src, t->off + k, t->len - k);
+        if(!rt) abort();
+        rt->prio = t->prio;
+        rt->r = t->r; t->r = NULL;
+        t->len = k;
+        t->lf -= rt->lf;
+        node_update(t); node_update(rt);
+        *a = t; *b = rt;
+    }
+}
+
+// Concatenate a and b (both consumed).
+static buf_node_t *node_merge(buf_node_t *a, buf_node_t *b){
+    if(!a) return b;
+    if(!b) return a;
+    if(a->prio > b->prio){
+        a = node_mut(a);
+        a->r = node_merge(a->r, b);
+        node_update(a);
+        return a;
+    }
+    b = node_mut(b);
+    b->l = node_merge(a, b->l);
+    node_update(b);
+    return b;
+}
+
+// Piece holding byte pos (pos < tree size); *start receives its document offset.
+static const buf_node_t *node_find(const buf_node_t *t, size_t pos, size_t *start){
+    size_t base = 0;
+    while(t){
+        size_t ls = node_sum(t->l);
+        if(pos < ls){ t = t->l; continue; }
+        if(pos < ls + t->len){ *start = base + ls; return t; }
+        base += ls + t->len;
+        pos  -= ls + t->len;
+        t = t->r;
+    }
+    return NULL;
+}
+
+// Grow the piece holding byte pos by n bytes carrying lf newlines
+// (t consumed, path copied as needed).
+static buf_node_t *node_grow(buf_node_t *t, size_t pos, size_t n, size_t lf){
+    t = node_mut(t);
+    size_t ls = node_sum(t->l);
+    if(pos < ls)                t->l = node_grow(t->l, pos, n, lf);
+    else if(pos >= ls + t->len) t->r = node_grow(t->r, pos - ls - t->len, n, lf);
+    else                      { t->len += n; t->lf += lf; }
+    node_update(t);
+    return t;
+}
+
+static const char *piece_base(const buffer_t *b, const buf_node_t *t){
+    return t->src == SRC_ORIG ? b->orig : b->add;
+}
+
+/* ---------------- lazy original ---------------- */
+
+static size_t tail_len(const buffer_t *b){ return b->orig_len - b->orig_tail; }
+
+// Move the tail into the tree until it covers document bytes [0, upto), in
+// whole blocks and at least BUF_INDEX_STEP at a time. The index is a cache:
+// callers holding a const buffer may extend it (buffers are never const objects).
+static bool orig_extend(const buffer_t *cb, size_t upto){
+    buffer_t *b = (buffer_t*)cb;
+    size_t tree = node_sum(b->root);
+    if(upto <= tree || tail_len(b) == 0) return true;
+
+    size_t end = b->orig_tail + (upto - tree);
+    if(end < b->orig_tail + BUF_INDEX_STEP) end = b->orig_tail + BUF_INDEX_STEP;
+    end = (end + BUF_NL_BLOCK - 1) / BUF_NL_BLOCK * BUF_NL_BLOCK;
+    if(end > b->orig_len) end = b->orig_len;
+    if(!orig_index_grow(b, end)) return false;
+
+    size_t off = b->orig_tail, n = end - off;
+    size_t start = 0;
+    const buf_node_t *last = tree ? node_find(b->root, tree - 1, &start) : NULL;
+    if(last && last->src == SRC_ORIG && last->off + last->len == off){
+        b->root = node_grow(b->root, tree - 1, n, piece_lf(b, SRC_ORIG, off, n));
+    } else {
+        buf_node_t *piece = node_new(b, SRC_ORIG, off, n);
+        if(!piece) return false;
+        b->root = node_merge(b->root, piece);
+    }
+    b->orig_tail = end;
+    return true;
+}
+
+// Index until row exists in the tree or the whole original is indexed.
+static void orig_extend_rows(const buffer_t *b, size_t row){
+    while(node_lf_sum(b->root) < row && tail_len(b) > 0){
+        if(!orig_extend(b, node_sum(b->root) + 1)) return;
+    }
+}
+
+/* ---------------- lifecycle ---------------- */
+
+void buf_init(buffer_t *b){
+    memset(b, 0, sizeof(*b));
 }
 
 void buf_free(buffer_t *b){
     if(!b) return;
-    free(b->data);
-    b->data = NULL;
-    b->len = 0;
-    b->cap = 0;
+    node_release(b->root);
+    fs_view_t v = { b->orig, b->orig_len, b->orig_mapped };
+    fs_view_close(&v);
+    free(b->add);
+    free(b->orig_ck);
+    free(b->add_nl);
+    free(b->flat);
+    memset(b, 0, sizeof(*b));
 }
 
 bool buf_load_file(buffer_t *b, const char *path){
-    FILE *f = fopen(path, "rb");
-    if(!f) return false;
-    if(fseek(f, 0, SEEK_END) != 0){ fclose(f); return false; }
-    long szl = ftell(f);
-    if(szl < 0){ fclose(f); return false; }
-    size_t sz = (size_t)szl;
-    if(fseek(f, 0, SEEK_SET) != 0){ fclose(f); return false; }
-
-    char *data = (char*)malloc(sz + 1);
-    if(!data){ fclose(f); errno = ENOMEM; return false; }
-    size_t n = fread(data, 1, sz, f);
-    fclose(f);
-    if(n != sz){ free(data); return false; }
-    data[sz] = '\0';
-
-    // Replace existing buffer
-    free(b->data);
-    b->data = data;
-    b->len  = sz;
-    b->cap  = sz + 1;
+    fs_view_t v;
+    if(!fs_view_open(&v, path)) return false;
+
+    // Replace existing buffer; the view's storage becomes the original store
+    buf_free(b);
+    b->orig = v.data;
+    b->orig_len = v.len;
+    b->orig_mapped = v.mapped;
+    if(!orig_index_grow(b, 0)){
+        buf_free(b);
+        errno = ENOMEM;
+        return false;
+    }
+    // Nothing is read yet: the whole original starts as the unindexed tail
+    b->orig_tail = 0;
+    b->len = v.len;
+    return true;
+}
+
+static bool write_all(FILE *f, const buffer_t *b){
+    size_t pos = 0, n = 0;
+    const char *p = NULL;
+    while(pos < b->len && (n = buf_chunk(b, pos, &p)) > 0){
+        if(fwrite(p, 1, n, f) != n) break;
+        pos += n;
+    }
+    return pos == b->len;
+}
+
+// Copy a mapped original onto the heap so its file can be rewritten in place.
+static bool orig_detach(buffer_t *b){
+    char *copy = (char*)malloc(b->orig_len + 1);
+    if(!copy){ errno = ENOMEM; return false; }
+    memcpy(copy, b->orig, b->orig_len);
+    copy[b->orig_len] = '\0';
+    fs_view_t v = { b->orig, b->orig_len, true };
+    fs_view_close(&v);
+    b->orig = copy;
+    b->orig_mapped = false;
     return true;
 }
 
 bool buf_save_file(buffer_t *b, const char *path){
-    FILE *f = fopen(path, "wb");
-    if(!f) return false;
-    size_t n = fwrite(b->data, 1, b->len, f);
-    int err = ferror(f);
-    fclose(f);
-    return (err == 0 && n == b->len);
+    // A hard-linked file must keep its inode: drop the mapping, write in place
+    struct stat st;
+    bool exists = stat(path, &st) == 0;
+    if(b->orig_mapped && exists && st.st_nlink > 1 && !orig_detach(b)) return false;
+
+    if(!b->orig_mapped){
+        FILE *f = fopen(path, "wb");
+        if(!f) return false;
+        bool ok = write_all(f, b);
+        int err = ferror(f);
+        if(fclose(f) != 0) err = 1;
+        return ok && err == 0;
+    }
+
+    // The original is mapped from a file (possibly this one): truncating it in
+    // place would pull the pages out from under us, so write aside and rename.
+    // Rename over the symlink's target, not the link, and keep owner and mode.
+    char real[PATH_MAX];
+    const char *target = (exists && realpath(path, real)) ? real : path;
+    char *tmp = NULL;
+    if(asprintf(&tmp, "%s.idy-save-XXXXXX", target) < 0) return false;
+    int fd = mkstemp(tmp);
+    if(fd < 0){ free(tmp); return false; }
+    if(exists){
+        if(fchown(fd, st.st_uid, st.st_gid) != 0){ /* not ours to give away: keep ours */ }
+        fchmod(fd, st.st_mode & 07777);
+    }
+    FILE *f = fdopen(fd, "wb");
+    if(!f){ close(fd); unlink(tmp); free(tmp); return false; }
+    bool ok = write_all(f, b);
+    if(ferror(f)) ok = false;
+    if(fclose(f) != 0) ok = false;
+    if(ok && rename(tmp, target) != 0) ok = false;
+    if(!ok) unlink(tmp);
+    free(tmp);
+    return ok;
+}
+
+/* ---------------- edits ---------------- */
+
+static bool add_append(buffer_t *b, const char *s, size_t n){
+    if(b->add_len + n > b->add_cap){
+        size_t cap = b->add_cap ? b->add_cap * 2 : 4096;
+        while(cap < b->add_len + n) cap *= 2;
+        char *p = (char*)realloc(b->add, cap);
+        if(!p) return false;
+        b->add = p; b->add_cap = cap;
+    }
+    size_t nl_n0 = b->add_nl_n;
+    if(!nl_index_append(&b->add_nl, &b->add_nl_n, &b->add_nl_cap, s, n, b->add_len)){
+        b->add_nl_n = nl_n0;
+        return false;
+    }
+    memcpy(b->add + b->add_len, s, n);
+    b->add_len += n;
+    return true;
+}
+
+void buf_insert(buffer_t *b, size_t pos, const char *s, size_t n){
+    if(!s || n == 0) return;
+    if(pos > b->len) pos = b->len;
+    if(!orig_extend(b, pos)) return;
+    size_t add_off = b->add_len;
+    if(!add_append(b, s, n)) return;
+
+    // Typing appends right after the previous insertion: grow that piece
+    // instead of adding one piece per keystroke.
+    size_t start = 0;
+    const buf_node_t *prev = (pos > 0) ? node_find(b->root, pos - 1, &start) : NULL;
+    if(prev && prev->src == SRC_ADD && start + prev->len == pos && prev->off + prev->len == add_off){
+        b->root = node_grow(b->root, pos - 1, n, piece_lf(b, SRC_ADD, add_off, n));
+    } else {
+        buf_node_t *piece = node_new(b, SRC_ADD, add_off, n);
+        if(!piece) return;
+        buf_node_t *l, *r;
+        node_split(b, b->root, pos, &l, &r);
+        b->root = node_merge(node_merge(l, piece), r);
+    }
+    b->len += n;
+    b->flat_ok = false;
+}
+
+void buf_delete(buffer_t *b, size_t a, size_t e){
+    if(a > e){ size_t t = a; a = e; e = t; }
+    if(e > b->len) e = b->len;
+    if(a >= e) return;
+    if(!orig_extend(b, e)) return;
+    buf_node_t *l, *m, *r;
+    node_split(b, b->root, a, &l, &m);
+    node_split(b, m, e - a, &m, &r);
+    node_release(m);
+    b->root = node_merge(l, r);
+    b->len -= (e - a);
+    b->flat_ok = false;
+}
+
+void buf_replace_all(buffer_t *b, const char *s, size_t n){
+    size_t add_off = b->add_len;
+    if(n && !add_append(b, s, n)) return;
+    node_release(b->root);
+    b->root = n ? node_new(b, SRC_ADD, add_off, n) : NULL;
+    b->len = b->root ? n : 0;
+    b->orig_tail = b->orig_len;
+    b->flat_ok = false;
+}
+
+/* ---------------- reads ---------------- */
+
+size_t buf_chunk(const buffer_t *b, size_t pos, const char **out){
+    size_t tree = node_sum(b->root);
+    if(pos >= tree){
+        // The unindexed tail is contiguous in the original
+        size_t k = pos - tree;
+        if(k >= tail_len(b)){ *out = NULL; return 0; }
+        *out = b->orig + b->orig_tail + k;
+        return tail_len(b) - k;
+    }
+    const buf_node_t *t = b->root;
+    while(t){
+        size_t ls = node_sum(t->l);
+        if(pos < ls){ t = t->l; continue; }
+        pos -= ls;
+        if(pos < t->len){
+            *out = piece_base(b, t) + t->off + pos;
+            return t->len - pos;
+        }
+        pos -= t->len;
+        t = t->r;
+    }
+    *out = NULL;
+    return 0;
+}
+
+int buf_char_at(const buffer_t *b, size_t pos){
+    const char *p = NULL;
+    if(buf_chunk(b, pos, &p) == 0) return -1;
+    return (unsigned char)*p;
+}
+
+size_t buf_copy(const buffer_t *b, size_t a, size_t e, char *dst){
+    if(e > b->len) e = b->len;
+    size_t w = 0;
+    while(a < e){
+        const char *p = NULL;
+        size_t n = buf_chunk(b, a, &p);
+        if(n == 0) break;
+        if(n > e - a) n = e - a;
+        memcpy(dst + w, p, n);
+        w += n; a += n;
+    }
+    return w;
+}
+
+char* buf_strndup(const buffer_t *b, size_t a, size_t e){
+    if(e > b->len) e = b->len;
+    if(a > e) a = e;
+    char *s = (char*)malloc(e - a + 1);
+    if(!s) return NULL;
+    size_t n = buf_copy(b, a, e, s);
+    s[n] = '\0';
+    return s;
+}
+
+const char* buf_data(buffer_t *b){
+    if(b->flat_ok && b->flat) return b->flat;
+    char *p = (char*)realloc(b->flat, b->len + 1);
+    if(!p) return "";
+    b->flat = p;
+    size_t n = buf_copy(b, 0, b->len, b->flat);
+    b->flat[n] = '\0';
+    b->flat_ok = true;
+    return b->flat;
+}
+
+/* ---------------- line index ---------------- */
+
+size_t buf_line_count(const buffer_t *b){
+    orig_extend(b, b->len);
+    return node_lf_sum(b->root) + 1;
+}
+
+size_t buf_line_count_known(const buffer_t *b){
+    return node_lf_sum(b->root) + 1;
+}
+
+bool buf_has_row(const buffer_t *b, size_t row){
+    orig_extend_rows(b, row);
+    return row <= node_lf_sum(b->root);
+}
+
+size_t buf_line_of(const buffer_t *b, size_t pos){
+    if(pos > b->len) pos = b->len;
+    orig_extend(b, pos);
+    size_t row = 0;
+    const buf_node_t *t = b->root;
+    while(t){
+        size_t ls = node_sum(t->l);
+        if(pos < ls){ t = t->l; continue; }
+        row += node_lf_sum(t->l);
+        pos -= ls;
+        if(pos <= t->len){
+            row += piece_lf(b, t->src, t->off, pos);
+            break;
+        }
+        row += t->lf;
+        pos -= t->len;
+        t = t->r;
+    }
+    return row;
+}
+
+size_t buf_line_start(const buffer_t *b, size_t row){
+    if(row == 0) return 0;
+    orig_extend_rows(b, row);
+    if(row > node_lf_sum(b->root)) return b->len;
+    // Locate the row-th newline (1-based) and return the offset after it
+    size_t base = 0;
+    const buf_node_t *t = b->root;
+    while(t){
+        size_t llf = node_lf_sum(t->l);
+        if(row <= llf){ t = t->l; continue; }
+        row  -= llf;
+        base += node_sum(t->l);
+        if(row <= t->lf){
+            size_t nl = piece_nl_at(b, t->src, t->off, row);
+            return base + (nl - t->off) + 1;
+        }
+        row  -= t->lf;
+        base += t->len;
+        t = t->r;
+    }
+    return b->len;
+}
+
+/* ---------------- snapshots ---------------- */
+
+buf_snap_t buf_snapshot(const buffer_t *b){
+    buf_snap_t s = { node_retain(b->root), b->len, b->orig_tail };
+    return s;
+}
+
+void buf_restore(buffer_t *b, const buf_snap_t *s){
+    buf_node_t *old = b->root;
+    b->root = node_retain(s->root);
+    b->len = s->len;
+    b->orig_tail = s->orig_tail; // the original is immutable, so its tail is too
+    node_release(old);
+    b->flat_ok = false;
+}
+
+void buf_snap_release(buf_snap_t *s){
+    if(!s) return;
+    node_release(s->root);
+    s->root = NULL;
+    s->len = 0;
+    s->orig_tail = 0;
 }
@@ -5,19 +5,9 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <ctype.h>
+#include <stdint.h>
 
 // -------------------- small helpers --------------------
-static char* xmalloc(size_t n) {
-    char *p = (char*)malloc(n);
-    return p;
-}
-static char* xstrdup(const char *s){
-    size_t n = strlen(s);
-    char *p = (char*)malloc(n+1);
-    if (!p) return NULL;
-    memcpy(p, s, n+1);
-    return p;
-}
 static char* xstrndup(const char *s, size_t n){
     char *p = (char*)malloc(n+1);
     if (!p) return NULL;
@@ -38,56 +28,30 @@ static void set_err(char **errmsg, const char *fmt, ...) {
     va_end(ap);
     *errmsg = buf;
 }
-static size_t linelen_no_eol(const char *s){
-    size_t L = strlen(s);
-    if (L && s[L-1] == '\n') { L--; }
-    if (L && s[L-1] == '\r') { L--; }
-    return L;
-}
-
-// -------------------- line splitting --------------------
-typedef struct { char **v; size_t n, cap; } lines_t;
 
-static void lines_init(lines_t *L) { L->v=NULL; L->n=0; L->cap=0; }
-static void lines_push(lines_t *L, char *line){
-    if (L->n == L->cap){
-        size_t newcap = L->cap ? L->cap*2 : 128;
-        char **nv = (char**)realloc(L->v, newcap*sizeof(char*));
-        if (!nv) return; // let it crash later if OOM
-        L->v = nv; L->cap = newcap;
-    }
-    L->v[L->n++] = line;
+// -------------------- original line cursor --------------------
+// The original is never split or copied line by line. Lines are visited in
+// order as spans [p, line_end) that include their '\n' (the last line may
+// lack one), and untouched runs are copied to the output in one memcpy.
+typedef struct {
+    const char *p;    // start of the current line
+    const char *end;  // end of the original
+    size_t idx;       // 0-based index of the current line
+} ocur_t;
+
+static const char* line_end(const char *p, const char *end){
+    const char *nl = (const char*)memchr(p, '\n', (size_t)(end - p));
+    return nl ? nl + 1 : end;
 }
-static lines_t split_lines(const char *s){
-    lines_t L; lines_init(&L);
-    const char *p = s, *q = s;
-    while (*q){
-        if (*q == '\n'){
-            size_t len = (size_t)(q - p);
-            char *ln = (char*)malloc(len + 2);
-            if (!ln) return L;
-            memcpy(ln, p, len);
-            ln[len] = '\n';
-            ln[len+1] = '\0';
-            lines_push(&L, ln);
-            p = q + 1;
-        }
-        q++;
-    }
-    if (q != p){
-        size_t len = (size_t)(q - p);
-        char *ln = (char*)malloc(len + 1);
-        if (!ln) return L;
-        memcpy(ln, p, len);
-        ln[len] = '\0';
-        lines_push(&L, ln);
-    }
-    return L;
+static void ocur_next(ocur_t *c){
+    c->p = line_end(c->p, c->end);
+    c->idx++;
 }
-static void free_lines(lines_t *L){
-    for (size_t i=0;i<L->n;i++) free(L->v[i]);
-    free(L->v);
-    L->v=NULL; L->n=L->cap=0;
+static size_t span_len_no_eol(const char *p, const char *e){
+    size_t L = (size_t)(e - p);
+    if (L && p[L-1] == '\n') { L--; }
+    if (L && p[L-1] == '\r') { L--; }
+    return L;
 }
 
 // -------------------- unified diff parsing --------------------
@@ -161,43 +125,175 @@ done:
     return ok;
 }
 
+// Patch text of a context/deletion line without a CR left over from CRLF input.
+static size_t patch_len_no_cr(const char *txt, size_t len){
+    return (len && txt[len-1] == '\r') ? len - 1 : len;
+}
+
 // Compare a patch line's text (no trailing newline in `patch_txt_len`) with
-// an original line. Comparison ignores original's trailing '\n' or '\r\n'.
+// the original line at the cursor. Comparison ignores trailing '\n' or '\r\n' on both.
 static int patch_matches_orig(const char *patch_txt, size_t patch_txt_len,
-                              const char *orig_line)
+                              const ocur_t *c)
 {
-    size_t oln = linelen_no_eol(orig_line);
+    patch_txt_len = patch_len_no_cr(patch_txt, patch_txt_len);
+    size_t oln = span_len_no_eol(c->p, line_end(c->p, c->end));
     if (oln != patch_txt_len) return 0;
-    return (memcmp(orig_line, patch_txt, patch_txt_len) == 0);
+    return (memcmp(c->p, patch_txt, patch_txt_len) == 0);
+}
+
+// -------------------- fuzzy hunk relocation --------------------
+// Every original line is hashed once and chained into a hash table, so the
+// candidate starts for a hunk are the occurrences of its rarest old-side line.
+
+typedef struct { const char *p; size_t len; uint64_t h; } oline_t; // len excludes EOL
+typedef struct { const char *txt; size_t len; uint64_t h; } pline_t;
+
+typedef struct {
+    oline_t *v; size_t n;
+    size_t *head, *next; size_t mask;   // chains of line indexes per hash bucket
+} line_index_t;
+
+static uint64_t hash_line(const char *s, size_t n){
+    uint64_t h = 1469598103934665603ULL;    // FNV-1a
+    for (size_t i = 0; i < n; i++){ h ^= (unsigned char)s[i]; h *= 1099511628211ULL; }
+    return h;
+}
+
+static void line_index_free(line_index_t *X){
+    free(X->v); free(X->head); free(X->next);
+    memset(X, 0, sizeof(*X));
+}
+
+static bool line_index_build(line_index_t *X, const char *orig, const char *end){
+    memset(X, 0, sizeof(*X));
+    size_t cap = 0;
+    for (const char *p = orig; p < end; p = line_end(p, end)) cap++;
+    size_t nb = 16; while (nb < cap * 2) nb *= 2;
+    X->v = (oline_t*)malloc((cap ? cap : 1) * sizeof(oline_t));
+    X->next = (size_t*)malloc((cap ? cap : 1) * sizeof(size_t));
+    X->head = (size_t*)malloc(nb * sizeof(size_t));
+    if (!X->v || !X->next || !X->head){ line_index_free(X); return false; }
+    X->mask = nb - 1;
+    for (size_t i = 0; i < nb; i++) X->head[i] = SIZE_MAX;
+    for (const char *p = orig; p < end; ){
+        const char *e = line_end(p, end);
+        oline_t *L = &X->v[X->n];
+        L->p = p; L->len = span_len_no_eol(p, e); L->h = hash_line(p, L->len);
+        size_t b = (size_t)L->h & X->mask;
+        X->next[X->n] = X->head[b]; X->head[b] = X->n;
+        X->n++;
+        p = e;
+    }
+    return true;
+}
+
+static bool pline_eq(const line_index_t *X, size_t i, const pline_t *q){
+    const oline_t *L = &X->v[i];
+    return L->h == q->h && L->len == q->len && memcmp(L->p, q->txt, q->len) == 0;
+}
+
+static bool seq_matches_at(const line_index_t *X, size_t at, const pline_t *seq, size_t m){
+    if (at + m > X->n) return false;
+    for (size_t k = 0; k < m; k++) if (!pline_eq(X, at + k, &seq[k])) return false;
+    return true;
+}
+
+// Old-side (context + deletion) lines of one hunk body.
+static size_t collect_old_side(const char *bp, const char *bend, pline_t **seq, size_t *cap){
+    size_t m = 0;
+    while (bp < bend){
+        const char *nl = memchr(bp, '\n', (size_t)(bend - bp));
+        size_t linelen = nl ? (size_t)(nl - bp) : (size_t)(bend - bp);
+        if (linelen >= 1 && (*bp == ' ' || *bp == '-')){
+            if (m == *cap){
+                size_t nc = *cap ? *cap * 2 : 64;
+                pline_t *nv = (pline_t*)realloc(*seq, nc * sizeof(pline_t));
+                if (!nv) return m;
+                *seq = nv; *cap = nc;
+            }
+            pline_t *q = &(*seq)[m++];
+            q->txt = bp + 1; q->len = patch_len_no_cr(q->txt, linelen - 1); q->h = hash_line(q->txt, q->len);
+        }
+        bp = nl ? nl + 1 : bend;
+    }
+    return m;
+}
+
+// Nearest start >= min_at (and within window of target) where seq matches.
+// Returns 1 and *found on a unique nearest match, 0 if none, -1 if ambiguous.
+static int locate_hunk(const line_index_t *X, const pline_t *seq, size_t m,
+                       size_t min_at, size_t target, long window, size_t *found)
+{
+    // Anchor on the rarest line of the sequence to keep the candidate list short
+    size_t anchor = 0, best_cnt = SIZE_MAX;
+    for (size_t k = 0; k < m && best_cnt > 1; k++){
+        size_t cnt = 0;
+        for (size_t i = X->head[(size_t)seq[k].h & X->mask]; i != SIZE_MAX && cnt < best_cnt; i = X->next[i])
+            if (pline_eq(X, i, &seq[k])) cnt++;
+        if (cnt < best_cnt){ best_cnt = cnt; anchor = k; }
+    }
+    if (best_cnt == 0) return 0;
+
+    size_t best_dist = SIZE_MAX; int ties = 0;
+    for (size_t i = X->head[(size_t)seq[anchor].h & X->mask]; i != SIZE_MAX; i = X->next[i]){
+        if (i < anchor) continue;
+        size_t at = i - anchor;
+        if (at < min_at) continue;
+        size_t dist = at > target ? at - target : target - at;
+        if (window > 0 && dist > (size_t)window) continue;
+        if (dist > best_dist || !seq_matches_at(X, at, seq, m)) continue;
+        if (dist < best_dist){ best_dist = dist; *found = at; ties = 1; }
+        else if (at != *found) ties++;
+    }
+    if (best_dist == SIZE_MAX) return 0;
+    return ties == 1 ? 1 : -1;
 }
 
 bool apply_unified_diff(const char *orig, const char *diff,
                         char **out, char **errmsg)
+{
+    return apply_unified_diff_opts(orig, diff, NULL, out, errmsg);
+}
+
+bool apply_unified_diff_opts(const char *orig, const char *diff, diff_apply_opts_t *opts,
+                             char **out, char **errmsg)
+{
+    return apply_unified_diff_n(orig, orig ? strlen(orig) : 0, diff, opts, out, errmsg);
+}
+
+bool apply_unified_diff_n(const char *orig, size_t orig_len, const char *diff,
+                          diff_apply_opts_t *opts, char **out, char **errmsg)
 {
     if (errmsg) *errmsg = NULL;
+    if (opts) opts->relocated = 0;
     if (!orig || !diff || !out){
         set_err(errmsg, "Invalid arguments");
         return false;
     }
 
-    lines_t O = split_lines(orig);
-
-    // Prepare output line buffer
-    size_t cap = (O.n ? O.n : 1) + 16;
-    char **OV = (char**)malloc(cap * sizeof(char*));
-    size_t on = 0;
-    size_t oidx = 0; // current index in original
-
     // Find the first hunk; ignore any '---/+++' headers above it
     const char *cur = find_next_hunk(diff);
     if (!cur){
         // No hunks → empty diff → output equals input
-        *out = xstrdup(orig);
-        free_lines(&O);
-        free(OV);
+        *out = xstrndup(orig, orig_len);
         return true;
     }
 
+    size_t diff_len = strlen(diff);
+    ocur_t oc = { orig, orig + orig_len, 0 };
+
+    // Output never exceeds the original plus the diff text (every emitted '+'
+    // line is no longer than its diff line), so one allocation suffices.
+    char *res = (char*)malloc(orig_len + diff_len + 2);
+    if (!res){ set_err(errmsg, "Out of memory"); return false; }
+    char *w = res;
+    const char *pending = orig; // original bytes [pending, oc.p) still to be copied
+
+    bool fuzzy = opts && opts->fuzzy;
+    line_index_t X; memset(&X, 0, sizeof(X));
+    pline_t *seq = NULL; size_t seq_cap = 0;
+    if (fuzzy && !line_index_build(&X, oc.p, oc.end)) fuzzy = false; // OOM: strict is still correct
+
     while (cur){
         // Header line
         const char *hdr_eol = strchr(cur, '\n');
@@ -209,24 +305,42 @@ bool apply_unified_diff(const char *orig, const char *diff,
             goto fail;
         }
 
-        // Convert 1-based line number to 0-based index
-        long target = (o_start > 0) ? (o_start - 1) : 0;
-
-        // Copy unchanged original lines up to the hunk start
-        while ((long)oidx < target && oidx < O.n){
-            if (on == cap){ cap *= 2; OV = (char**)realloc(OV, cap*sizeof(char*)); }
-            OV[on++] = xstrdup(O.v[oidx++]);
-        }
+        // Convert 1-based line number to 0-based index. A hunk with no old lines
+        // ("-N,0") inserts after line N, i.e. before index N.
+        long target = (o_len == 0) ? o_start : ((o_start > 0) ? (o_start - 1) : 0);
 
         // Hunk body is from after_hdr up to (but not including) the next header
         const char *next_hdr = find_next_hunk(after_hdr);
-        const char *bend = next_hdr ? next_hdr : (diff + strlen(diff));
+        const char *bend = next_hdr ? next_hdr : (diff + diff_len);
+
+        if (fuzzy){
+            // Where strict application would start, then the nearest place the old side really is
+            size_t at = (size_t)target;
+            if (at < oc.idx) at = oc.idx;
+            if (at > X.n) at = X.n;
+            size_t m = collect_old_side(after_hdr, bend, &seq, &seq_cap);
+            size_t found = at;
+            if (m && !seq_matches_at(&X, at, seq, m)){
+                int r = locate_hunk(&X, seq, m, oc.idx, at, opts->window, &found);
+                if (r < 0){
+                    set_err(errmsg, "Ambiguous hunk location near original line %ld", o_start);
+                    goto fail;
+                }
+                if (r > 0){
+                    target = (long)found;
+                    opts->relocated++;
+                }
+                // r == 0: nothing matches; strict application below reports the mismatch
+            }
+        }
+
+        // Unchanged original lines up to the hunk start stay pending
+        while ((long)oc.idx < target && oc.p < oc.end) ocur_next(&oc);
 
         const char *bp = after_hdr;
         while (bp < bend){
             const char *nl = memchr(bp, '\n', (size_t)(bend - bp));
             size_t linelen = nl ? (size_t)(nl - bp) : (size_t)(bend - bp);
-            if (linelen == 0 && bp == bend) break;
 
             char tag = *bp;
             const char *txt = bp + 1;
@@ -240,10 +354,10 @@ bool apply_unified_diff(const char *orig, const char *diff,
             if ((tag == '+' || tag == '-') && n2 < bend){
                 const char *n2nl = memchr(n2, '\n', (size_t)(bend - n2));
                 size_t n2len = n2nl ? (size_t)(n2nl - n2) : (size_t)(bend - n2);
-                if (n2len >= 28 && n2[0] == '\\' && n2[1] == ' '){
-                    static const char *MARK = "No newline at end of file";
-                    if (n2len >= 2 + strlen(MARK) &&
-                        memcmp(n2+2, MARK, strlen(MARK)) == 0){
+                if (n2len >= 2 && n2[0] == '\\' && n2[1] == ' '){
+                    static const char MARK[] = "No newline at end of file";
+                    if (n2len >= 2 + sizeof(MARK) - 1 &&
+                        memcmp(n2+2, MARK, sizeof(MARK) - 1) == 0){
                         add_newline = 0;
                         // we will also skip this marker line by advancing bp past it
                         // after processing the current '+'/'-' line
@@ -252,39 +366,35 @@ bool apply_unified_diff(const char *orig, const char *diff,
             }
 
             if (tag == ' '){
-                // Context: must match original
-                if (oidx >= O.n){
-                    set_err(errmsg, "Context beyond EOF at original line %zu", oidx+1);
+                // Context: must match original; it stays in the pending run
+                if (oc.p >= oc.end){
+                    set_err(errmsg, "Context beyond EOF at original line %zu", oc.idx+1);
                     goto fail;
                 }
-                if (!patch_matches_orig(txt, txtlen, O.v[oidx])){
-                    set_err(errmsg, "Context mismatch at original line %zu", oidx+1);
+                if (!patch_matches_orig(txt, txtlen, &oc)){
+                    set_err(errmsg, "Context mismatch at original line %zu", oc.idx+1);
                     goto fail;
                 }
-                if (on == cap){ cap *= 2; OV = (char**)realloc(OV, cap*sizeof(char*)); }
-                OV[on++] = xstrdup(O.v[oidx]);
-                oidx++;
+                ocur_next(&oc);
             } else if (tag == '-'){
-                // Deletion: must match original, but do not emit
-                if (oidx >= O.n){
-                    set_err(errmsg, "Delete beyond EOF at original line %zu", oidx+1);
+                // Deletion: must match original; flush what precedes it, then skip it
+                if (oc.p >= oc.end){
+                    set_err(errmsg, "Delete beyond EOF at original line %zu", oc.idx+1);
                     goto fail;
                 }
-                if (!patch_matches_orig(txt, txtlen, O.v[oidx])){
-                    set_err(errmsg, "Delete mismatch at original line %zu", oidx+1);
+                if (!patch_matches_orig(txt, txtlen, &oc)){
+                    set_err(errmsg, "Delete mismatch at original line %zu", oc.idx+1);
                     goto fail;
                 }
-                oidx++;
+                memcpy(w, pending, (size_t)(oc.p - pending)); w += oc.p - pending;
+                ocur_next(&oc);
+                pending = oc.p;
             } else if (tag == '+'){
-                // Insertion: write new text (+ optional newline)
-                size_t outlen = txtlen + (add_newline ? 1 : 0);
-                char *ins = (char*)malloc(outlen + 1);
-                if (!ins){ set_err(errmsg, "Out of memory"); goto fail; }
-                memcpy(ins, txt, txtlen);
-                if (add_newline) ins[txtlen] = '\n';
-                ins[outlen] = '\0';
-                if (on == cap){ cap *= 2; OV = (char**)realloc(OV, cap*sizeof(char*)); }
-                OV[on++] = ins;
+                // Insertion: write new text (+ optional newline) after the pending run
+                memcpy(w, pending, (size_t)(oc.p - pending)); w += oc.p - pending;
+                pending = oc.p;
+                memcpy(w, txt, txtlen); w += txtlen;
+                if (add_newline) *w++ = '\n';
             } else if (tag == '\\'){
                 // "\ No newline at end of file" — already handled via look-ahead; skip
             } else {
@@ -307,36 +417,17 @@ bool apply_unified_diff(const char *orig, const char *diff,
         cur = next_hdr;
     }
 
-    // Copy any remaining original lines after the last hunk
-    while (oidx < O.n){
-        if (on == cap){ cap *= 2; OV = (char**)realloc(OV, cap*sizeof(char*)); }
-        OV[on++] = xstrdup(O.v[oidx++]);
-    }
-
-    // Concatenate output lines
-    size_t total = 0;
-    for (size_t i=0;i<on;i++) total += strlen(OV[i]);
-    char *res = (char*)malloc(total + 1);
-    if (!res){ set_err(errmsg, "Out of memory"); goto fail; }
-    char *w = res;
-    for (size_t i=0;i<on;i++){
-        size_t L = strlen(OV[i]);
-        memcpy(w, OV[i], L);
-        w += L;
-    }
+    // Copy any remaining original text after the last hunk
+    memcpy(w, pending, (size_t)(oc.end - pending)); w += oc.end - pending;
     *w = '\0';
     *out = res;
-
-    for (size_t i=0;i<on;i++) free(OV[i]);
-    free(OV);
-    free_lines(&O);
+    line_index_free(&X);
+    free(seq);
     return true;
 
 fail:
-    if (OV){
-        for (size_t i=0;i<on;i++) free(OV[i]);
-        free(OV);
-    }
-    free_lines(&O);
+    free(res);
+    line_index_free(&X);
+    free(seq);
     return false;
 }
@@ -0,0 +1,429 @@
+#include "diff.h"
+#include "fsutil.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+
+/* ========= Multi-file patches =========
+
+   A patch set is a sequence of "--- old / +++ new" file sections, each with
+   its own hunks. Sections are first grouped by the file they touch (several
+   sections for one file apply in order, one after the other). Then:
+     1) every file is read, patched and written to a temp file next to its
+        target, on a small thread pool (files are independent);
+     2) only if all of them succeeded are the temp files renamed into place,
+        in order. A failing rename rolls the already-committed files back
+        from the originals still held in memory.
+*/
+
+// -------------------- small helpers --------------------
+static char* xstrndup(const char *s, size_t n){
+    char *p = (char*)malloc(n+1);
+    if (!p) return NULL;
+    memcpy(p, s, n);
+    p[n] = '\0';
+    return p;
+}
+static void set_err(char **errmsg, const char *fmt, ...) {
+    if (!errmsg) return;
+    va_list ap; va_start(ap, fmt);
+    char *buf = NULL;
+    if (vasprintf(&buf, fmt, ap) < 0) buf = NULL;
+    va_end(ap);
+    free(*errmsg);
+    *errmsg = buf;
+}
+static const char* next_line(const char *p){
+    const char *nl = strchr(p, '\n');
+    return nl ? nl + 1 : p + strlen(p);
+}
+
+// Path from a "--- " / "+++ " line: stop at tab (timestamps) or EOL, drop git's a/ b/.
+static char* header_path(const char *p){
+    const char *e = p;
+    while (*e && *e != '\n' && *e != '\t') e++;
+    while (e > p && (e[-1] == '\r' || e[-1] == ' ')) e--;
+    if (e - p >= 2 && (p[0] == 'a' || p[0] == 'b') && p[1] == '/') p += 2;
+    return xstrndup(p, (size_t)(e - p));
+}
+
+static bool is_section_start(const char *p){
+    if (strncmp(p, "--- ", 4) != 0) return false;
+    const char *n = next_line(p);
+    return n[0] == '+' && n[1] == '+' && n[2] == '+' && n[3] == ' ';
+}
+
+// Old/new line counts of a "@@ -a[,b] +c[,d] @@" header; false if malformed.
+static bool hunk_counts(const char *p, long *old_n, long *new_n){
+    if (strncmp(p, "@@ -", 4) != 0) return false;
+    char *e;
+    p += 4; strtol(p, &e, 10);
+    if (e == p) return false;
+    *old_n = 1;
+    if (*e == ','){ p = e + 1; *old_n = strtol(p, &e, 10); if (e == p) return false; }
+    if (strncmp(e, " +", 2) != 0) return false;
+    p = e + 2; strtol(p, &e, 10);
+    if (e == p) return false;
+    *new_n = 1;
+    if (*e == ','){ p = e + 1; *new_n = strtol(p, &e, 10); if (e == p) return false; }
+    return strncmp(e, " @@", 3) == 0;
+}
+
+// -------------------- parsing --------------------
+
+void patch_set_free(patch_set_t *ps){
+    if (!ps) return;
+    for (size_t i = 0; i < ps->count; i++){
+        free(ps->files[i].old_path);
+        free(ps->files[i].new_path);
+        free(ps->files[i].body);
+    }
+    free(ps->files);
+    ps->files = NULL; ps->count = 0;
+}
+
+bool patch_set_parse(const char *diff, patch_set_t *out, char **errmsg){
+    out->files = NULL; out->count = 0;
+    if (errmsg) *errmsg = NULL;
+    if (!diff){ set_err(errmsg, "Invalid arguments"); return false; }
+    size_t cap = 0;
+
+    const char *p = diff;
+    while (*p){
+        if (!is_section_start(p)){ p = next_line(p); continue; }
+        const char *plus = next_line(p);
+        const char *body = next_line(plus);
+
+        // Body runs to the next section (or a "diff ..." preamble line) at line
+        // start. Inside a hunk its header counts decide where it ends, so a
+        // removed "-- x" or added "++ y" line is not taken for a file header.
+        const char *e = body;
+        long old_left = 0, new_left = 0;
+        while (*e && strncmp(e, "diff ", 5) != 0){
+            if (strncmp(e, "@@", 2) == 0){
+                if (!hunk_counts(e, &old_left, &new_left)) old_left = new_left = 0;
+            } else if (old_left > 0 || new_left > 0){
+                if (*e == '-') old_left--;
+                else if (*e == '+') new_left--;
+                else if (*e != '\\'){ old_left--; new_left--; } // context (a blank line too)
+            } else if (is_section_start(e)){
+                break;
+            }
+            e = next_line(e);
+        }
+
+        if (out->count == cap){
+            size_t nc = cap ? cap * 2 : 8;
+            patch_file_t *nv = (patch_file_t*)realloc(out->files, nc * sizeof(patch_file_t));
+            if (!nv){ set_err(errmsg, "Out of memory"); patch_set_free(out); return false; }
+            out->files = nv; cap = nc;
+        }
+        patch_file_t *f = &out->files[out->count++];
+        memset(f, 0, sizeof(*f));
+        f->old_path = header_path(p + 4);
+        f->new_path = header_path(plus + 4);
+        f->body = xstrndup(body, (size_t)(e - body));
+        if (!f->old_path || !f->new_path || !f->body){
+            set_err(errmsg, "Out of memory"); patch_set_free(out); return false;
+        }
+        p = e;
+    }
+    return true;
+}
+
+// -------------------- apply: resolving targets --------------------
+
+// One file on disk and every section that touches it, applied in patch order.
+typedef struct {
+    const patch_file_t **pf;
+    size_t npf;
+    const char *label;   // path as the patch spells it, for messages
+    char *target;        // resolved path written (the new name of a rename)
+    char *source;        // resolved old name when the section renames, else NULL
+    fs_view_t orig;      // original contents (kept until commit finishes, for rollback)
+    bool has_orig;       // file existed before the patch
+    bool writes;         // file exists after the patch: tmp goes over target
+    bool deletes;        // file existed and is gone after the patch
+    char *tmp;           // patched contents, ready to rename over target
+    mode_t mode;
+    char *err;
+    int relocated;
+} job_t;
+
+typedef struct {
+    job_t *jobs; size_t n;
+    const diff_apply_opts_t *opts;
+    mode_t new_mode;     // for created files: 0666 less the umask
+    atomic_size_t next;
+} pool_t;
+
+static bool is_dev_null(const char *p){ return strcmp(p, "/dev/null") == 0; }
+
+// Join root and a patch path. The text may not climb out of root ("..", empty
+// components, an absolute path elsewhere), the directory it lands in must still
+// be under real_root (root with symlinks resolved) once its own symlinks are
+// resolved, and the file itself may not be a symlink.
+static char* resolve_under(const char *root, const char *real_root, const char *path, char **err){
+    size_t rl = strlen(root);
+    while (rl > 1 && root[rl-1] == '/') rl--;
+    const char *rel = path;
+    if (path[0] == '/'){
+        if (strncmp(path, root, rl) != 0 || path[rl] != '/') goto outside;
+        rel = path + rl + 1;
+    }
+    if (!*rel) goto outside;
+    for (const char *s = rel; *s; ){
+        const char *e = strchr(s, '/'); size_t n = e ? (size_t)(e - s) : strlen(s);
+        if ((n == 2 && s[0] == '.' && s[1] == '.') || n == 0) goto outside;
+        s += n; if (*s == '/') s++;
+    }
+    char *full = NULL;
+    if (asprintf(&full, "%.*s/%s", (int)rl, root, rel) < 0){ set_err(err, "Out of memory"); return NULL; }
+
+    char *slash = strrchr(full, '/');
+    char *dir = slash == full ? xstrndup("/", 1) : xstrndup(full, (size_t)(slash - full));
+    char real[PATH_MAX];
+    bool resolved = dir && realpath(dir, real);
+    int e = errno;
+    free(dir);
+    if (!resolved){ set_err(err, "%s: %s", path, strerror(e)); free(full); return NULL; }
+    size_t rr = strlen(real_root);
+    if (rr > 1 && (strncmp(real, real_root, rr) != 0 || (real[rr] != '/' && real[rr] != '\0'))){
+        free(full); goto outside;
+    }
+    struct stat st;
+    if (lstat(full, &st) == 0 && S_ISLNK(st.st_mode)){
+        set_err(err, "%s: is a symbolic link", path); free(full); return NULL;
+    }
+    return full;
+
+outside:
+    set_err(err, "%s: path outside the project", path);
+    return NULL;
+}
+
+/* One job per file. A plain section joins the job of an earlier section for the
+   same file, so both apply in order to one result instead of racing on one target.
+   A rename (old and new name differ, neither /dev/null) reads the old name and
+   writes the new one; a file it moves may not be touched by any other section. */
+static bool plan_jobs(const patch_set_t *ps, const char *root, const char *real_root,
+                      job_t *jobs, size_t *njobs, char **errmsg)
+{
+    size_t n = 0;
+    bool ok = true;
+    for (size_t i = 0; ok && i < ps->count; i++){
+        const patch_file_t *pf = &ps->files[i];
+        if (pf->skip) continue;
+        bool creates = is_dev_null(pf->old_path), deletes = is_dev_null(pf->new_path);
+        if (creates && deletes){ set_err(errmsg, "Section has no file name"); ok = false; break; }
+        const char *label = deletes ? pf->old_path : pf->new_path;
+        char *target = resolve_under(root, real_root, label, errmsg);
+        if (!target){ ok = false; break; }
+        char *source = NULL;
+        if (!creates && !deletes && strcmp(pf->old_path, pf->new_path) != 0){
+            source = resolve_under(root, real_root, pf->old_path, errmsg);
+            if (!source){ free(target); ok = false; break; }
+        }
+
+        job_t *into = NULL;
+        for (size_t k = 0; k < n; k++){
+            job_t *j = &jobs[k];
+            bool same = !strcmp(j->target, target) ||
+                        (j->source && !strcmp(j->source, target)) ||
+                        (source && (!strcmp(j->target, source) || (j->source && !strcmp(j->source, source))));
+            if (!same) continue;
+            if (source || j->source){
+                set_err(errmsg, "%s: renamed file is also patched by another section", label);
+                free(target); free(source); ok = false; break;
+            }
+            into = j; break;
+        }
+        if (!ok) break;
+        if (!into){
+            into = &jobs[n++];
+            into->label = label;
+            into->target = target;
+            into->source = source;
+            into->pf = (const patch_file_t**)calloc(ps->count, sizeof(*into->pf));
+            if (!into->pf){ set_err(errmsg, "Out of memory"); ok = false; break; }
+        } else {
+            free(target);
+        }
+        into->pf[into->npf++] = pf;
+    }
+    *njobs = n; // on failure too: the caller frees what was resolved
+    return ok;
+}
+
+// -------------------- apply: phase 1 (parallel) --------------------
+
+static bool write_temp(const char *target, const char *data, size_t n, mode_t mode, char **tmp_out){
+    char *tmp = NULL;
+    if (asprintf(&tmp, "%s.idy-patch-XXXXXX", target) < 0) return false;
+    int fd = mkstemp(tmp);
+    if (fd < 0){ free(tmp); return false; }
+    fchmod(fd, mode);
+    size_t off = 0;
+    while (off < n){
+        ssize_t w = write(fd, data + off, n - off);
+        if (w < 0){ if (errno == EINTR) continue; break; }
+        off += (size_t)w;
+    }
+    bool ok = (off == n);
+    if (close(fd) != 0) ok = false;
+    if (!ok){ unlink(tmp); free(tmp); return false; }
+    *tmp_out = tmp;
+    return true;
+}
+
+static void run_job(pool_t *P, job_t *j){
+    const char *path = j->label;
+    const char *from = j->source ? j->source : j->target;
+    struct stat st;
+
+    j->mode = P->new_mode;
+    if (is_dev_null(j->pf[0]->old_path) || j->source){
+        if (lstat(j->target, &st) == 0){ set_err(&j->err, "%s: already exists", path); return; }
+    }
+    if (!is_dev_null(j->pf[0]->old_path)){
+        if (!fs_view_open(&j->orig, from)){
+            set_err(&j->err, "%s: %s", j->source ? j->pf[0]->old_path : path, strerror(errno)); return;
+        }
+        j->has_orig = true;
+        if (stat(from, &st) == 0) j->mode = st.st_mode & 07777;
+    }
+
+    // Each section patches the previous one's result
+    bool exists = j->has_orig;
+    char *cur = NULL;
+    for (size_t k = 0; k < j->npf; k++){
+        const patch_file_t *pf = j->pf[k];
+        bool creates = is_dev_null(pf->old_path), deletes = is_dev_null(pf->new_path);
+        if (k > 0 && creates && exists){ set_err(&j->err, "%s: already exists", path); break; }
+        if (k > 0 && !creates && !exists){ set_err(&j->err, "%s: deleted by an earlier section", path); break; }
+
+        diff_apply_opts_t o = { false, 0, 0 };
+        if (P->opts) o = *P->opts;
+        char *out = NULL, *aerr = NULL;
+        const char *src = cur ? cur : j->has_orig ? j->orig.data : "";
+        size_t src_len = cur ? strlen(cur) : j->has_orig ? j->orig.len : 0;
+        if (!apply_unified_diff_n(src, src_len, pf->body, &o, &out, &aerr)){
+            set_err(&j->err, "%s: %s", path, aerr ? aerr : "patch failed");
+            free(aerr); break;
+        }
+        j->relocated += o.relocated;
+        free(cur); cur = out;
+        if (deletes && *cur){ set_err(&j->err, "%s: deletion leaves content behind", path); break; }
+        exists = !deletes;
+    }
+    if (!j->err){
+        j->writes = exists;
+        j->deletes = !exists && j->has_orig;
+        if (exists && !write_temp(j->target, cur, strlen(cur), j->mode, &j->tmp))
+            set_err(&j->err, "%s: cannot write temp file (%s)", path, strerror(errno));
+    }
+    free(cur);
+}
+
+static void* pool_worker(void *arg){
+    pool_t *P = (pool_t*)arg;
+    for (;;){
+        size_t i = atomic_fetch_add(&P->next, 1);
+        if (i >= P->n) break;
+        run_job(P, &P->jobs[i]);
+    }
+    return NULL;
+}
+
+// -------------------- apply: phase 2 (commit) --------------------
+
+// Put back what a committed job replaced.
+static void rollback_job(job_t *j){
+    if (!j->writes && !j->deletes) return; // created, then deleted again: nothing on disk
+    if (j->source || !j->has_orig) unlink(j->target); // the new name did not exist before
+    if (!j->has_orig) return;
+    const char *dst = j->source ? j->source : j->target;
+    char *tmp = NULL;
+    if (write_temp(dst, j->orig.data, j->orig.len, j->mode, &tmp)){
+        if (rename(tmp, dst) != 0) unlink(tmp);
+        free(tmp);
+    }
+}
+
+bool patch_set_apply(const patch_set_t *ps, const char *root, const diff_apply_opts_t *opts,
+                     int threads, int *relocated, char **errmsg)
+{
+    if (errmsg) *errmsg = NULL;
+    if (relocated) *relocated = 0;
+    if (!ps || !root){ set_err(errmsg, "Invalid arguments"); return false; }
+    if (ps->count == 0) return true;
+
+    char real_root[PATH_MAX];
+    if (!realpath(root, real_root)){ set_err(errmsg, "%s: %s", root, strerror(errno)); return false; }
+
+    job_t *jobs = (job_t*)calloc(ps->count, sizeof(job_t));
+    if (!jobs){ set_err(errmsg, "Out of memory"); return false; }
+    size_t nj = 0;
+    bool ok = plan_jobs(ps, root, real_root, jobs, &nj, errmsg);
+
+    if (ok && nj > 0){
+        // umask can only be read by setting it; done once, before any worker starts
+        mode_t um = umask(0);
+        umask(um);
+        pool_t P = { jobs, nj, opts, 0666 & ~um, 0 };
+        if (threads <= 0){ long nc = sysconf(_SC_NPROCESSORS_ONLN); threads = nc > 0 ? (int)nc : 1; }
+        if ((size_t)threads > nj) threads = (int)nj;
+        pthread_t *tids = (pthread_t*)calloc((size_t)threads, sizeof(pthread_t));
+        int started = 0;
+        for (int t = 0; tids && t < threads - 1; t++)
+            if (pthread_create(&tids[t], NULL, pool_worker, &P) == 0) started++;
+        pool_worker(&P); // the caller works too
+        for (int t = 0; t < started; t++) pthread_join(tids[t], NULL);
+        free(tids);
+
+        // Validation result: first failure (in patch order) wins
+        for (size_t i = 0; i < nj; i++){
+            if (jobs[i].err){ set_err(errmsg, "%s", jobs[i].err); ok = false; break; }
+        }
+    }
+
+    size_t committed = 0;
+    if (ok){
+        for (; committed < nj; committed++){
+            job_t *j = &jobs[committed];
+            const char *what = j->target;
+            int rc = j->writes ? rename(j->tmp, j->target) : j->deletes ? unlink(j->target) : 0;
+            if (rc == 0 && j->tmp){ free(j->tmp); j->tmp = NULL; }
+            if (rc == 0 && j->source){
+                what = j->source;
+                rc = unlink(j->source);
+                if (rc != 0) committed++; // the new name is already in place: roll it back too
+            }
+            if (rc != 0){
+                set_err(errmsg, "%s: commit failed (%s)", what, strerror(errno));
+                ok = false; break;
+            }
+            if (relocated) *relocated += j->relocated;
+        }
+        if (!ok){
+            for (size_t i = 0; i < committed; i++) rollback_job(&jobs[i]);
+        }
+    }
+
+    for (size_t i = 0; i < nj; i++){
+        job_t *j = &jobs[i];
+        if (j->tmp){ unlink(j->tmp); free(j->tmp); }
+        if (j->has_orig) fs_view_close(&j->orig);
+        free(j->target); free(j->source); free(j->err); free(j->pf);
+    }
+    free(jobs);
+    return ok;
+}
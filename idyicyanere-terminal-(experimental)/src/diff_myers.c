@@ -0,0 +1,297 @@
+#include "diff.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+
+/* ========= Line diff: Myers O(ND) with the linear-space middle snake =========
+
+   Lines of both texts are interned to integer ids (equal text -> equal id),
+   so the search itself only compares ints. Common prefixes/suffixes are
+   trimmed at every level of the recursion; the middle snake splits the rest
+   into two independent subproblems, which keeps memory at O(N+M).
+   The result is a pair of "changed" flags per line, from which both the raw
+   ranges (diff_line_ranges) and unified hunks (diff_unified) are built.
+*/
+
+// -------------------- line spans --------------------
+typedef struct { const char *p; size_t len; } span_t;   // len includes the '\n' (if any)
+
+static span_t* split_spans(const char *s, size_t n, size_t *count){
+    size_t cap = 0;
+    for (const char *p = s, *e = s + n; p < e; cap++){
+        const char *nl = (const char*)memchr(p, '\n', (size_t)(e - p));
+        p = nl ? nl + 1 : e;
+    }
+    span_t *v = (span_t*)malloc((cap ? cap : 1) * sizeof(span_t));
+    if (!v) return NULL;
+    size_t k = 0;
+    for (const char *p = s, *e = s + n; p < e; k++){
+        const char *nl = (const char*)memchr(p, '\n', (size_t)(e - p));
+        const char *q = nl ? nl + 1 : e;
+        v[k].p = p; v[k].len = (size_t)(q - p);
+        p = q;
+    }
+    *count = cap;
+    return v;
+}
+
+static uint64_t hash_span(const span_t *s){
+    uint64_t h = 1469598103934665603ULL;    // FNV-1a
+    for (size_t i = 0; i < s->len; i++){ h ^= (unsigned char)s->p[i]; h *= 1099511628211ULL; }
+    return h;
+}
+
+// Give every distinct line one id; ids of a[] go to ia[], of b[] to ib[].
+static bool intern_lines(const span_t *a, size_t n, const span_t *b, size_t m, int *ia, int *ib){
+    size_t nb = 16; while (nb < (n + m) * 2) nb *= 2;
+    typedef struct { uint64_t h; const span_t *s; int id; } slot_t;
+    slot_t *tab = (slot_t*)calloc(nb, sizeof(slot_t));
+    if (!tab) return false;
+    int next_id = 0;
+    for (int side = 0; side < 2; side++){
+        const span_t *v = side ? b : a;
+        size_t cnt = side ? m : n;
+        int *ids = side ? ib : ia;
+        for (size_t i = 0; i < cnt; i++){
+            uint64_t h = hash_span(&v[i]);
+            size_t k = (size_t)h & (nb - 1);
+            for (;;){
+                slot_t *sl = &tab[k];
+                if (!sl->s){ sl->h = h; sl->s = &v[i]; sl->id = next_id++; ids[i] = sl->id; break; }
+                if (sl->h == h && sl->s->len == v[i].len && memcmp(sl->s->p, v[i].p, v[i].len) == 0){
+                    ids[i] = sl->id; break;
+                }
+                k = (k + 1) & (nb - 1);
+            }
+        }
+    }
+    free(tab);
+    return true;
+}
+
+// -------------------- Myers --------------------
+typedef struct {
+    const int *A, *B;
+    unsigned char *ca, *cb;   // changed flags per line
+    long *v1, *v2;            // scratch for the bisection, sized for the top-level problem
+} myers_t;
+
+static void mark_all(myers_t *c, long a0, long a1, long b0, long b1){
+    for (long i = a0; i < a1; i++) c->ca[i] = 1;
+    for (long j = b0; j < b1; j++) c->cb[j] = 1;
+}
+
+static void myers_rec(myers_t *c, long a0, long a1, long b0, long b1);
+
+// Find where forward and reverse D-paths overlap and recurse on both halves.
+static void myers_bisect(myers_t *c, long a0, long a1, long b0, long b1){
+    const int *A = c->A + a0, *B = c->B + b0;
+    long N = a1 - a0, M = b1 - b0;
+    long max_d = (N + M + 1) / 2;
+    long v_off = max_d, v_len = 2 * max_d + 2;
+    long *v1 = c->v1, *v2 = c->v2;
+    for (long i = 0; i < v_len; i++){ v1[i] = -1; v2[i] = -1; }
+    v1[v_off + 1] = 0; v2[v_off + 1] = 0;
+    long delta = N - M;
+    int front = (delta % 2 != 0);   // odd delta: overlap is detected on the forward pass
+    long k1start = 0, k1end = 0, k2start = 0, k2end = 0;
+
+    for (long d = 0; d < max_d; d++){
+        for (long k1 = -d + k1start; k1 <= d - k1end; k1 += 2){
+            long k1_off = v_off + k1, x1;
+            if (k1 == -d || (k1 != d && v1[k1_off - 1] < v1[k1_off + 1])) x1 = v1[k1_off + 1];
+            else x1 = v1[k1_off - 1] + 1;
+            long y1 = x1 - k1;
+            while (x1 < N && y1 < M && A[x1] == B[y1]){ x1++; y1++; }
+            v1[k1_off] = x1;
+            if (x1 > N) k1end += 2;
+            else if (y1 > M) k1start += 2;
+            else if (front){
+                long k2_off = v_off + delta - k1;
+                if (k2_off >= 0 && k2_off < v_len && v2[k2_off] != -1 && x1 >= N - v2[k2_off]){
+                    myers_rec(c, a0, a0 + x1, b0, b0 + y1);
+                    myers_rec(c, a0 + x1, a1, b0 + y1, b1);
+                    return;
+                }
+            }
+        }
+        for (long k2 = -d + k2start; k2 <= d - k2end; k2 += 2){
+            long k2_off = v_off + k2, x2;
+            if (k2 == -d || (k2 != d && v2[k2_off - 1] < v2[k2_off + 1])) x2 = v2[k2_off + 1];
+            else x2 = v2[k2_off - 1] + 1;
+            long y2 = x2 - k2;
+            while (x2 < N && y2 < M && A[N - x2 - 1] == B[M - y2 - 1]){ x2++; y2++; }
+            v2[k2_off] = x2;
+            if (x2 > N) k2end += 2;
+            else if (y2 > M) k2start += 2;
+            else if (!front){
+                long k1_off = v_off + delta - k2;
+                if (k1_off >= 0 && k1_off < v_len && v1[k1_off] != -1){
+                    long x1 = v1[k1_off], y1 = v_off + x1 - k1_off;
+                    if (x1 >= N - x2){
+                        myers_rec(c, a0, a0 + x1, b0, b0 + y1);
+                        myers_rec(c, a0 + x1, a1, b0 + y1, b1);
+                        return;
+                    }
+                }
+            }
+        }
+    }
+    mark_all(c, a0, a1, b0, b1); // no common line at all
+}
+
+static void myers_rec(myers_t *c, long a0, long a1, long b0, long b1){
+    while (a0 < a1 && b0 < b1 && c->A[a0] == c->B[b0]){ a0++; b0++; }
+    while (a0 < a1 && b0 < b1 && c->A[a1 - 1] == c->B[b1 - 1]){ a1--; b1--; }
+    if (a0 == a1 || b0 == b1){ mark_all(c, a0, a1, b0, b1); return; }
+    myers_bisect(c, a0, a1, b0, b1);
+}
+
+// Compute changed flags for both sides. Caller frees *ca and *cb.
+static bool diff_flags(const span_t *a, size_t n, const span_t *b, size_t m,
+                       unsigned char **ca, unsigned char **cb)
+{
+    myers_t c; memset(&c, 0, sizeof(c));
+    int *ia = (int*)malloc((n ? n : 1) * sizeof(int));
+    int *ib = (int*)malloc((m ? m : 1) * sizeof(int));
+    size_t vl = (n + m + 1) / 2 * 2 + 2;
+    c.v1 = (long*)malloc(vl * sizeof(long));
+    c.v2 = (long*)malloc(vl * sizeof(long));
+    c.ca = (unsigned char*)calloc(n ? n : 1, 1);
+    c.cb = (unsigned char*)calloc(m ? m : 1, 1);
+    bool ok = ia && ib && c.v1 && c.v2 && c.ca && c.cb && intern_lines(a, n, b, m, ia, ib);
+    if (ok){
+        c.A = ia; c.B = ib;
+        myers_rec(&c, 0, (long)n, 0, (long)m);
+        *ca = c.ca; *cb = c.cb;
+    } else {
+        free(c.ca); free(c.cb);
+    }
+    free(ia); free(ib); free(c.v1); free(c.v2);
+    return ok;
+}
+
+// Walk the flags and emit one range per run of changes.
+static size_t flags_to_ranges(const unsigned char *ca, size_t n, const unsigned char *cb, size_t m,
+                              diff_range_t **out)
+{
+    size_t cap = 0, cnt = 0; diff_range_t *v = NULL;
+    size_t i = 0, j = 0;
+    while (i < n || j < m){
+        if (i < n && j < m && !ca[i] && !cb[j]){ i++; j++; continue; }
+        diff_range_t r = { i, 0, j, 0 };
+        while (i < n && ca[i]) i++;
+        while (j < m && cb[j]) j++;
+        r.a_len = i - r.a_start; r.b_len = j - r.b_start;
+        if (cnt == cap){
+            size_t nc = cap ? cap * 2 : 16;
+            diff_range_t *nv = (diff_range_t*)realloc(v, nc * sizeof(diff_range_t));
+            if (!nv){ free(v); *out = NULL; return SIZE_MAX; }
+            v = nv; cap = nc;
+        }
+        v[cnt++] = r;
+    }
+    *out = v;
+    return cnt;
+}
+
+// -------------------- output buffer --------------------
+typedef struct { char *p; size_t n, cap; bool oom; } sbuf_t;
+
+static void sb_put(sbuf_t *s, const char *p, size_t n){
+    if (s->oom) return;
+    if (s->n + n + 1 > s->cap){
+        size_t nc = s->cap ? s->cap : 256;
+        while (nc < s->n + n + 1) nc *= 2;
+        char *np = (char*)realloc(s->p, nc);
+        if (!np){ s->oom = true; return; }
+        s->p = np; s->cap = nc;
+    }
+    memcpy(s->p + s->n, p, n);
+    s->n += n;
+    s->p[s->n] = '\0';
+}
+
+static void sb_line(sbuf_t *s, char tag, const span_t *l){
+    bool has_nl = l->len && l->p[l->len - 1] == '\n';
+    sb_put(s, &tag, 1);
+    sb_put(s, l->p, has_nl ? l->len - 1 : l->len);
+    sb_put(s, "\n", 1);
+    if (!has_nl) sb_put(s, "\\ No newline at end of file\n", 28);
+}
+
+// -------------------- public API --------------------
+
+bool diff_line_ranges(const char *a, size_t alen, const char *b, size_t blen,
+                      diff_range_t **out, size_t *count)
+{
+    *out = NULL; *count = 0;
+    size_t n = 0, m = 0;
+    span_t *sa = split_spans(a, alen, &n), *sb = split_spans(b, blen, &m);
+    unsigned char *ca = NULL, *cb = NULL;
+    bool ok = sa && sb && diff_flags(sa, n, sb, m, &ca, &cb);
+    if (ok){
+        size_t k = flags_to_ranges(ca, n, cb, m, out);
+        if (k == SIZE_MAX) ok = false; else *count = k;
+    }
+    free(sa); free(sb); free(ca); free(cb);
+    return ok;
+}
+
+char* diff_unified(const char *a, size_t alen, const char *b, size_t blen,
+                   const char *a_name, const char *b_name, int context)
+{
+    if (context < 0) context = 0;
+    size_t n = 0, m = 0;
+    span_t *sa = split_spans(a, alen, &n), *sb = split_spans(b, blen, &m);
+    unsigned char *ca = NULL, *cb = NULL;
+    diff_range_t *R = NULL; size_t nr = 0;
+    sbuf_t s = { NULL, 0, 0, false };
+    bool ok = sa && sb && diff_flags(sa, n, sb, m, &ca, &cb);
+    if (ok){
+        nr = flags_to_ranges(ca, n, cb, m, &R);
+        ok = (nr != SIZE_MAX);
+    }
+    if (ok){
+        sb_put(&s, "", 0);  // identical inputs still yield "" rather than NULL
+        if (nr){
+            char hdr[160];
+            int hl = snprintf(hdr, sizeof(hdr), "--- %s\n+++ %s\n", a_name ? a_name : "a", b_name ? b_name : "b");
+            if (hl > 0 && (size_t)hl < sizeof(hdr)) sb_put(&s, hdr, (size_t)hl);
+            else { sb_put(&s, "--- ", 4); sb_put(&s, a_name ? a_name : "a", strlen(a_name ? a_name : "a"));
+                   sb_put(&s, "\n+++ ", 5); sb_put(&s, b_name ? b_name : "b", strlen(b_name ? b_name : "b"));
+                   sb_put(&s, "\n", 1); }
+        }
+        size_t ctx = (size_t)context;
+        for (size_t r = 0; r < nr; ){
+            // Group ranges whose unchanged gap fits in two contexts into one hunk
+            size_t last = r;
+            while (last + 1 < nr && R[last + 1].a_start - (R[last].a_start + R[last].a_len) <= 2 * ctx) last++;
+            size_t a_lo = R[r].a_start > ctx ? R[r].a_start - ctx : 0;
+            size_t b_lo = R[r].b_start - (R[r].a_start - a_lo);
+            size_t a_hi = R[last].a_start + R[last].a_len + ctx; if (a_hi > n) a_hi = n;
+            size_t b_hi = R[last].b_start + R[last].b_len + (a_hi - (R[last].a_start + R[last].a_len));
+
+            char hdr[96];
+            // Empty sides are numbered after the line they follow (unified convention)
+            int hl = snprintf(hdr, sizeof(hdr), "@@ -%zu,%zu +%zu,%zu @@\n",
+                              a_hi > a_lo ? a_lo + 1 : a_lo, a_hi - a_lo,
+                              b_hi > b_lo ? b_lo + 1 : b_lo, b_hi - b_lo);
+            sb_put(&s, hdr, (size_t)hl);
+
+            size_t i = a_lo, j = b_lo;
+            for (size_t k = r; k <= last; k++){
+                for (; i < R[k].a_start; i++, j++) sb_line(&s, ' ', &sa[i]);
+                for (; i < R[k].a_start + R[k].a_len; i++) sb_line(&s, '-', &sa[i]);
+                for (; j < R[k].b_start + R[k].b_len; j++) sb_line(&s, '+', &sb[j]);
+            }
+            for (; i < a_hi; i++) sb_line(&s, ' ', &sa[i]);
+            r = last + 1;
+        }
+    }
+    free(sa); free(sb); free(ca); free(cb); free(R);
+    if (!ok || s.oom){ free(s.p); return NULL; }
+    return s.p;
+}
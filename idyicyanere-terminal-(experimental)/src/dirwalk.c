@@ -0,0 +1,707 @@
+#include "dirwalk.h"
+#include "idy.h"
+#include "log.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+#include <strings.h> // for strcasecmp
+#include <time.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/inotify.h>
+
+/* ========= Context tree walker =========
+
+   The tree is kept as nodes (one allocation each: node + relative path).
+   A directory node is "listed" once a worker has read, filtered and sorted
+   its entries; the release store on `listed` publishes its children to the
+   UI thread, which only ever reads listed nodes. */
+
+// -------------------- ignore rules --------------------
+
+typedef struct {
+    char *pat;
+    bool neg;        // "!pat": re-include
+    bool dir_only;   // "pat/": directories only
+    bool anchored;   // had a "/" other than a trailing one: match the path, not the name
+} dw_rule_t;
+
+typedef struct dw_rules {
+    const struct dw_rules *parent;  // rules of enclosing directories (lower precedence)
+    size_t base_len;                // strlen of the rel path of the directory they came from
+    dw_rule_t *v; int n;
+    struct dw_rules *next_owned;    // every rule set, for freeing
+} dw_rules_t;
+
+// '*' and '?' stay within a path component, "**" crosses them ("**/" also
+// matches zero directories), "[...]" is a character class.
+static bool glob_match(const char *p, const char *s){
+    for(;;){
+        if(!*p) return !*s;
+        if(p[0]=='*' && p[1]=='*'){
+            p += 2;
+            if(*p == '/'){
+                p++;
+                for(const char *t = s; ; ){
+                    if(glob_match(p, t)) return true;
+                    t = strchr(t, '/');
+                    if(!t) return false;
+                    t++;
+                }
+            }
+            for(const char *t = s; ; t++){
+                if(glob_match(p, t)) return true;
+                if(!*t) return false;
+            }
+        }
+        if(*p == '*'){
+            p++;
+            for(const char *t = s; ; t++){
+                if(glob_match(p, t)) return true;
+                if(!*t || *t == '/') return false;
+            }
+        }
+        if(!*s) return false;
+        if(*p == '?'){
+            if(*s == '/') return false;
+            p++; s++; continue;
+        }
+        if(*p == '['){
+            const char *q = p + 1;
+            bool negate = (*q == '!' || *q == '^');
+            if(negate) q++;
+            bool hit = false;
+            const char *first = q;
+            while(*q && (*q != ']' || q == first)){
+                if(q[1] == '-' && q[2] && q[2] != ']'){
+                    if((unsigned char)*s >= (unsigned char)q[0] && (unsigned char)*s <= (unsigned char)q[2]) hit = true;
+                    q += 3;
+                } else {
+                    if(*q == *s) hit = true;
+                    q++;
+                }
+            }
+            if(*q != ']'){ if(*p != *s) return false; p++; s++; continue; } // unterminated: literal '['
+            if(hit == negate || *s == '/') return false;
+            p = q + 1; s++; continue;
+        }
+        if(*p == '\\' && p[1]) p++;
+        if(*p != *s) return false;
+        p++; s++;
+    }
+}
+
+static void rules_add(dw_rules_t *r, const char *line, size_t n){
+    while(n && (line[n-1]==' ' || line[n-1]=='\t' || line[n-1]=='\r')) n--;
+    if(!n || line[0]=='#') return;
+    dw_rule_t rule = {0};
+    if(line[0]=='!'){ rule.neg = true; line++; n--; }
+    else if(line[0]=='\\' && n > 1 && (line[1]=='!' || line[1]=='#')){ line++; n--; }
+    if(n && line[n-1]=='/'){ rule.dir_only = true; n--; }
+    if(n && line[0]=='/'){ rule.anchored = true; line++; n--; }
+    if(!n) return;
+    if(memchr(line, '/', n)) rule.anchored = true;
+    rule.pat = (char*)malloc(n + 1);
+    if(!rule.pat) return;
+    memcpy(rule.pat, line, n); rule.pat[n] = 0;
+    dw_rule_t *nv = (dw_rule_t*)realloc(r->v, sizeof(dw_rule_t) * (size_t)(r->n + 1));
+    if(!nv){ free(rule.pat); return; }
+    r->v = nv; r->v[r->n++] = rule;
+}
+
+static void rules_parse(dw_rules_t *r, const char *text, size_t len){
+    const char *p = text, *e = text + len;
+    while(p < e){
+        const char *nl = memchr(p, '\n', (size_t)(e - p));
+        size_t n = nl ? (size_t)(nl - p) : (size_t)(e - p);
+        rules_add(r, p, n);
+        p += n + 1;
+    }
+}
+
+// Innermost .gitignore first, last matching line wins within a file.
+static bool dw_ignored(const dw_rules_t *rs, const char *rel, const char *name, bool is_dir){
+    for(; rs; rs = rs->parent){
+        const char *path = rs->base_len ? rel + rs->base_len + 1 : rel;
+        for(int i = rs->n - 1; i >= 0; i--){
+            const dw_rule_t *r = &rs->v[i];
+            if(r->dir_only && !is_dir) continue;
+            if(glob_match(r->pat, r->anchored ? path : name)) return !r->neg;
+        }
+    }
+    return false;
+}
+
+// -------------------- tree + pool --------------------
+
+typedef struct dw_node {
+    char *rel;                   // path from the root ("" for the root)
+    const char *name;            // last component of rel
+    bool is_dir;
+    int depth;                   // 0 for top-level entries
+    const dw_rules_t *inherited; // dirs: rules of the enclosing directories
+    const dw_rules_t *rules;     // dirs: rules for their entries (inherited + own .gitignore)
+    struct dw_node **kids; int nkids;
+    atomic_bool listed;
+    int wd;                      // inotify watch (dirs, once watching), -1 if none
+} dw_node_t;
+
+typedef struct {
+    pthread_mutex_t mu;
+    dw_node_t **v;
+    size_t head, tail, cap;      // owner pushes/pops at tail, thieves take from head
+} dw_deque_t;
+
+struct dirwalk {
+    char *root;
+    int root_fd;
+    dw_node_t *top;
+    int nthreads;                // deques in use (planned workers)
+    int started;                 // workers actually running
+    bool joined;
+    pthread_t tids[DW_MAX_THREADS];
+    dw_deque_t dq[DW_MAX_THREADS];
+    atomic_size_t pending;       // directories queued or being listed
+    atomic_size_t listed;        // directories listed (progress)
+    atomic_size_t entries;
+    atomic_bool stop;
+    pthread_mutex_t idle_mu;
+    pthread_cond_t idle_cv;
+    pthread_mutex_t rules_mu;
+    dw_rules_t *rules_owned;
+    size_t flat_key;             // listed + tree_gen at the last dirwalk_poll (UI thread)
+
+    // Live updates (UI thread, except the reader thread's queue)
+    size_t tree_gen;             // bumped by every applied change
+    int ino_fd, wake_fd[2];
+    bool watching, watch_full;   // watch_full: ran out of inotify watches
+    pthread_t reader;
+    dw_node_t **wdmap; int wdcap;
+    pthread_mutex_t evq_mu;
+    char *evq; size_t evq_len;   // raw inotify records read by the reader thread
+    bool evq_overflow;
+};
+
+#define DW_EVQ_MAX ((size_t)4 << 20)
+
+typedef struct { dirwalk_t *w; int self; } dw_arg_t;
+
+static void dirwalk_unwatch(dirwalk_t *w);
+
+static bool dq_push(dw_deque_t *q, dw_node_t *n){
+    pthread_mutex_lock(&q->mu);
+    if(q->tail == q->cap){
+        if(q->head > 0){
+            memmove(q->v, q->v + q->head, (q->tail - q->head) * sizeof(*q->v));
+            q->tail -= q->head; q->head = 0;
+        } else {
+            size_t nc = q->cap ? q->cap * 2 : 64;
+            dw_node_t **nv = (dw_node_t**)realloc(q->v, nc * sizeof(*nv));
+            if(!nv){ pthread_mutex_unlock(&q->mu); return false; }
+            q->v = nv; q->cap = nc;
+        }
+    }
+    q->v[q->tail++] = n;
+    pthread_mutex_unlock(&q->mu);
+    return true;
+}
+
+static dw_node_t* dq_take(dw_deque_t *q, bool steal){
+    dw_node_t *n = NULL;
+    pthread_mutex_lock(&q->mu);
+    if(q->head < q->tail) n = steal ? q->v[q->head++] : q->v[--q->tail];
+    if(q->head == q->tail) q->head = q->tail = 0;
+    pthread_mutex_unlock(&q->mu);
+    return n;
+}
+
+static dw_node_t* node_new(const char *parent_rel, const char *name, bool is_dir, int depth){
+    size_t pl = strlen(parent_rel), nl = strlen(name);
+    size_t rl = pl ? pl + 1 + nl : nl;
+    dw_node_t *n = (dw_node_t*)malloc(sizeof(dw_node_t) + rl + 1);
+    if(!n) return NULL;
+    n->rel = (char*)(n + 1);
+    if(pl){ memcpy(n->rel, parent_rel, pl); n->rel[pl] = '/'; memcpy(n->rel + pl + 1, name, nl + 1); }
+    else memcpy(n->rel, name, nl + 1);
+    n->name = n->rel + rl - nl;
+    n->is_dir = is_dir;
+    n->depth = depth;
+    n->inherited = n->rules = NULL;
+    n->kids = NULL; n->nkids = 0;
+    atomic_init(&n->listed, false);
+    n->wd = -1;
+    return n;
+}
+
+static void node_free(dw_node_t *n){
+    for(int i = 0; i < n->nkids; i++) node_free(n->kids[i]);
+    free(n->kids);
+    free(n);
+}
+
+static int cmp_node(const void *a, const void *b){
+    const dw_node_t *A = *(dw_node_t* const*)a, *B = *(dw_node_t* const*)b;
+    if(A->is_dir != B->is_dir) return B->is_dir - A->is_dir; // dirs first
+    return strcasecmp(A->name, B->name);
+}
+
+// Own .gitignore of the directory open at fd, chained onto the inherited rules.
+static const dw_rules_t* load_gitignore(dirwalk_t *w, int fd, const dw_node_t *dir){
+    int gfd = openat(fd, ".gitignore", O_RDONLY | O_CLOEXEC);
+    if(gfd < 0) return dir->inherited;
+    char *text = NULL; size_t len = 0, cap = 0;
+    for(;;){
+        if(len == cap){
+            size_t nc = cap ? cap * 2 : 4096;
+            char *nt = (char*)realloc(text, nc);
+            if(!nt) break;
+            text = nt; cap = nc;
+        }
+        ssize_t r = read(gfd, text + len, cap - len);
+        if(r < 0 && errno == EINTR) continue;
+        if(r <= 0) break;
+        len += (size_t)r;
+    }
+    close(gfd);
+    dw_rules_t *rs = (dw_rules_t*)calloc(1, sizeof(*rs));
+    if(!rs){ free(text); return dir->inherited; }
+    rs->parent = dir->inherited;
+    rs->base_len = strlen(dir->rel);
+    if(text) rules_parse(rs, text, len);
+    free(text);
+    pthread_mutex_lock(&w->rules_mu);
+    rs->next_owned = w->rules_owned; w->rules_owned = rs;
+    pthread_mutex_unlock(&w->rules_mu);
+    return rs;
+}
+
+static void list_node(dirwalk_t *w, int self, dw_node_t *dir){
+    // Not dup(root_fd): a dup shares the directory offset, so a relist of the root would read nothing
+    int fd = openat(w->root_fd, dir->rel[0] ? dir->rel : ".", O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    DIR *d = fd >= 0 ? fdopendir(fd) : NULL;
+    dir->rules = dir->inherited;
+    if(!d){
+        if(fd >= 0) close(fd);
+        atomic_store_explicit(&dir->listed, true, memory_order_release);
+        atomic_fetch_add(&w->listed, 1);
+        return;
+    }
+    dir->rules = load_gitignore(w, fd, dir);
+
+    int cap = 0, cnt = 0;
+    dw_node_t **kids = NULL;
+    struct dirent *ent;
+    while((ent = readdir(d))){
+        const char *nm = ent->d_name;
+        if(!strcmp(nm, ".") || !strcmp(nm, "..") || !strcmp(nm, ".git")) continue;
+        bool is_dir;
+        if(ent->d_type == DT_DIR) is_dir = true;
+        else if(ent->d_type != DT_UNKNOWN) is_dir = false; // symlinks are not followed
+        else {
+            struct stat st;
+            if(fstatat(fd, nm, &st, AT_SYMLINK_NOFOLLOW) != 0) continue;
+            is_dir = S_ISDIR(st.st_mode);
+        }
+        dw_node_t *k = node_new(dir->rel, nm, is_dir, dir->depth + 1);
+        if(!k) continue;
+        if(dw_ignored(dir->rules, k->rel, k->name, is_dir)){ free(k); continue; }
+        if(cnt == cap){
+            int nc = cap ? cap * 2 : 32;
+            dw_node_t **nv = (dw_node_t**)realloc(kids, sizeof(*nv) * (size_t)nc);
+            if(!nv){ free(k); break; }
+            kids = nv; cap = nc;
+        }
+        kids[cnt++] = k;
+    }
+    closedir(d);
+
+    if(cnt) qsort(kids, (size_t)cnt, sizeof(*kids), cmp_node);
+    dir->kids = kids; dir->nkids = cnt;
+
+    bool pushed = false;
+    for(int i = 0; i < cnt; i++){
+        dw_node_t *k = kids[i];
+        if(!k->is_dir) continue;
+        k->inherited = dir->rules;
+        atomic_fetch_add(&w->pending, 1);
+        if(dq_push(&w->dq[self], k)) pushed = true;
+        else { atomic_fetch_sub(&w->pending, 1); atomic_store(&k->listed, true); }
+    }
+    atomic_fetch_add(&w->entries, (size_t)cnt);
+    atomic_store_explicit(&dir->listed, true, memory_order_release);
+    atomic_fetch_add(&w->listed, 1);
+    if(pushed){
+        pthread_mutex_lock(&w->idle_mu);
+        pthread_cond_broadcast(&w->idle_cv);
+        pthread_mutex_unlock(&w->idle_mu);
+    }
+}
+
+static void* dw_worker(void *arg){
+    dw_arg_t *a = (dw_arg_t*)arg;
+    dirwalk_t *w = a->w;
+    int self = a->self;
+    free(a);
+    while(!atomic_load(&w->stop)){
+        dw_node_t *n = dq_take(&w->dq[self], false);
+        for(int k = 1; !n && k < w->nthreads; k++) n = dq_take(&w->dq[(self + k) % w->nthreads], true);
+        if(n){
+            list_node(w, self, n);
+            if(atomic_fetch_sub(&w->pending, 1) == 1){
+                pthread_mutex_lock(&w->idle_mu);
+                pthread_cond_broadcast(&w->idle_cv);
+                pthread_mutex_unlock(&w->idle_mu);
+            }
+            continue;
+        }
+        if(atomic_load(&w->pending) == 0) break;
+        // Nothing to steal yet: nap briefly (a push or the last completion wakes us)
+        struct timespec ts; clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += 2000000; if(ts.tv_nsec >= 1000000000L){ ts.tv_sec++; ts.tv_nsec -= 1000000000L; }
+        pthread_mutex_lock(&w->idle_mu);
+        if(atomic_load(&w->pending) > 0 && !atomic_load(&w->stop)) pthread_cond_timedwait(&w->idle_cv, &w->idle_mu, &ts);
+        pthread_mutex_unlock(&w->idle_mu);
+    }
+    return NULL;
+}
+
+// IDY_CTX_IGNORE: comma-separated patterns applied like a root .gitignore.
+static dw_rules_t* env_rules(void){
+    char *v = idy_getenv_trimdup("IDY_CTX_IGNORE");
+    if(!v) return NULL;
+    dw_rules_t *rs = (dw_rules_t*)calloc(1, sizeof(*rs));
+    if(rs){
+        for(char *p = v; *p; ){
+            char *c = strchr(p, ',');
+            size_t n = c ? (size_t)(c - p) : strlen(p);
+            while(n && (*p == ' ' || *p == '\t')){ p++; n--; }
+            rules_add(rs, p, n);
+            p += n; if(*p == ',') p++;
+        }
+    }
+    free(v);
+    return rs;
+}
+
+dirwalk_t* dirwalk_start(const char *root){
+    int fd = open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(fd < 0) return NULL;
+    dirwalk_t *w = (dirwalk_t*)calloc(1, sizeof(*w));
+    dw_node_t *top = node_new("", "", true, -1);
+    if(!w || !top || !(w->root = strdup(root))){
+        if(w) free(w->root);
+        free(w); free(top); close(fd); return NULL;
+    }
+    w->root_fd = fd;
+    w->top = top;
+    pthread_mutex_init(&w->idle_mu, NULL);
+    pthread_cond_init(&w->idle_cv, NULL);
+    pthread_mutex_init(&w->rules_mu, NULL);
+    pthread_mutex_init(&w->evq_mu, NULL);
+    w->ino_fd = w->wake_fd[0] = w->wake_fd[1] = -1;
+    w->rules_owned = env_rules();
+    top->inherited = w->rules_owned;
+
+    long nc = sysconf(_SC_NPROCESSORS_ONLN);
+    w->nthreads = nc > 0 ? (int)nc : 1;
+    if(w->nthreads > DW_MAX_THREADS) w->nthreads = DW_MAX_THREADS;
+    for(int i = 0; i < DW_MAX_THREADS; i++) pthread_mutex_init(&w->dq[i].mu, NULL);
+
+    atomic_store(&w->pending, 1);
+    dq_push(&w->dq[0], top);
+    // A worker that fails to start leaves its deque empty; the others still steal from all
+    for(int i = 0; i < w->nthreads; i++){
+        dw_arg_t *a = (dw_arg_t*)malloc(sizeof(*a));
+        if(!a) break;
+        a->w = w; a->self = i;
+        if(pthread_create(&w->tids[w->started], NULL, dw_worker, a) != 0){ free(a); break; }
+        w->started++;
+    }
+    if(!w->started){
+        // No threads at all: list on the caller
+        dw_arg_t *a = (dw_arg_t*)malloc(sizeof(*a));
+        if(a){ a->w = w; a->self = 0; dw_worker(a); }
+        w->joined = true;
+    }
+    return w;
+}
+
+static void add_item(file_list_t *out, const dw_node_t *n){
+    if(out->count == out->cap){
+        int nc = out->cap ? out->cap * 2 : 128;
+        file_item_t *nv = (file_item_t*)realloc(out->items, sizeof(file_item_t) * (size_t)nc);
+        if(!nv) return;
+        out->items = nv; out->cap = nc;
+    }
+    file_item_t *it = &out->items[out->count];
+    it->name = strdup(n->rel);
+    if(!it->name) return;
+    it->is_dir = n->is_dir;
+    it->depth = n->depth;
+    out->count++;
+}
+
+static void flatten(const dw_node_t *dir, file_list_t *out){
+    if(!atomic_load_explicit(&dir->listed, memory_order_acquire)) return;
+    for(int i = 0; i < dir->nkids; i++){
+        const dw_node_t *k = dir->kids[i];
+        add_item(out, k);
+        if(k->is_dir) flatten(k, out);
+    }
+}
+
+bool dirwalk_poll(dirwalk_t *w, file_list_t *out){
+    if(!w) return false;
+    size_t key = atomic_load(&w->listed) + w->tree_gen;
+    if(key == w->flat_key) return false;
+    w->flat_key = key;
+    free_file_list(out);
+    flatten(w->top, out);
+    return true;
+}
+
+bool dirwalk_done(const dirwalk_t *w){
+    return !w || atomic_load(&w->pending) == 0 || atomic_load(&w->stop);
+}
+
+size_t dirwalk_entries(const dirwalk_t *w){
+    return w ? atomic_load(&w->entries) : 0;
+}
+
+void dirwalk_wait(dirwalk_t *w){
+    if(!w || w->joined) return;
+    for(int i = 0; i < w->started; i++) pthread_join(w->tids[i], NULL);
+    w->joined = true;
+}
+
+void dirwalk_free(dirwalk_t *w){
+    if(!w) return;
+    atomic_store(&w->stop, true);
+    pthread_mutex_lock(&w->idle_mu);
+    pthread_cond_broadcast(&w->idle_cv);
+    pthread_mutex_unlock(&w->idle_mu);
+    dirwalk_wait(w);
+    dirwalk_unwatch(w);
+    node_free(w->top);
+    for(dw_rules_t *r = w->rules_owned, *nx; r; r = nx){
+        nx = r->next_owned;
+        for(int i = 0; i < r->n; i++) free(r->v[i].pat);
+        free(r->v); free(r);
+    }
+    for(int i = 0; i < DW_MAX_THREADS; i++){
+        free(w->dq[i].v);
+        pthread_mutex_destroy(&w->dq[i].mu);
+    }
+    pthread_mutex_destroy(&w->idle_mu);
+    pthread_cond_destroy(&w->idle_cv);
+    pthread_mutex_destroy(&w->rules_mu);
+    pthread_mutex_destroy(&w->evq_mu);
+    close(w->root_fd);
+    free(w->root);
+    free(w);
+}
+
+// -------------------- live updates (inotify) --------------------
+/* A reader thread only moves raw inotify records into a queue; the UI thread
+   applies them to the tree in dirwalk_apply_events, so the tree keeps a
+   single writer. Creates and renames-in are listed on the spot (subtrees
+   too), deletes and renames-out drop the node, and a changed .gitignore
+   relists its directory. */
+
+#define DW_WATCH_MASK (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE | IN_ONLYDIR)
+
+static void* dw_reader(void *arg){
+    dirwalk_t *w = (dirwalk_t*)arg;
+    char buf[16384] __attribute__((aligned(__alignof__(struct inotify_event))));
+    struct pollfd fds[2] = { { w->ino_fd, POLLIN, 0 }, { w->wake_fd[0], POLLIN, 0 } };
+    for(;;){
+        if(poll(fds, 2, -1) < 0){ if(errno == EINTR) continue; break; }
+        if(fds[1].revents) break;
+        ssize_t r = read(w->ino_fd, buf, sizeof(buf));
+        if(r < 0){ if(errno == EINTR || errno == EAGAIN) continue; break; }
+        pthread_mutex_lock(&w->evq_mu);
+        if(w->evq_len + (size_t)r > DW_EVQ_MAX) w->evq_overflow = true;
+        else {
+            char *nq = (char*)realloc(w->evq, w->evq_len + (size_t)r);
+            if(!nq) w->evq_overflow = true;
+            else { memcpy(nq + w->evq_len, buf, (size_t)r); w->evq = nq; w->evq_len += (size_t)r; }
+        }
+        pthread_mutex_unlock(&w->evq_mu);
+    }
+    return NULL;
+}
+
+static void watch_node(dirwalk_t *w, dw_node_t *n){
+    if(w->watch_full || n->wd >= 0) return;
+    char *path = NULL;
+    if(asprintf(&path, "%s%s%s", w->root, n->rel[0] ? "/" : "", n->rel) < 0) return;
+    int wd = inotify_add_watch(w->ino_fd, path, DW_WATCH_MASK | IN_DONT_FOLLOW);
+    free(path);
+    if(wd < 0){
+        if(errno == ENOSPC){
+            w->watch_full = true;
+            LOG_WARN("Context tree: out of inotify watches (fs.inotify.max_user_watches); live updates are partial");
+        }
+        return;
+    }
+    if(wd >= w->wdcap){
+        int nc = w->wdcap ? w->wdcap : 256;
+        while(nc <= wd) nc *= 2;
+        dw_node_t **nm = (dw_node_t**)realloc(w->wdmap, sizeof(*nm) * (size_t)nc);
+        if(!nm){ inotify_rm_watch(w->ino_fd, wd); return; }
+        memset(nm + w->wdcap, 0, sizeof(*nm) * (size_t)(nc - w->wdcap));
+        w->wdmap = nm; w->wdcap = nc;
+    }
+    w->wdmap[wd] = n;
+    n->wd = wd;
+}
+
+static void watch_subtree(dirwalk_t *w, dw_node_t *n){
+    if(!n->is_dir) return;
+    watch_node(w, n);
+    for(int i = 0; i < n->nkids; i++) watch_subtree(w, n->kids[i]);
+}
+
+static size_t unwatch_subtree(dirwalk_t *w, dw_node_t *n){
+    size_t cnt = 1;
+    if(n->wd >= 0){
+        inotify_rm_watch(w->ino_fd, n->wd);
+        if(n->wd < w->wdcap) w->wdmap[n->wd] = NULL;
+        n->wd = -1;
+    }
+    for(int i = 0; i < n->nkids; i++) cnt += unwatch_subtree(w, n->kids[i]);
+    return cnt;
+}
+
+bool dirwalk_watch(dirwalk_t *w){
+    if(!w || w->watching) return w != NULL;
+    dirwalk_wait(w);
+    w->ino_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(w->ino_fd < 0) return false;
+    if(pipe2(w->wake_fd, O_CLOEXEC) != 0){ close(w->ino_fd); w->ino_fd = -1; return false; }
+    watch_subtree(w, w->top);
+    if(pthread_create(&w->reader, NULL, dw_reader, w) != 0){
+        close(w->ino_fd); close(w->wake_fd[0]); close(w->wake_fd[1]);
+        w->ino_fd = w->wake_fd[0] = w->wake_fd[1] = -1;
+        return false;
+    }
+    w->watching = true;
+    return true;
+}
+
+static void dirwalk_unwatch(dirwalk_t *w){
+    if(!w->watching) return;
+    if(write(w->wake_fd[1], "x", 1) < 0){ /* reader also exits when the fd closes */ }
+    pthread_join(w->reader, NULL);
+    close(w->ino_fd); close(w->wake_fd[0]); close(w->wake_fd[1]);
+    w->ino_fd = w->wake_fd[0] = w->wake_fd[1] = -1;
+    free(w->wdmap); w->wdmap = NULL; w->wdcap = 0;
+    free(w->evq); w->evq = NULL; w->evq_len = 0;
+    w->watching = false;
+}
+
+// List a directory (and everything under it) on the calling thread.
+static void list_subtree_sync(dirwalk_t *w, dw_node_t *n){
+    atomic_fetch_add(&w->pending, 1);
+    if(!dq_push(&w->dq[0], n)){ atomic_fetch_sub(&w->pending, 1); return; }
+    for(dw_node_t *x; (x = dq_take(&w->dq[0], false)); ){
+        list_node(w, 0, x);
+        atomic_fetch_sub(&w->pending, 1);
+    }
+}
+
+static void drop_kid(dirwalk_t *w, dw_node_t *dir, int i){
+    dw_node_t *k = dir->kids[i];
+    size_t cnt = unwatch_subtree(w, k);
+    atomic_fetch_sub(&w->entries, cnt);
+    node_free(k);
+    memmove(dir->kids + i, dir->kids + i + 1, sizeof(*dir->kids) * (size_t)(dir->nkids - i - 1));
+    dir->nkids--;
+}
+
+static int find_kid(const dw_node_t *dir, const char *name){
+    for(int i = 0; i < dir->nkids; i++) if(!strcmp(dir->kids[i]->name, name)) return i;
+    return -1;
+}
+
+static bool tree_remove(dirwalk_t *w, dw_node_t *dir, const char *name){
+    int i = find_kid(dir, name);
+    if(i < 0) return false;
+    drop_kid(w, dir, i);
+    return true;
+}
+
+static bool tree_insert(dirwalk_t *w, dw_node_t *dir, const char *name, bool is_dir){
+    int i = find_kid(dir, name);
+    if(i >= 0){
+        if(dir->kids[i]->is_dir == is_dir) return false;
+        drop_kid(w, dir, i);
+    }
+    dw_node_t *k = node_new(dir->rel, name, is_dir, dir->depth + 1);
+    if(!k) return false;
+    if(dw_ignored(dir->rules, k->rel, k->name, is_dir)){ free(k); return i >= 0; }
+    dw_node_t **nv = (dw_node_t**)realloc(dir->kids, sizeof(*nv) * (size_t)(dir->nkids + 1));
+    if(!nv){ free(k); return i >= 0; }
+    dir->kids = nv;
+    int at = 0;
+    while(at < dir->nkids && cmp_node(&dir->kids[at], &k) < 0) at++;
+    memmove(dir->kids + at + 1, dir->kids + at, sizeof(*dir->kids) * (size_t)(dir->nkids - at));
+    dir->kids[at] = k;
+    dir->nkids++;
+    atomic_fetch_add(&w->entries, 1);
+    if(is_dir){
+        // Watch before listing so nothing created in between is missed
+        k->inherited = dir->rules;
+        watch_node(w, k);
+        list_subtree_sync(w, k);
+        watch_subtree(w, k);
+    } else {
+        atomic_store(&k->listed, true);
+    }
+    return true;
+}
+
+// Its .gitignore changed: read the directory again under the new rules.
+static void tree_relist(dirwalk_t *w, dw_node_t *dir){
+    while(dir->nkids > 0) drop_kid(w, dir, dir->nkids - 1);
+    free(dir->kids); dir->kids = NULL;
+    atomic_store(&dir->listed, false);
+    list_subtree_sync(w, dir);
+    watch_subtree(w, dir);
+}
+
+int dirwalk_apply_events(dirwalk_t *w, void (*on_file)(const char *rel, void *user), void *user){
+    if(!w || !w->watching) return 0;
+    pthread_mutex_lock(&w->evq_mu);
+    char *q = w->evq; size_t len = w->evq_len; bool lost = w->evq_overflow;
+    w->evq = NULL; w->evq_len = 0; w->evq_overflow = false;
+    pthread_mutex_unlock(&w->evq_mu);
+
+    bool changed = false;
+    for(size_t off = 0; !lost && off + sizeof(struct inotify_event) <= len; ){
+        const struct inotify_event *ev = (const struct inotify_event*)(q + off);
+        off += sizeof(*ev) + ev->len;
+        if(ev->mask & IN_Q_OVERFLOW){ lost = true; break; }
+        dw_node_t *dir = (ev->wd >= 0 && ev->wd < w->wdcap) ? w->wdmap[ev->wd] : NULL;
+        if(!dir) continue;                        // directory already dropped
+        if(ev->mask & IN_IGNORED){ w->wdmap[ev->wd] = NULL; dir->wd = -1; continue; }
+        if(!ev->len || !ev->name[0] || !strcmp(ev->name, ".git")) continue;
+
+        const char *nm = ev->name;
+        bool is_dir = (ev->mask & IN_ISDIR) != 0;
+        if(ev->mask & (IN_DELETE | IN_MOVED_FROM)) changed |= tree_remove(w, dir, nm);
+        if(ev->mask & (IN_CREATE | IN_MOVED_TO))   changed |= tree_insert(w, dir, nm, is_dir);
+        if(!is_dir && !strcmp(nm, ".gitignore")){ tree_relist(w, dir); changed = true; }
+        if(!is_dir && on_file){
+            char *rel = NULL;
+            if(asprintf(&rel, "%s%s%s", dir->rel, dir->rel[0] ? "/" : "", nm) >= 0){ on_file(rel, user); free(rel); }
+        }
+    }
+    free(q);
+    if(lost) return -1;
+    if(changed) w->tree_gen++;
+    return changed ? 1 : 0;
+}
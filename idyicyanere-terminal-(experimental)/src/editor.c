@@ -1,83 +1,159 @@
 #include "editor.h"
 
-static void ensure_cap(buffer_t *b, size_t need){
-    if(need <= b->cap) return;
-    size_t cap = b->cap ? b->cap*2 : 4096;
-    while(cap < need) cap *= 2;
-    b->data = (char*)realloc(b->data, cap);
-    b->cap = cap;
+/* ---------------- undo/redo ---------------- */
+
+static void undo_push(editor_undo_t **v, int *n, int *cap, buf_snap_t snap, size_t cursor){
+    if(*n == EDITOR_UNDO_MAX){
+        buf_snap_release(&(*v)[0].snap);
+        memmove(*v, *v + 1, sizeof(**v) * (size_t)(*n - 1));
+        (*n)--;
+    }
+    if(*n == *cap){
+        int nc = *cap ? *cap * 2 : 32;
+        editor_undo_t *nv = (editor_undo_t*)realloc(*v, sizeof(**v) * (size_t)nc);
+        if(!nv){ buf_snap_release(&snap); return; }
+        *v = nv; *cap = nc;
+    }
+    (*v)[(*n)++] = (editor_undo_t){ .snap = snap, .cursor = cursor };
+}
+
+static void undo_clear(editor_undo_t *v, int *n){
+    for(int i = 0; i < *n; i++) buf_snap_release(&v[i].snap);
+    *n = 0;
+}
+
+// Record the pre-edit state. Runs of typed characters share one undo step.
+static void begin_edit(editor_t *e, editor_op_t op){
+    bool coalesce = (op == EDIT_OP_TYPE && e->last_op == EDIT_OP_TYPE && e->cursor == e->last_cursor);
+    if(!coalesce){
+        undo_push(&e->undo, &e->undo_n, &e->undo_cap, buf_snapshot(e->doc), e->cursor);
+    }
+    undo_clear(e->redo, &e->redo_n);
+    e->last_op = op;
+}
+
+static void end_edit(editor_t *e){
+    e->last_cursor = e->cursor;
+    e->dirty = true;
 }
 
 void editor_init(editor_t *e, buffer_t *doc){
     e->doc = doc; e->cursor = 0; e->top_line = 0; e->left_col = 0; e->tabstop = 4;
     e->sel_anchor = e->sel_active = 0;
     e->dirty = false;
+    e->undo = e->redo = NULL;
+    e->undo_n = e->undo_cap = e->redo_n = e->redo_cap = 0;
+    e->last_op = EDIT_OP_NONE; e->last_cursor = 0;
+}
+
+void editor_clear_history(editor_t *e){
+    undo_clear(e->undo, &e->undo_n);
+    undo_clear(e->redo, &e->redo_n);
+    e->last_op = EDIT_OP_NONE;
+}
+
+void editor_free(editor_t *e){
+    editor_clear_history(e);
+    free(e->undo); free(e->redo);
+    e->undo = e->redo = NULL;
+    e->undo_cap = e->redo_cap = 0;
+}
+
+static void restore_from(editor_t *e, editor_undo_t *from, int *from_n,
+                         editor_undo_t **to, int *to_n, int *to_cap){
+    editor_undo_t step = from[--(*from_n)];
+    undo_push(to, to_n, to_cap, buf_snapshot(e->doc), e->cursor);
+    buf_restore(e->doc, &step.snap);
+    buf_snap_release(&step.snap);
+    e->cursor = step.cursor <= e->doc->len ? step.cursor : e->doc->len;
+    editor_clear_selection(e);
+    e->last_op = EDIT_OP_NONE;
+    e->dirty = true;
 }
 
+bool editor_undo(editor_t *e){
+    if(e->undo_n == 0) return false;
+    restore_from(e, e->undo, &e->undo_n, &e->redo, &e->redo_n, &e->redo_cap);
+    return true;
+}
+
+bool editor_redo(editor_t *e){
+    if(e->redo_n == 0) return false;
+    restore_from(e, e->redo, &e->redo_n, &e->undo, &e->undo_n, &e->undo_cap);
+    return true;
+}
+
+void editor_replace_all(editor_t *e, const char *s, size_t n){
+    begin_edit(e, EDIT_OP_OTHER);
+    buf_replace_all(e->doc, s, n);
+    if(e->cursor > e->doc->len) e->cursor = e->doc->len;
+    editor_clear_selection(e);
+    end_edit(e);
+}
+
+/* ---------------- row/column helpers ---------------- */
+
 static int min_i(int a,int b){ return a<b?a:b; }
 
+// Row/offset math goes through the buffer's incremental line index:
+// row <-> offset conversions are O(log n) and index the file only as far as
+// the rows asked for; editor_total_lines() indexes all of it.
 int editor_total_lines(const buffer_t *doc){
-    int lines=1; for(size_t i=0;i<doc->len;i++) if(doc->data[i]=='\n') lines++;
-    return lines;
+    return (int)buf_line_count(doc);
 }
 
 size_t editor_line_start_index(const buffer_t *doc, int row){
-    size_t idx = 0; int r=0;
     if(row<=0) return 0;
-    for(size_t i=0;i<doc->len;i++){
-        if(doc->data[i]=='\n'){ r++; if(r==row){ idx=i+1; break; } }
-    }
-    return idx;
+    if(!buf_has_row(doc, (size_t)row)) return 0; // past the end, as before
+    return buf_line_start(doc, (size_t)row);
 }
 
 void editor_cursor_row_col(const editor_t *e, int *out_row, int *out_col){
-    int row=0, col=0;
-    for(size_t i=0;i<e->cursor && i<e->doc->len;i++){
-        char c = e->doc->data[i];
-        if(c=='\n'){ row++; col=0; }
-        else col++;
-    }
-    *out_row=row; *out_col=col;
+    size_t cur = e->cursor < e->doc->len ? e->cursor : e->doc->len;
+    size_t row = buf_line_of(e->doc, cur);
+    *out_row = (int)row;
+    *out_col = (int)(cur - buf_line_start(e->doc, row));
+}
+
+// End of row (offset of its '\n', or document length for the last row).
+static size_t line_end_index(const buffer_t *doc, size_t row){
+    if(!buf_has_row(doc, row + 1)) return doc->len;
+    return buf_line_start(doc, row + 1) - 1;
 }
 
 size_t editor_index_from_row_col(const buffer_t *doc, int row, int col){
     size_t idx = editor_line_start_index(doc, row);
-    for(int i=0;i<col && idx < doc->len; i++){
-        if(doc->data[idx]=='\n') break;
-        idx++;
-    }
-    return idx;
+    if(col <= 0) return idx;
+    size_t end = line_end_index(doc, buf_line_of(doc, idx));
+    return (end - idx > (size_t)col) ? idx + (size_t)col : end;
 }
 
+/* ---------------- edits ---------------- */
+
 void editor_insert_char(editor_t *e, char c){
-    buffer_t *b = e->doc;
-    ensure_cap(b, b->len + 2);
-    memmove(b->data + e->cursor + 1, b->data + e->cursor, b->len - e->cursor + 1);
-    b->data[e->cursor] = c;
-    e->cursor++; b->len++;
-    e->dirty = true;
+    begin_edit(e, c=='\n' ? EDIT_OP_OTHER : EDIT_OP_TYPE);
+    buf_insert(e->doc, e->cursor, &c, 1);
+    e->cursor++;
+    end_edit(e);
 }
 
 void editor_insert_text(editor_t *e, const char *s){
     if(!s || !*s) return;
     size_t n = strlen(s);
-    buffer_t *b = e->doc;
-    ensure_cap(b, b->len + n + 1);
-    memmove(b->data + e->cursor + n, b->data + e->cursor, b->len - e->cursor + 1);
-    memcpy(b->data + e->cursor, s, n);
-    e->cursor += n; b->len += n;
-    e->dirty = true;
+    begin_edit(e, EDIT_OP_OTHER);
+    buf_insert(e->doc, e->cursor, s, n);
+    e->cursor += n;
+    end_edit(e);
 }
 
 void editor_delete_range(editor_t *e, size_t a, size_t b){
     if(a > b) { size_t t=a; a=b; b=t; }
     if(b > e->doc->len) b = e->doc->len;
     if(a >= b) return;
-    buffer_t *buf = e->doc;
-    memmove(buf->data + a, buf->data + b, buf->len - b + 1);
-    buf->len -= (b - a);
+    begin_edit(e, EDIT_OP_OTHER);
+    buf_delete(e->doc, a, b);
     if(e->cursor > a) e->cursor = a;
-    e->dirty = true;
+    end_edit(e);
 }
 
 void editor_delete_selection(editor_t *e){
@@ -89,19 +165,18 @@ void editor_delete_selection(editor_t *e){
 void editor_backspace(editor_t *e){
     if(editor_has_selection(e)){ editor_delete_selection(e); return; }
     if(e->cursor == 0) return;
-    buffer_t *b = e->doc;
-    memmove(b->data + e->cursor - 1, b->data + e->cursor, b->len - e->cursor + 1);
-    e->cursor--; b->len--;
-    e->dirty = true;
+    begin_edit(e, EDIT_OP_OTHER);
+    buf_delete(e->doc, e->cursor - 1, e->cursor);
+    e->cursor--;
+    end_edit(e);
 }
 
 void editor_delete_forward(editor_t *e){
     if(editor_has_selection(e)){ editor_delete_selection(e); return; }
     if(e->cursor >= e->doc->len) return;
-    buffer_t *b = e->doc;
-    memmove(b->data + e->cursor, b->data + e->cursor + 1, b->len - e->cursor);
-    b->len--;
-    e->dirty = true;
+    begin_edit(e, EDIT_OP_OTHER);
+    buf_delete(e->doc, e->cursor, e->cursor + 1);
+    end_edit(e);
 }
 
 void editor_move_left(editor_t *e){ if(e->cursor>0) e->cursor--; }
@@ -115,9 +190,8 @@ void editor_move_up(editor_t *e){
     e->cursor = editor_index_from_row_col(e->doc, row-1, new_col);
 }
 void editor_move_down(editor_t *e){
-    int rows = editor_total_lines(e->doc);
     int row,col; editor_cursor_row_col(e,&row,&col);
-    if(row >= rows-1) return;
+    if(!buf_has_row(e->doc, (size_t)row + 1)) return;
     int next_len = (int)(editor_index_from_row_col(e->doc, row+1, 999999) - editor_line_start_index(e->doc, row+1));
     int new_col = min_i(col, next_len);
     e->cursor = editor_index_from_row_col(e->doc, row+1, new_col);
@@ -132,11 +206,10 @@ void editor_move_end(editor_t *e){
 }
 
 void editor_scroll_lines(editor_t *e, int delta_rows){
-    int total = editor_total_lines(e->doc);
-    if(total < 1) total = 1;
     int nt = e->top_line + delta_rows;
     if(nt < 0) nt = 0;
-    if(nt > total-1) nt = total-1;
+    // Past the end only once the whole file is indexed, so counting is O(1) then
+    if(!buf_has_row(e->doc, (size_t)nt)) nt = (int)buf_line_count(e->doc) - 1;
     e->top_line = nt;
 }
 
@@ -86,3 +86,25 @@ size_t idy_env_parse_size(const char *key, size_t def_value){
     free(s);
     return (size_t)val;
 }
+
+/* Parse a plain decimal count ("0", "250"); no unit suffixes, so line and
+   item counts cannot be scaled by accident. Returns def_value if unset or
+   not entirely digits; saturates at SIZE_MAX. */
+size_t idy_env_parse_count(const char *key, size_t def_value){
+    char *s = idy_getenv_trimdup(key);
+    if(!s) return def_value;
+
+    const char *p = s;
+    size_t val = 0;
+    for(; *p; p++){
+        if(!isdigit((unsigned char)*p)){
+            free(s);
+            return def_value;
+        }
+        unsigned d = (unsigned)(*p - '0');
+        val = (val > (SIZE_MAX - d) / 10) ? SIZE_MAX : val * 10 + d;
+    }
+
+    free(s);
+    return val;
+}
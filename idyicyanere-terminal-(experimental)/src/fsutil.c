@@ -1,5 +1,10 @@
 #include "fsutil.h"
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdlib.h>
 
 bool fs_is_dir(const char *p){
     struct stat st;
@@ -10,3 +15,52 @@ bool fs_is_file(const char *p){
     struct stat st;
     return (p && stat(p, &st) == 0 && S_ISREG(st.st_mode));
 }
+
+/* ---------- whole-file views ---------- */
+
+static bool read_all_fd(int fd, size_t sz, fs_view_t *v){
+    char *buf = (char*)malloc(sz + 1);
+    if(!buf){ errno = ENOMEM; return false; }
+    size_t got = 0;
+    while(got < sz){
+        ssize_t r = read(fd, buf + got, sz - got);
+        if(r < 0){ if(errno == EINTR) continue; free(buf); return false; }
+        if(r == 0) break; // shrank underneath us: keep what we have
+        got += (size_t)r;
+    }
+    buf[got] = '\0';
+    v->data = buf; v->len = got; v->mapped = false;
+    return true;
+}
+
+bool fs_view_open(fs_view_t *v, const char *path){
+    v->data = NULL; v->len = 0; v->mapped = false;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if(fd < 0) return false;
+    struct stat st;
+    if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)){
+        if(errno == 0) errno = EINVAL;
+        close(fd); return false;
+    }
+    size_t sz = (size_t)st.st_size;
+    bool ok = false;
+    if(sz >= FS_MAP_MIN_BYTES){
+        void *p = mmap(NULL, sz, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(p != MAP_FAILED){
+            v->data = (const char*)p; v->len = sz; v->mapped = true;
+            ok = true;
+        }
+    }
+    if(!ok) ok = read_all_fd(fd, sz, v); // small file, or mmap refused (e.g. procfs)
+    int saved = errno;
+    close(fd);
+    errno = saved;
+    return ok;
+}
+
+void fs_view_close(fs_view_t *v){
+    if(!v || !v->data) return;
+    if(v->mapped) munmap((void*)v->data, v->len);
+    else free((void*)v->data);
+    v->data = NULL; v->len = 0; v->mapped = false;
+}
@@ -2,40 +2,79 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
 #include <time.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+typedef struct {
+    size_t cap;        // ring capacity
+    size_t count;      // number of valid items (<= cap)
+    size_t head;       // next write index
+    log_entry_t *v;    // ring storage
+    char *slab;        // cap * LOG_MSG_MAX bytes of message text
+    pthread_t owner;   // only this thread writes the ring
+} logger_t;
+
+/* Bounded MPSC queue (per-cell sequence numbers, Vyukov style):
+   a producer claims a cell by CAS on `enq`, formats into it and publishes it
+   by bumping the cell's seq; the single consumer takes cells in order. */
+typedef struct {
+    _Atomic size_t seq;
+    log_entry_t e;
+    char text[LOG_MSG_MAX];
+} log_cell_t;
+
+typedef struct {
+    log_cell_t *cells;
+    _Atomic size_t enq;
+    size_t deq;                 // consumer-private
+    _Atomic size_t dropped;
+} log_queue_t;
 
 static logger_t G;
+static log_queue_t Q;
+static _Atomic int g_min_level = LOG_TRACE;
+static uint64_t g_next_seq = 1;      // owner thread only
 
 /* Hard bounds to avoid runaway allocations even if misconfigured */
 #define LOG_CAP_MIN 128
 #define LOG_CAP_MAX 65536
 
-static char* vformat(const char *fmt, va_list ap){
-    va_list ap2; va_copy(ap2, ap);
-    int n = vsnprintf(NULL, 0, fmt, ap2); va_end(ap2);
-    if(n<0) return NULL;
-    char *s = (char*)malloc((size_t)n+1);
-    vsnprintf(s, (size_t)n+1, fmt, ap);
-    return s;
-}
-
 void log_init(size_t capacity){
     if(capacity < LOG_CAP_MIN) capacity = LOG_CAP_MIN;
     if(capacity > LOG_CAP_MAX) capacity = LOG_CAP_MAX;
-    memset(&G,0,sizeof(G));
+    log_shutdown();
     G.cap = capacity;
-    G.min_level = LOG_INFO;
+    G.owner = pthread_self();
     G.v = (log_entry_t*)calloc(G.cap, sizeof(log_entry_t));
+    G.slab = (char*)malloc(G.cap * LOG_MSG_MAX);
+    Q.cells = (log_cell_t*)malloc(sizeof(log_cell_t) * LOG_QUEUE_CAP);
+    if(!G.v || !G.slab || !Q.cells){
+        free(G.v); free(G.slab); free(Q.cells);
+        memset(&G,0,sizeof(G)); Q.cells = NULL;
+        return;
+    }
+    for(size_t i=0;i<G.cap;i++){
+        char *s = G.slab + i*LOG_MSG_MAX;
+        s[0] = 0;
+        G.v[i].msg = s;
+    }
+    for(size_t i=0;i<LOG_QUEUE_CAP;i++) atomic_init(&Q.cells[i].seq, i);
+    atomic_store(&Q.enq, 0);
+    atomic_store(&Q.dropped, 0);
+    Q.deq = 0;
 }
 
 void log_shutdown(void){
     if(!G.v) return;
-    for(size_t i=0;i<G.cap;i++) if(G.v[i].msg) free((void*)G.v[i].msg);
-    free(G.v); memset(&G,0,sizeof(G));
+    free(G.v); free(G.slab); free(Q.cells);
+    memset(&G,0,sizeof(G)); Q.cells = NULL;
 }
 
-void log_set_level(log_level_t lvl){ G.min_level = lvl; }
-log_level_t log_get_level(void){ return G.min_level; }
+void log_set_level(log_level_t lvl){ atomic_store_explicit(&g_min_level, (int)lvl, memory_order_relaxed); }
+log_level_t log_get_level(void){ return (log_level_t)atomic_load_explicit(&g_min_level, memory_order_relaxed); }
+int log_enabled(log_level_t lvl){ return (int)lvl >= atomic_load_explicit(&g_min_level, memory_order_relaxed); }
 
 const char* log_level_name(log_level_t lvl){
     switch(lvl){
@@ -48,36 +87,127 @@ const char* log_level_name(log_level_t lvl){
     }
 }
 
+log_level_t log_level_parse(const char *name, log_level_t def){
+    if(!name || !*name) return def;
+    if(name[0]>='0' && name[0]<='4' && name[1]==0) return (log_level_t)(name[0]-'0');
+    for(int l=LOG_TRACE; l<=LOG_ERROR; l++)
+        if(!strcasecmp(name, log_level_name((log_level_t)l))) return (log_level_t)l;
+    if(!strcasecmp(name, "warning")) return LOG_WARN;
+    return def;
+}
+
+// Message of `total` bytes did not fit in its slot: end it with a marker, cut on a UTF-8 boundary.
+static void mark_truncated(char *s, size_t total){
+    char mark[40];
+    int ml = snprintf(mark, sizeof(mark), " ...[+%zu bytes]", total);
+    size_t keep = LOG_MSG_MAX - 1 - (size_t)ml;
+    while(keep > 0 && ((unsigned char)s[keep] & 0xC0) == 0x80) keep--;
+    ml = snprintf(mark, sizeof(mark), " ...[+%zu bytes]", total - keep);
+    memcpy(s + keep, mark, (size_t)ml + 1);
+}
+
+// Single vsnprintf into a fixed slot.
+static void format_into(char *s, const char *fmt, va_list ap){
+    int n = vsnprintf(s, LOG_MSG_MAX, fmt, ap);
+    if(n < 0) snprintf(s, LOG_MSG_MAX, "(log format error: %s)", fmt);
+    else if((size_t)n >= LOG_MSG_MAX) mark_truncated(s, (size_t)n);
+}
+
+// Owner thread: claim the next ring slot (its text buffer is recycled in place).
+static log_entry_t* ring_push(log_level_t lvl, const struct timespec *ts, const char *file, int line){
+    log_entry_t *e = &G.v[G.head];
+    e->seq = g_next_seq++;
+    e->level = lvl; e->ts = *ts; e->src_file = file; e->src_line = line;
+    G.head = (G.head + 1) % G.cap;
+    if(G.count < G.cap) G.count++;
+    return e;
+}
+
+static void ring_put(log_level_t lvl, const char *file, int line, const char *fmt, ...){
+    struct timespec ts; timespec_get(&ts, TIME_UTC);
+    log_entry_t *e = ring_push(lvl, &ts, file, line);
+    va_list ap; va_start(ap, fmt);
+    format_into((char*)e->msg, fmt, ap);
+    va_end(ap);
+}
+
+size_t log_drain(void){
+    if(!G.v || !Q.cells) return 0;
+    size_t moved = 0;
+    for(;;){
+        log_cell_t *c = &Q.cells[Q.deq & (LOG_QUEUE_CAP - 1)];
+        size_t seq = atomic_load_explicit(&c->seq, memory_order_acquire);
+        if(seq != Q.deq + 1) break;   // empty, or the producer is still formatting
+        log_entry_t *e = ring_push(c->e.level, &c->e.ts, c->e.src_file, c->e.src_line);
+        memcpy((char*)e->msg, c->text, strlen(c->text) + 1);
+        atomic_store_explicit(&c->seq, Q.deq + LOG_QUEUE_CAP, memory_order_release);
+        Q.deq++;
+        moved++;
+    }
+    size_t dropped = atomic_exchange(&Q.dropped, 0);
+    if(dropped){
+        ring_put(LOG_WARN, __FILE__, __LINE__, "%zu log message(s) from worker threads dropped (queue full)", dropped);
+        moved++;
+    }
+    return moved;
+}
+
 void log_msg_(log_level_t lvl, const char *file, int line, const char *fmt, ...){
     if(!G.v) log_init(LOG_CAP_MIN);
+    if(!G.v || !log_enabled(lvl)) return;
     struct timespec ts;
     timespec_get(&ts, TIME_UTC); // C11; avoids CLOCK_REALTIME portability issues
     va_list ap; va_start(ap, fmt);
-    char *s = vformat(fmt, ap);
+
+    if(pthread_equal(pthread_self(), G.owner)){
+        // Keep order with what workers queued before us, then format in place: no allocation
+        log_drain();
+        log_entry_t *e = ring_push(lvl, &ts, file, line);
+        format_into((char*)e->msg, fmt, ap);
+        va_end(ap);
+        return;
+    }
+
+    size_t pos = atomic_load_explicit(&Q.enq, memory_order_relaxed);
+    log_cell_t *c;
+    for(;;){
+        c = &Q.cells[pos & (LOG_QUEUE_CAP - 1)];
+        size_t seq = atomic_load_explicit(&c->seq, memory_order_acquire);
+        if(seq == pos){
+            if(atomic_compare_exchange_weak_explicit(&Q.enq, &pos, pos + 1,
+                                                     memory_order_relaxed, memory_order_relaxed)) break;
+        } else if(seq < pos){
+            atomic_fetch_add_explicit(&Q.dropped, 1, memory_order_relaxed); // full
+            va_end(ap);
+            return;
+        } else {
+            pos = atomic_load_explicit(&Q.enq, memory_order_relaxed);
+        }
+    }
+    c->e.level = lvl; c->e.ts = ts; c->e.src_file = file; c->e.src_line = line;
+    format_into(c->text, fmt, ap);
     va_end(ap);
+    atomic_store_explicit(&c->seq, pos + 1, memory_order_release);
+}
 
-    size_t i = G.head % G.cap;
-    if(G.v[i].msg) free((void*)G.v[i].msg);
-    G.v[i].level = lvl; G.v[i].ts = ts;
-    G.v[i].src_file = file; G.v[i].src_line = line; G.v[i].msg = s;
+uint64_t log_next_seq(void){ return g_next_seq; }
+uint64_t log_oldest_seq(void){ return g_next_seq - G.count; }
 
-    G.head = (G.head + 1) % G.cap;
-    if(G.count < G.cap) G.count++;
+log_iter_t log_iter_from(uint64_t seq, log_level_t filter){
+    if(G.v && pthread_equal(pthread_self(), G.owner)) log_drain();
+    log_iter_t it = { seq, filter };
+    return it;
 }
 
-size_t log_snapshot(log_level_t filter, log_entry_t **out){
-    if(!G.v){ *out=NULL; return 0; }
-    // First compute how many meet the filter
-    size_t n_ok=0;
-    for(size_t k=0;k<G.count;k++){
-        size_t idx = (G.head + G.cap - G.count + k) % G.cap;
-        if(G.v[idx].level >= filter) n_ok++;
-    }
-    *out = (log_entry_t*)malloc(sizeof(log_entry_t)*n_ok);
-    size_t w=0;
-    for(size_t k=0;k<G.count;k++){
-        size_t idx = (G.head + G.cap - G.count + k) % G.cap;
-        if(G.v[idx].level >= filter){ (*out)[w++] = G.v[idx]; }
+const log_entry_t* log_iter_next(log_iter_t *it){
+    if(!G.v) return NULL;
+    if(it->seq < log_oldest_seq()) it->seq = log_oldest_seq();
+    // Sequence numbers are contiguous in the ring: seq s sits (next - s) slots behind head
+    while(it->seq < g_next_seq){
+        size_t back = (size_t)(g_next_seq - it->seq);
+        const log_entry_t *e = &G.v[(G.head + G.cap - back) % G.cap];
+        it->seq++;
+        if(e->level >= it->filter) return e;
     }
-    return n_ok;
+    return NULL;
 }
@@ -10,6 +10,8 @@
 #include "preview.h"
 #include "file_context.h"
 #include "fsutil.h"
+#include "dirwalk.h"
+#include "rag.h"
 #include <libgen.h>
 #include <limits.h>
 #include <time.h>
@@ -21,6 +23,8 @@ static log_level_t LOG_FILTER = LOG_INFO;
 static char CWD[PATH_MAX];         // current directory in Context view
 static int  SEL_INDEX = 0;         // selection in Context list
 static file_list_t FL = {0};
+static dirwalk_t  *WALK = NULL;    // background listing of CWD into FL (kept until the next cd)
+static bool        WALK_SETTLED = false;
 
 // Current open file path (for editor buffer)
 static char CURRENT_FILE[PATH_MAX]; // empty string if unnamed
@@ -30,11 +34,14 @@ static bool HAS_CURRENT_FILE = false;
 static char **CTX_FILES = NULL;
 static int    CTX_COUNT = 0;
 
-// Context preview (rendered text) + scroll
-static char *CTX_PREVIEW = NULL;
-static int   CTX_PREVIEW_LINES = 0;
+// Context preview (rendered text + line index) + scroll
+static preview_t CTX_PREVIEW = {0};
 static int   CTX_SCROLL = 0;
 
+// Retrieval index over the context selection (opened on first use)
+static rag_t *RAG = NULL;
+static bool   RAG_FAILED = false;   // no index location: stay on the full preview this session
+
 // Logs view scroll offset (in visual rows from bottom; 0 = follow tail)
 static int   LOG_SCROLL = 0;
 
@@ -44,6 +51,7 @@ static int   LOG_RHS_SCROLL = 0;
 // Blink timer
 static bool BLINK_STATE=false;
 static struct timespec BLINK_LAST;
+static struct timespec FRAME_LAST;   // last time a full frame was presented
 
 /* === stream callbacks === */
 static void on_delta_cb(const char *token, void *user){
@@ -89,6 +97,24 @@ static void start_blink_timer(void){
     BLINK_STATE=false;
 }
 
+static long ms_since(const struct timespec *then){
+    struct timespec now; timespec_get(&now, TIME_UTC);
+    return (now.tv_sec - then->tv_sec)*1000L + (now.tv_nsec - then->tv_nsec)/1000000L;
+}
+
+// Draw whichever screen is active. Panes only repaint what changed since the last frame.
+static void present_frame(tui_t *T, editor_t *ed, const idy_config_t *cfg){
+    if(g_screen==SCREEN_EDITOR){
+        const char *fp = HAS_CURRENT_FILE ? CURRENT_FILE : "(untitled)";
+        tui_draw_editor(T, ed, RIGHTBUF, STATUS, fp);
+    } else if(g_screen==SCREEN_LOGS){
+        tui_draw_logs(T, LOG_FILTER, STATUS, &LOG_SCROLL, &LOG_RHS_SCROLL);
+    } else {
+        tui_draw_context(T, CWD, &FL, SEL_INDEX, cfg, CTX_FILES, CTX_COUNT, &CTX_PREVIEW, CTX_SCROLL, STATUS);
+    }
+    timespec_get(&FRAME_LAST, TIME_UTC);
+}
+
 /* ===== Editor selection helpers for CTRL-C/V and SHIFT+arrows ===== */
 static void extend_selection_move(editor_t *ed, void (*move_fn)(editor_t*)){
     size_t anchor = editor_has_selection(ed) ? ed->sel_anchor : ed->cursor;
@@ -124,9 +150,14 @@ static bool save_current_buffer(editor_t *ed, const char *cwd){
     }
 }
 
-// Helper: short hex of SHA-256 for logs
-static void hex8_of_doc(const buffer_t *b, char out[9]){
-    char h[65]; sha256_hex((const unsigned char*)b->data, b->len, h);
+// Helper: short hex of SHA-256 for logs (streams the pieces; skipped if nothing would log it)
+static void hex8_of_doc(buffer_t *b, char out[9]){
+    if(!log_enabled(LOG_INFO)){ strcpy(out, "-"); return; }
+    sha256_ctx_t c; sha256_init(&c);
+    const char *p;
+    for(size_t pos=0, n; (n = buf_chunk(b, pos, &p)) > 0; pos += n) sha256_update(&c, p, n);
+    uint8_t dig[32]; char h[65];
+    sha256_final(&c, dig); sha256_to_hex(dig, h);
     memcpy(out, h, 8); out[8]=0;
 }
 
@@ -135,8 +166,9 @@ static void hex8_of_doc(const buffer_t *b, char out[9]){
 // Returns malloc'ed string (caller frees). For empty docs, returns strdup("").
 static int dec_digits_(int n){ int d=1; while(n>=10){ n/=10; d++; } return d; }
 
-static char* build_numbered_original(const buffer_t *b){
-    if(!b || !b->data || b->len == 0) return strdup("");
+static char* build_numbered_original(buffer_t *b){
+    if(!b || b->len == 0) return strdup("");
+    const char *data = buf_data(b);
     int total_lines = editor_total_lines(b);
     int digits = dec_digits_(total_lines);
 
@@ -150,7 +182,7 @@ static char* build_numbered_original(const buffer_t *b){
     w += sprintf(w, "%*d| ", digits, line);
 
     for(size_t i=0; i<b->len; ++i){
-        char c = b->data[i];
+        char c = data[i];
         *w++ = c;
         if(c == '\n' && i + 1 < b->len){
             line++;
@@ -162,23 +194,143 @@ static char* build_numbered_original(const buffer_t *b){
 }
 
 
+/* Multi-file patch (Ctrl-A when the diff has several file sections, or one
+   that is not the open document).
+   The section for the open document ("original.tex" or its real path) is applied
+   to the editor buffer; every other section goes to disk under CWD. The buffer is
+   only replaced once all files on disk were committed, so a failure changes nothing. */
+static bool is_editor_section(const patch_file_t *f){
+    const char *p = f->new_path;
+    if(!strcmp(p, "original.tex")) return true;
+    if(!HAS_CURRENT_FILE) return false;
+    if(!strcmp(p, CURRENT_FILE)) return true;
+    char full[PATH_MAX*2]; snprintf(full, sizeof(full), "%s/%s", CWD, p);
+    return !strcmp(full, CURRENT_FILE);
+}
+
+static void apply_patch_set(editor_t *ed, patch_set_t *ps, diff_apply_opts_t *aopts){
+    char *buf_out = NULL, *err = NULL;
+    int relocated = 0, on_disk = 0;
+    for(size_t i=0;i<ps->count;i++){
+        patch_file_t *f = &ps->files[i];
+        if(!is_editor_section(f)){ on_disk++; continue; }
+        f->skip = true;
+        if(buf_out){ err = strdup("open document patched twice"); break; }
+        if(!apply_unified_diff_opts(buf_data(ed->doc), f->body, aopts, &buf_out, &err)) break;
+        relocated += aopts->relocated;
+    }
+    int disk_relocated = 0;
+    if(!err && on_disk && !patch_set_apply(ps, CWD, aopts, 0, &disk_relocated, &err) && !err)
+        err = strdup("(unknown)");
+    if(err){
+        LOG_ERROR("Multi-file patch failed: %s", err);
+        free(STATUS); asprintf(&STATUS, "Patch failed: %s", err);
+        free(err); free(buf_out);
+        return;
+    }
+    if(buf_out){ editor_replace_all(ed, buf_out, strlen(buf_out)); free(buf_out); }
+    relocated += disk_relocated;
+    LOG_INFO("Multi-file patch applied: files=%zu (on disk=%d), relocated hunks=%d", ps->count, on_disk, relocated);
+    free(STATUS); asprintf(&STATUS, "Patched %zu file(s)%s.", ps->count, relocated ? " (some hunks relocated)" : "");
+}
+
+/* Context tree: (re)list CWD in the background; FL fills in as directories
+   are read (see poll_listing), so the screen appears before the walk ends. */
+static void start_listing(void){
+    dirwalk_free(WALK);
+    free_file_list(&FL);
+    WALK = dirwalk_start(CWD);
+    WALK_SETTLED = false;
+    if(!WALK) LOG_WARN("Cannot list %s", CWD);
+}
+
+// Refresh FL from the walker; keeps the selection on the same entry. True if FL changed.
+static bool poll_listing(void){
+    if(!WALK) return false;
+    char *sel = (SEL_INDEX >= 0 && SEL_INDEX < FL.count) ? strdup(FL.items[SEL_INDEX].name) : NULL;
+    bool changed = dirwalk_poll(WALK, &FL);
+    if(changed && sel){
+        for(int i=0;i<FL.count;i++) if(!strcmp(FL.items[i].name, sel)){ SEL_INDEX = i; break; }
+    }
+    if(SEL_INDEX >= FL.count) SEL_INDEX = FL.count > 0 ? FL.count-1 : 0;
+    free(sel);
+    return changed;
+}
+
+/* Context for a suggestion request: the chunks of the selection nearest to the
+   editor selection (or the text around the cursor), or NULL to send the whole
+   preview. Retrieval only kicks in when the preview would not fit as-is;
+   IDY_RAG_TOPK=0 turns it off. Any failure (including an index held by another
+   instance) is logged and falls back for this request only. The index file is
+   keyed by the workspace (CWD at first use) and closed again before returning. */
+static char* retrieved_context(const editor_t *ed, idy_config_t *cfg, int *out_chunks){
+    size_t topk = idy_env_parse_count("IDY_RAG_TOPK", RAG_TOPK_DEFAULT);
+    if(topk > 65535) topk = 65535;  // rag_query's limit; keeps topk * chunk in range
+    size_t chunk = idy_env_parse_size("IDY_RAG_CHUNK", RAG_CHUNK_DEFAULT);
+    size_t max_ctx = cfg->prompt_max_ctx ? cfg->prompt_max_ctx : IDY_PROMPT_MAX_CTX;
+    if(topk == 0 || CTX_COUNT == 0 || RAG_FAILED || !cfg->api_key || !*cfg->api_key) return NULL;
+    size_t want = topk * chunk < max_ctx ? topk * chunk : max_ctx;
+    if(CTX_PREVIEW.len <= want) return NULL;
+
+    if(!RAG){
+        char *db = idy_getenv_trimdup("IDY_RAG_DB");
+        RAG = rag_open(db, CWD);
+        free(db);
+        if(!RAG){ RAG_FAILED = true; return NULL; }
+    }
+    char *err = NULL;
+    if(!rag_sync(RAG, cfg, CTX_FILES, CTX_COUNT, chunk, &err)){
+        LOG_WARN("Retrieval: %s; sending the full context", err ? err : "index update failed");
+        free(err);
+        rag_release(RAG);
+        return NULL;
+    }
+
+    // Query: the selection, else the text around the cursor
+    const buffer_t *doc = ed->doc;
+    size_t a, b;
+    if(editor_has_selection(ed)){
+        editor_get_selection(ed, &a, &b);
+        if(b - a > 8192) b = a + 8192;
+    } else {
+        a = ed->cursor > 4096 ? ed->cursor - 4096 : 0;
+        b = ed->cursor + 4096 < doc->len ? ed->cursor + 4096 : doc->len;
+    }
+    char *query = buf_strndup(doc, a, b);
+    if(!query || !*query){ free(query); rag_release(RAG); return NULL; }
+    char *out = rag_query(RAG, cfg, query, (int)topk, max_ctx, out_chunks, &err);
+    free(query);
+    rag_release(RAG);
+    if(!out){
+        LOG_WARN("Retrieval: %s; sending the full context", err ? err : "query failed");
+        free(err);
+    }
+    return out;
+}
+
+// dirwalk_apply_events callback: a file under CWD changed; flags it if it is in the context.
+static void on_tree_file(const char *rel, void *user){
+    char *abs = NULL;
+    size_t n = strlen(CWD);
+    if(asprintf(&abs, "%s%s%s", CWD, (n && CWD[n-1]=='/') ? "" : "/", rel) < 0) return;
+    if(ctx_has(CTX_FILES, CTX_COUNT, abs)){ preview_mark_dirty(abs); *(bool*)user = true; }
+    free(abs);
+}
+
 /* Open the item at `selpath` exactly like pressing Enter in Context.
    - Dir: cd into it (rebuild listing + keep on Context, rebuild preview)
    - File: open into editor (switch screen) */
 static void open_item_by_path(const char *selpath, editor_t *ed, bool *need_preview_rebuild){
     if(!selpath) return;
     if(fs_is_dir(selpath)){
-        free_file_list(&FL);
         realpath(selpath, CWD);
-        list_dir(CWD,&FL);
         SEL_INDEX = 0;
+        start_listing();
         if(need_preview_rebuild) *need_preview_rebuild = true;
         LOG_DEBUG("cd %s", CWD);
     } else if(fs_is_file(selpath)){
-        buffer_t newdoc; buf_init(&newdoc);
-        if(buf_load_file(&newdoc, selpath)){
-            free(ed->doc->data);
-            *ed->doc = newdoc;
+        if(buf_load_file(ed->doc, selpath)){
+            editor_clear_history(ed);
             ed->cursor = 0; ed->top_line=0; ed->left_col=0;
             ed->sel_anchor=ed->sel_active=0; ed->dirty=false;
             snprintf(CURRENT_FILE, sizeof(CURRENT_FILE), "%s", selpath);
@@ -239,6 +391,18 @@ int main(int argc, char **argv){
     };
     if(!cfg.api_key){ fprintf(stderr,"OPENAI_API_KEY is required\n"); return 1; }
 
+    // IDY_MULTI_FILE=1: let the model also patch the CONTEXT files (applied with Ctrl-A as one patch set)
+    char *multi_prompt = NULL;
+    if(idy_env_truthy("IDY_MULTI_FILE")){
+        asprintf(&multi_prompt, "%s"
+            "MULTI-FILE MODE: You MAY also change files shown in CONTEXT. Emit one section per changed file, each starting with its own"
+            " '--- <path>' and '+++ <path>' lines, where <path> is exactly the path from that file's '===== FILE: <path>' header."
+            " The ORIGINAL stays 'original.tex'. For CONTEXT files, line 1 is the first line inside the code fence, and there are no numeric prefixes."
+            " Rules 1-8 apply to every section.",
+            cfg.system_prompt_unified_diff);
+        if(multi_prompt) cfg.system_prompt_unified_diff = multi_prompt;
+    }
+
     // Resolve prompt caps from env (bytes). Defaults come from stream.h.
     cfg.prompt_max_orig = idy_env_parse_size("IDY_PROMPT_MAX_ORIG", IDY_PROMPT_MAX_ORIG);
     cfg.prompt_max_ctx  = idy_env_parse_size("IDY_PROMPT_MAX_CTX",  IDY_PROMPT_MAX_CTX);
@@ -256,6 +420,10 @@ int main(int argc, char **argv){
         free(cap_s);
     }
     log_init((size_t)cap);
+    // IDY_LOG_LEVEL: drop messages below this level before they are formatted (default: keep all)
+    char *lvl_s = idy_getenv_trimdup("IDY_LOG_LEVEL");
+    log_set_level(log_level_parse(lvl_s, LOG_TRACE));
+    free(lvl_s);
     LOG_INFO("idyicyanere starting (v%s)", IDY_VERSION);
     LOG_DEBUG("Prompt caps (effective): orig=%zu bytes, ctx=%zu bytes",
               (size_t)cfg.prompt_max_orig, (size_t)cfg.prompt_max_ctx);
@@ -273,7 +441,7 @@ int main(int argc, char **argv){
     if(fs_is_dir(startpath)){
         snprintf(CWD, sizeof(CWD), "%s", startpath);
         g_screen = SCREEN_CONTEXT;
-        list_dir(CWD, &FL);
+        start_listing();
         LOG_INFO("Started in directory mode (Context): %s", CWD);
     } else if(fs_is_file(startpath)){
         if(!buf_load_file(&doc, startpath)){ fprintf(stderr,"failed to read %s\n",startpath); return 1; }
@@ -291,38 +459,57 @@ int main(int argc, char **argv){
     start_blink_timer();
 
     // First draw
-    if(g_screen == SCREEN_EDITOR){
-        const char *fp = HAS_CURRENT_FILE ? CURRENT_FILE : "(untitled)";
-        tui_draw_editor(&T, &ed, RIGHTBUF, STATUS, fp);
-    } else {
-        free(CTX_PREVIEW);
-        CTX_PREVIEW = preview_build(CWD, CTX_FILES, CTX_COUNT, &CTX_PREVIEW_LINES);
-        if(CTX_SCROLL > CTX_PREVIEW_LINES) CTX_SCROLL = CTX_PREVIEW_LINES;
-        tui_draw_context(&T, CWD, &FL, SEL_INDEX, &cfg, CTX_FILES, CTX_COUNT, CTX_PREVIEW, CTX_SCROLL, STATUS);
+    if(g_screen != SCREEN_EDITOR){
+        preview_build(&CTX_PREVIEW, CWD, CTX_FILES, CTX_COUNT);
+        if(CTX_SCROLL > CTX_PREVIEW.lines) CTX_SCROLL = CTX_PREVIEW.lines;
     }
+    present_frame(&T, &ed, &cfg);
 
-    int ch; bool running=true;
+    // Keys only mark the frame dirty; it is presented once the input queue drains
+    // (or at most every TUI_FRAME_MS while keys keep arriving, e.g. during a paste).
+    int ch; bool running=true; bool frame_dirty=false;
     while(running){
         // Blink timer
         struct timespec now; timespec_get(&now, TIME_UTC);
-        long ms = (now.tv_sec - BLINK_LAST.tv_sec)*1000L + (now.tv_nsec - BLINK_LAST.tv_nsec)/1000000L;
-        bool need_redraw = false;
-        if(ms >= 500){
+        bool blink_flip = false;
+        if(ms_since(&BLINK_LAST) >= 500){
             BLINK_STATE = !BLINK_STATE; T.blink_on = BLINK_STATE; BLINK_LAST = now;
-            if(g_screen==SCREEN_EDITOR) need_redraw = true;
+            blink_flip = (g_screen==SCREEN_EDITOR);
         }
 
+        // Messages queued by worker threads land in the ring here (UI thread owns it)
+        if(log_drain() && g_screen==SCREEN_LOGS) frame_dirty = true;
+        if(WALK && !WALK_SETTLED){
+            bool done = dirwalk_done(WALK); // sampled first, so this poll sees the whole tree
+            if(poll_listing() && g_screen==SCREEN_CONTEXT) frame_dirty = true;
+            if(done){
+                WALK_SETTLED = true;
+                LOG_DEBUG("Context tree: %zu entries under %s", dirwalk_entries(WALK), CWD);
+                if(!dirwalk_watch(WALK)) LOG_WARN("Context tree: live updates unavailable for %s", CWD);
+            }
+        } else if(WALK){
+            // Live updates: apply file system events to FL and refresh the preview
+            // when a file in the context was written
+            bool ctx_touched = false;
+            int rc = dirwalk_apply_events(WALK, on_tree_file, &ctx_touched);
+            if(rc < 0){ LOG_DEBUG("Context tree: events lost, relisting %s", CWD); start_listing(); }
+            else if(rc > 0 && poll_listing() && g_screen==SCREEN_CONTEXT) frame_dirty = true;
+            if(ctx_touched && g_screen==SCREEN_CONTEXT){
+                preview_build(&CTX_PREVIEW, CWD, CTX_FILES, CTX_COUNT);
+                if(CTX_SCROLL > CTX_PREVIEW.lines) CTX_SCROLL = CTX_PREVIEW.lines;
+                frame_dirty = true;
+            }
+        }
+
+        timeout(frame_dirty ? 0 : 60);
         ch = getch();
         if(ch==ERR){
-            if(need_redraw){
-                if(g_screen==SCREEN_EDITOR){
-                    const char *fp = HAS_CURRENT_FILE ? CURRENT_FILE : "(untitled)";
-                    tui_draw_editor(&T, &ed, RIGHTBUF, STATUS, fp);
-                }
-            }
+            if(frame_dirty){ present_frame(&T, &ed, &cfg); frame_dirty = false; }
+            else if(blink_flip){ tui_blink_caret(&T); }
             continue;
         }
 
+        frame_dirty = true;
         if(ch==KEY_RESIZE){ tui_resize(&T); }
         else if((ch==17)){ running=false; break; } // Ctrl-Q
 
@@ -330,10 +517,9 @@ int main(int argc, char **argv){
         else if(ch==KEY_F(1)){ g_screen=SCREEN_EDITOR; LOG_TRACE("Switch to Editor"); }
         else if(ch==KEY_F(2)){
             g_screen=SCREEN_CONTEXT; LOG_TRACE("Switch to Context");
-            if(!FL.items){ list_dir(CWD, &FL); }
-            free(CTX_PREVIEW);
-            CTX_PREVIEW = preview_build(CWD, CTX_FILES, CTX_COUNT, &CTX_PREVIEW_LINES);
-            if(CTX_SCROLL > CTX_PREVIEW_LINES) CTX_SCROLL = CTX_PREVIEW_LINES;
+            if(!WALK){ start_listing(); }
+            preview_build(&CTX_PREVIEW, CWD, CTX_FILES, CTX_COUNT);
+            if(CTX_SCROLL > CTX_PREVIEW.lines) CTX_SCROLL = CTX_PREVIEW.lines;
         }
         else if(ch==KEY_F(3)){ g_screen=SCREEN_LOGS; LOG_TRACE("Switch to Logs"); }
  
@@ -350,11 +536,17 @@ int main(int argc, char **argv){
                 const char *model = (cfg.model && *cfg.model) ? cfg.model : "gpt-4o-mini";
                 LOG_DEBUG("Suggest request started (model=%s base=%s, orig_bytes=%zu, orig_lines=%d, sha256=%s…)",
                     model, base, doc.len, lines0, hx);
-                LOG_TRACE("Suggest: Context content: %s", CTX_PREVIEW);
+                int ctx_chunks = 0;
+                char *ctx_retrieved = retrieved_context(&ed, &cfg, &ctx_chunks);  // NULL: whole preview
+                const char *ctx_for_model = ctx_retrieved ? ctx_retrieved : CTX_PREVIEW.text;
+                if(ctx_retrieved)
+                    LOG_DEBUG("Suggest: retrieved %d context chunk(s), %zu of %zu bytes",
+                              ctx_chunks, strlen(ctx_retrieved), CTX_PREVIEW.len);
+                LOG_TRACE("Suggest: Context content: %s", ctx_for_model);
                 stream_ctx_t sctx = { .cfg=&cfg, .on_delta=on_delta_cb, .on_done=on_done_cb, .user=&ed };
                 char *orig_numbered = build_numbered_original(&doc);  // malloc'ed
-                const char *orig_for_model = orig_numbered ? orig_numbered : doc.data;
-                if(!openai_stream_unified_diff(&sctx, orig_for_model, CTX_PREVIEW, NULL)){
+                const char *orig_for_model = orig_numbered ? orig_numbered : buf_data(&doc);
+                if(!openai_stream_unified_diff(&sctx, orig_for_model, ctx_for_model, NULL)){
                     free(STATUS); STATUS=strdup("Suggestion request failed.");
                     LOG_ERROR("Streaming suggestions failed."); // detailed cause logged in stream.c
                 } else {
@@ -362,6 +554,7 @@ int main(int argc, char **argv){
                     LOG_TRACE("Suggest: sent line-numbered ORIGINAL (lines=%d).", lines0);
                 }
                 free(orig_numbered);
+                free(ctx_retrieved);
             } else if(ch==1){ // Ctrl-A => Apply
                 if(!RIGHTBUF || !*RIGHTBUF){ free(STATUS); STATUS=strdup("No diff to apply."); LOG_WARN("Apply requested with no diff."); }
                 else {
@@ -378,33 +571,51 @@ int main(int argc, char **argv){
                     int lines_before = editor_total_lines(&doc);
                     char hx_before[9]; hex8_of_doc(&doc, hx_before);
                     char *out=NULL,*err=NULL;
-                    if(apply_unified_diff(doc.data, RIGHTBUF, &out, &err)){
-                        free(doc.data); doc.data=out; doc.len=strlen(out);
-                        ed.dirty = true;
+                    // Model diffs often carry drifted @@ starts: relocate hunks by content
+                    // unless IDY_PATCH_STRICT is set (IDY_PATCH_WINDOW bounds the search).
+                    size_t window = idy_env_parse_count("IDY_PATCH_WINDOW", 0); // lines
+                    diff_apply_opts_t aopts = {
+                        .fuzzy  = !idy_env_truthy("IDY_PATCH_STRICT"),
+                        .window = window > (size_t)LONG_MAX ? LONG_MAX : (long)window,
+                    };
+                    patch_set_t ps = {0};
+                    const char *before = buf_data(&doc);
+                    if(patch_set_parse(RIGHTBUF, &ps, NULL) &&
+                       (ps.count > 1 || (ps.count == 1 && !is_editor_section(&ps.files[0])))){
+                        apply_patch_set(&ed, &ps, &aopts);
+                    } else if(apply_unified_diff_opts(before, RIGHTBUF, &aopts, &out, &err)){
+                        if(aopts.relocated){
+                            // Show what was actually changed rather than the model's drifted hunks
+                            char *eff = diff_unified(before, doc.len, out, strlen(out), "original.tex", "original.tex", 3);
+                            if(eff){ free(RIGHTBUF); RIGHTBUF = eff; }
+                        }
+                        editor_replace_all(&ed, out, strlen(out)); // undoable with Ctrl-Z
+                        free(out);
                         int lines_after = editor_total_lines(&doc);
                         char hx_after[9]; hex8_of_doc(&doc, hx_after);
-                        LOG_INFO("Patch applied successfully. hunks=%d, +%d, -%d, lines: %d->%d, sha: %s→%s",
-                                 hunks, add, del, lines_before, lines_after, hx_before, hx_after);
-                        free(STATUS); STATUS=strdup("Patch applied.");
+                        LOG_INFO("Patch applied successfully. hunks=%d (relocated=%d), +%d, -%d, lines: %d->%d, sha: %s→%s",
+                                 hunks, aopts.relocated, add, del, lines_before, lines_after, hx_before, hx_after);
+                        free(STATUS);
+                        if(aopts.relocated) asprintf(&STATUS, "Patch applied (%d hunk(s) relocated).", aopts.relocated);
+                        else STATUS=strdup("Patch applied.");
                     } else {
                         LOG_ERROR("Patch failed: %s", err?err:"(unknown)");
                         char *m; asprintf(&m,"Patch failed: %s", err?err:"(unknown)");
                         free(STATUS); STATUS=m; free(err);
                     }
+                    patch_set_free(&ps);
                 }
             } else if(ch==3){ // Ctrl-C (copy)
                 char *copy_buf=NULL;
                 if(editor_has_selection(&ed)){
                     size_t a,b; editor_get_selection(&ed,&a,&b);
-                    size_t n = b - a; copy_buf = (char*)malloc(n+1);
-                    memcpy(copy_buf, doc.data + a, n); copy_buf[n]=0;
+                    copy_buf = buf_strndup(&doc, a, b);
                 } else {
                     // No selection -> copy entire line
                     int row,col; editor_cursor_row_col(&ed,&row,&col);
                     size_t a = editor_line_start_index(&doc, row);
                     size_t b = editor_index_from_row_col(&doc, row, 999999);
-                    size_t n = (b>a)? (b-a) : 0;
-                    copy_buf = (char*)malloc(n+1); memcpy(copy_buf, doc.data + a, n); copy_buf[n]=0;
+                    copy_buf = buf_strndup(&doc, a, b);
                 }
                 clipboard_set(copy_buf);
                 free(copy_buf);
@@ -419,11 +630,14 @@ int main(int argc, char **argv){
             } else if(ch==24){ // Ctrl-X (cut)
                 if(editor_has_selection(&ed)){
                     size_t a,b; editor_get_selection(&ed,&a,&b);
-                    size_t n = b - a; char *copy=(char*)malloc(n+1);
-                    memcpy(copy, doc.data+a, n); copy[n]=0; clipboard_set(copy); free(copy);
+                    char *copy = buf_strndup(&doc, a, b); clipboard_set(copy); free(copy);
                     editor_delete_selection(&ed);
                     free(STATUS); STATUS=strdup("Cut.");
                 }
+            } else if(ch==26){ // Ctrl-Z (undo)
+                free(STATUS); STATUS=strdup(editor_undo(&ed) ? "Undo." : "Nothing to undo.");
+            } else if(ch==25){ // Ctrl-Y (redo)
+                free(STATUS); STATUS=strdup(editor_redo(&ed) ? "Redo." : "Nothing to redo.");
             }
             // Motion + selection
             if(ch==KEY_SLEFT){ extend_selection_move(&ed, editor_move_left); }
@@ -497,9 +711,6 @@ int main(int argc, char **argv){
                 int delta = (content_rows>1)? (+(content_rows-1)) : +1;
                 editor_scroll_lines(&ed, delta);
             }
-
-            const char *fp = HAS_CURRENT_FILE ? CURRENT_FILE : "(untitled)";
-            tui_draw_editor(&T, &ed, RIGHTBUF, STATUS, fp);
         }
         else if(g_screen==SCREEN_LOGS){
             // Logs: filtering + scrolling
@@ -550,7 +761,6 @@ int main(int argc, char **argv){
                     }
                 }
             }
-            tui_draw_logs(&T, LOG_FILTER, STATUS, &LOG_SCROLL, &LOG_RHS_SCROLL);
         }
         else if(g_screen==SCREEN_CONTEXT){
             bool need_preview_rebuild = false;
@@ -598,26 +808,17 @@ int main(int argc, char **argv){
                         if(ev.bstate & (BUTTON4_PRESSED|BUTTON4_CLICKED)){ if(CTX_SCROLL>0) CTX_SCROLL -= 3; if(CTX_SCROLL<0) CTX_SCROLL=0; }
 #endif
 #ifdef BUTTON5_PRESSED
-                        if(ev.bstate & (BUTTON5_PRESSED|BUTTON5_CLICKED)){ CTX_SCROLL += 3; if(CTX_SCROLL>CTX_PREVIEW_LINES) CTX_SCROLL=CTX_PREVIEW_LINES; }
+                        if(ev.bstate & (BUTTON5_PRESSED|BUTTON5_CLICKED)){ CTX_SCROLL += 3; if(CTX_SCROLL>CTX_PREVIEW.lines) CTX_SCROLL=CTX_PREVIEW.lines; }
 #endif
                     }
                 }
             } else if(ch==KEY_PPAGE){ if(CTX_SCROLL>0){ int jump=10; if(CTX_SCROLL<jump) CTX_SCROLL=0; else CTX_SCROLL-=jump; } }
-            else if(ch==KEY_NPAGE){ CTX_SCROLL += 10; if(CTX_SCROLL>CTX_PREVIEW_LINES) CTX_SCROLL=CTX_PREVIEW_LINES; }
+            else if(ch==KEY_NPAGE){ CTX_SCROLL += 10; if(CTX_SCROLL>CTX_PREVIEW.lines) CTX_SCROLL=CTX_PREVIEW.lines; }
             else if(ch==KEY_F(1) || ch==27){ g_screen = SCREEN_EDITOR; }
 
             if(need_preview_rebuild){
-                free(CTX_PREVIEW);
-                CTX_PREVIEW = preview_build(CWD, CTX_FILES, CTX_COUNT, &CTX_PREVIEW_LINES);
-                if(CTX_SCROLL > CTX_PREVIEW_LINES) CTX_SCROLL = CTX_PREVIEW_LINES;
-            }
-
-            // Draw the appropriate screen after possible state change
-            if(g_screen==SCREEN_CONTEXT){
-                tui_draw_context(&T, CWD, &FL, SEL_INDEX, &cfg, CTX_FILES, CTX_COUNT, CTX_PREVIEW, CTX_SCROLL, STATUS);
-            } else if(g_screen==SCREEN_EDITOR){
-                const char *fp = HAS_CURRENT_FILE ? CURRENT_FILE : "(untitled)";
-                tui_draw_editor(&T, &ed, RIGHTBUF, STATUS, fp);
+                preview_build(&CTX_PREVIEW, CWD, CTX_FILES, CTX_COUNT);
+                if(CTX_SCROLL > CTX_PREVIEW.lines) CTX_SCROLL = CTX_PREVIEW.lines;
             }
         }
 
@@ -636,21 +837,30 @@ int main(int argc, char **argv){
             int rc = p ? pclose(p) : -1;
             LOG_DEBUG("latexmk finished rc=%d, captured_lines=%d", rc, lines);
         }
+
+        if(frame_dirty && ms_since(&FRAME_LAST) >= TUI_FRAME_MS){
+            present_frame(&T, &ed, &cfg); frame_dirty = false;
+        }
     }
 
-    tui_end();
+    tui_end(&T);
+    dirwalk_free(WALK);
     free_file_list(&FL);
     for(int i=0;i<CTX_COUNT;i++) free(CTX_FILES[i]);
     free(CTX_FILES);
-    free(CTX_PREVIEW);
+    preview_free(&CTX_PREVIEW);
+    rag_close(RAG);
+    preview_cache_clear();
     clipboard_free();
     log_shutdown();
+    editor_free(&ed);
     buf_free(&doc); free(RIGHTBUF); free(STATUS);
 
     /* free trimmed env copies */
     free(cfg.model);
     free(cfg.api_key);
     free(cfg.base_url);
+    free(multi_prompt);
 
     return 0;
 }
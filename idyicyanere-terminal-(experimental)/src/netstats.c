@@ -0,0 +1,115 @@
+#include "idy.h"
+#include "netstats.h"
+#include "log.h"
+#include <pthread.h>
+
+/* ===================== Request timing window ===================== */
+
+typedef struct {
+    double v[NET_WINDOW][NET_METRICS];
+    int head, n;          // ring of the last NET_WINDOW successful samples
+    int total, failed;
+} net_ring_t;
+
+static net_ring_t RINGS[NET_KINDS];
+static pthread_mutex_t NET_MU = PTHREAD_MUTEX_INITIALIZER;
+
+static const char *KIND_NAMES[NET_KINDS] = { "chat", "embeddings" };
+static const char *METRIC_NAMES[NET_METRICS] = {
+    "dns", "connect", "tls", "ttfb", "transfer", "total", "up", "down", "tok/s"
+};
+
+const char* netstats_kind_name(net_kind_t kind){
+    return (kind >= 0 && kind < NET_KINDS) ? KIND_NAMES[kind] : "?";
+}
+
+const char* netstats_metric_name(net_metric_t m){
+    return (m >= 0 && m < NET_METRICS) ? METRIC_NAMES[m] : "?";
+}
+
+// Cumulative curl time (microseconds since the start of the request); 0 if unavailable.
+static curl_off_t info_us(CURL *curl, CURLINFO what){
+    curl_off_t t = 0;
+    if(curl_easy_getinfo(curl, what, &t) != CURLE_OK || t < 0) t = 0;
+    return t;
+}
+
+static double span_ms(curl_off_t from, curl_off_t to){
+    return to > from ? (double)(to - from) / 1000.0 : 0.0;
+}
+
+void netstats_record(net_kind_t kind, CURL *curl, size_t up_bytes, size_t down_bytes, long tokens, bool ok){
+    if(kind < 0 || kind >= NET_KINDS || !curl) return;
+
+    // Phases from the cumulative marks; a reused connection reports 0 for lookup/connect/TLS
+    curl_off_t dns   = info_us(curl, CURLINFO_NAMELOOKUP_TIME_T);
+    curl_off_t conn  = info_us(curl, CURLINFO_CONNECT_TIME_T);
+    curl_off_t tls   = info_us(curl, CURLINFO_APPCONNECT_TIME_T);
+    curl_off_t pre   = info_us(curl, CURLINFO_PRETRANSFER_TIME_T);
+    curl_off_t first = info_us(curl, CURLINFO_STARTTRANSFER_TIME_T);
+    curl_off_t total = info_us(curl, CURLINFO_TOTAL_TIME_T);
+    if(conn < dns) conn = dns;
+    if(tls < conn) tls = conn;
+    if(pre < tls) pre = tls;
+
+    double s[NET_METRICS];
+    s[NET_DNS]      = span_ms(0, dns);
+    s[NET_CONNECT]  = span_ms(dns, conn);
+    s[NET_TLS]      = span_ms(conn, tls);
+    s[NET_TTFB]     = span_ms(pre, first);
+    s[NET_TRANSFER] = span_ms(first, total);
+    s[NET_TOTAL]    = span_ms(0, total);
+    s[NET_UP]       = (double)up_bytes;
+    s[NET_DOWN]     = (double)down_bytes;
+    s[NET_TPS]      = (tokens > 0 && s[NET_TRANSFER] > 0) ? (double)tokens * 1000.0 / s[NET_TRANSFER] : 0.0;
+
+    char tps[64] = "";
+    if(tokens > 0) snprintf(tps, sizeof(tps), " tokens=%ld tok/s=%.1f", tokens, s[NET_TPS]);
+    LOG_DEBUG("HTTP %s%s: dns=%.1fms connect=%.1fms tls=%.1fms ttfb=%.1fms transfer=%.1fms total=%.1fms "
+              "up=%zuB down=%zuB%s",
+              KIND_NAMES[kind], ok ? "" : " (failed)",
+              s[NET_DNS], s[NET_CONNECT], s[NET_TLS], s[NET_TTFB], s[NET_TRANSFER], s[NET_TOTAL],
+              up_bytes, down_bytes, tps);
+
+    pthread_mutex_lock(&NET_MU);
+    net_ring_t *r = &RINGS[kind];
+    r->total++;
+    if(!ok) r->failed++;
+    else {
+        memcpy(r->v[r->head], s, sizeof(s));
+        r->head = (r->head + 1) % NET_WINDOW;
+        if(r->n < NET_WINDOW) r->n++;
+    }
+    pthread_mutex_unlock(&NET_MU);
+}
+
+static int cmp_double(const void *a, const void *b){
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted v[0..n).
+static double pct(const double *v, int n, int p){
+    int k = (p * n + 99) / 100;
+    if(k < 1) k = 1;
+    return v[k - 1];
+}
+
+bool netstats_summary(net_kind_t kind, net_summary_t *out){
+    if(kind < 0 || kind >= NET_KINDS || !out) return false;
+    memset(out, 0, sizeof(*out));
+    double col[NET_WINDOW];
+
+    pthread_mutex_lock(&NET_MU);
+    const net_ring_t *r = &RINGS[kind];
+    out->total = r->total; out->failed = r->failed; out->samples = r->n;
+    for(int m = 0; m < NET_METRICS && r->n > 0; m++){
+        for(int i = 0; i < r->n; i++) col[i] = r->v[i][m];
+        qsort(col, (size_t)r->n, sizeof(col[0]), cmp_double);
+        out->p50[m] = pct(col, r->n, 50);
+        out->p90[m] = pct(col, r->n, 90);
+        out->p99[m] = pct(col, r->n, 99);
+    }
+    pthread_mutex_unlock(&NET_MU);
+    return out->total > 0;
+}
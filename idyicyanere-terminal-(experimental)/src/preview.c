@@ -1,8 +1,15 @@
 #include "idy.h"
 #include "preview.h"
 #include "sha256.h"
+#include "fsutil.h"
+#include "log.h"
 #include <time.h>
 #include <stdarg.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
 
 // --- small helpers (local) ---
 
@@ -14,40 +21,69 @@ static char* xstrndup(const char *s, size_t n){
     memcpy(p,s,n); p[n]=0; return p;
 }
 
-static void appendf(char **dst, const char *fmt, ...){
-    va_list ap; va_start(ap, fmt);
-    char *add=NULL; vasprintf(&add, fmt, ap); va_end(ap);
-    if(!add) return;
-    if(!*dst){ *dst = add; }
-    else {
-        size_t a=strlen(*dst), b=strlen(add);
-        *dst = (char*)realloc(*dst, a+b+1);
-        memcpy(*dst + a, add, b+1);
-        free(add);
+// --- string builder: amortized O(1) appends, length tracked (never strlen'd) ---
+
+typedef struct { char *p; size_t n, cap; bool oom; } sb_t;
+
+static bool sb_reserve(sb_t *b, size_t extra){
+    if(b->oom) return false;
+    if(b->n + extra + 1 <= b->cap) return true;
+    size_t nc = b->cap ? b->cap : 4096;
+    while(nc < b->n + extra + 1) nc *= 2;
+    char *np = (char*)realloc(b->p, nc);
+    if(!np){ b->oom = true; return false; }
+    b->p = np; b->cap = nc;
+    return true;
+}
+
+static void sb_putn(sb_t *b, const char *s, size_t n){
+    if(!sb_reserve(b, n)) return;
+    memcpy(b->p + b->n, s, n);
+    b->n += n; b->p[b->n] = 0;
+}
+
+static void sb_puts(sb_t *b, const char *s){ sb_putn(b, s, strlen(s)); }
+
+// Formats straight into the tail; a second pass only when it did not fit.
+static void sb_printf(sb_t *b, const char *fmt, ...){
+    va_list ap, ap2; va_start(ap, fmt); va_copy(ap2, ap);
+    size_t room = b->cap > b->n ? b->cap - b->n : 0;
+    int k = vsnprintf(room ? b->p + b->n : NULL, room, fmt, ap);
+    if(k >= 0 && (size_t)k >= room){
+        if(sb_reserve(b, (size_t)k)) vsnprintf(b->p + b->n, (size_t)k + 1, fmt, ap2);
+        else k = -1;
     }
+    va_end(ap2); va_end(ap);
+    if(k > 0) b->n += (size_t)k;
 }
 
-static char *read_entire_file(const char *path, size_t *out_bytes, int *out_lines){
-    FILE *f = fopen(path,"rb");
-    if(!f) return NULL;
-    if(fseek(f,0,SEEK_END)!=0){ fclose(f); return NULL; }
-    long szl = ftell(f);
-    if(szl < 0){ fclose(f); return NULL; }
-    size_t sz = (size_t)szl;
-    if(fseek(f,0,SEEK_SET)!=0){ fclose(f); return NULL; }
-    char *buf = (char*)malloc(sz+1);
-    if(!buf){ fclose(f); return NULL; }
-    size_t n = fread(buf,1,sz,f); fclose(f);
-    if(n != sz){ free(buf); return NULL; }
-    buf[sz]=0;
-    if(out_bytes) *out_bytes = sz;
-    if(out_lines){
-        int lines = 0;
-        for(size_t i=0;i<sz;i++) if(buf[i]=='\n') lines++;
-        if(sz==0 || buf[sz-1] != '\n') lines++; // last partial line
-        *out_lines = lines;
+// --- line index: byte offset of each line start ---
+
+typedef struct { size_t *v; size_t n, cap; bool oom; } ix_t;
+
+static void ix_push(ix_t *ix, size_t off){
+    if(ix->oom) return;
+    if(ix->n == ix->cap){
+        size_t nc = ix->cap ? ix->cap * 2 : 1024;
+        size_t *nv = (size_t*)realloc(ix->v, nc * sizeof(*nv));
+        if(!nv){ ix->oom = true; return; }
+        ix->v = nv; ix->cap = nc;
     }
-    return buf;
+    ix->v[ix->n++] = off;
+}
+
+// Records base + (offset just past each newline of s[0..n)).
+static void ix_scan(ix_t *ix, const char *s, size_t n, size_t base){
+    for(const char *p = s, *e = s + n; p < e && (p = memchr(p, '\n', (size_t)(e - p))); p++)
+        ix_push(ix, base + (size_t)(p - s) + 1);
+}
+
+// Line count of a file body (a trailing partial line counts as one).
+static int count_lines(const char *buf, size_t sz){
+    int lines = 0;
+    for(const char *p = buf, *e = buf + sz; p < e && (p = memchr(p, '\n', (size_t)(e - p))); p++) lines++;
+    if(sz==0 || buf[sz-1] != '\n') lines++;
+    return lines;
 }
 
 static const char* fence_lang_for(const char *filename){
@@ -63,42 +99,285 @@ static const char* fence_lang_for(const char *filename){
     return "";
 }
 
+// --- per-file cache ---
+/* Rendered "===== FILE ... =====" blocks keyed by path and checked against
+   (mtime, size) from stat(), so a rebuild reads and hashes only the files that
+   changed. Entries not used by the latest build are dropped at its end. */
+
+typedef struct pv_entry {
+    char *path;
+    long long mtime_ns;
+    long long size;
+    char *block; size_t len;
+    size_t *nl; int lines;     // offsets just past each newline in block, and their count
+    unsigned gen;              // last build that used it
+    struct pv_entry *next;
+} pv_entry_t;
+
+static struct {
+    pv_entry_t **b; size_t nb, n;
+    unsigned gen;
+} PV;
+
+static size_t pv_hash(const char *s){
+    uint64_t h = 1469598103934665603ULL;
+    for(; *s; s++){ h ^= (unsigned char)*s; h *= 1099511628211ULL; }
+    return (size_t)h;
+}
+
+static void pv_free_entry(pv_entry_t *e){ free(e->path); free(e->block); free(e->nl); free(e); }
+
+static pv_entry_t* pv_find(const char *path){
+    if(!PV.nb) return NULL;
+    for(pv_entry_t *e = PV.b[pv_hash(path) & (PV.nb - 1)]; e; e = e->next)
+        if(!strcmp(e->path, path)) return e;
+    return NULL;
+}
+
+static bool pv_insert(pv_entry_t *e){
+    if(PV.n + 1 > PV.nb * 3 / 4){
+        size_t nb = PV.nb ? PV.nb * 2 : 64;
+        pv_entry_t **b = (pv_entry_t**)calloc(nb, sizeof(*b));
+        if(!b) return false;
+        for(size_t i = 0; i < PV.nb; i++){
+            for(pv_entry_t *x = PV.b[i], *nx; x; x = nx){
+                nx = x->next;
+                size_t k = pv_hash(x->path) & (nb - 1);
+                x->next = b[k]; b[k] = x;
+            }
+        }
+        free(PV.b); PV.b = b; PV.nb = nb;
+    }
+    size_t k = pv_hash(e->path) & (PV.nb - 1);
+    e->next = PV.b[k]; PV.b[k] = e;
+    PV.n++;
+    return true;
+}
+
+// Drop entries the current build did not touch.
+static void pv_sweep(void){
+    for(size_t i = 0; i < PV.nb; i++){
+        pv_entry_t **pp = &PV.b[i];
+        while(*pp){
+            pv_entry_t *e = *pp;
+            if(e->gen != PV.gen){ *pp = e->next; pv_free_entry(e); PV.n--; }
+            else pp = &e->next;
+        }
+    }
+}
+
+void preview_cache_clear(void){
+    PV.gen++;
+    pv_sweep();
+    free(PV.b);
+    PV.b = NULL; PV.nb = PV.n = 0;
+}
+
+void preview_mark_dirty(const char *path){
+    pv_entry_t *e = path ? pv_find(path) : NULL;
+    if(e) e->mtime_ns = -1; // never matches a stat() again
+}
+
+// Render one file already read and hashed (and index its lines); NULL on OOM.
+static char* render_block(const char *path, const fs_view_t *v, const uint8_t dig[32],
+                          size_t *out_len, size_t **out_nl, int *out_lines){
+    const char *buf = v->data; size_t bytes = v->len;
+    int lines = count_lines(buf, bytes);
+    char shahex[65]; sha256_to_hex(dig, shahex);
+    const char *lang = fence_lang_for(path);
+
+    sb_t b = {0};
+    sb_reserve(&b, bytes + strlen(path) + 160);
+    sb_printf(&b, "===== FILE: %s (bytes=%zu, lines=%d, sha256=%s) =====\n", path, bytes, lines, shahex);
+    sb_printf(&b, "```%s\n", lang);
+    sb_putn(&b, buf, bytes);
+    if(bytes==0 || buf[bytes-1] != '\n') sb_puts(&b, "\n");
+    sb_puts(&b, "```\n\n");
+    if(b.oom){ free(b.p); return NULL; }
+    ix_t ix = {0};
+    ix_scan(&ix, b.p, b.n, 0);
+    if(ix.oom){ free(ix.v); free(b.p); return NULL; }
+    *out_len = b.n;
+    *out_nl = ix.v; *out_lines = (int)ix.n;
+    return b.p;
+}
+
+// --- loading misses in parallel ---
+/* Cache hits are resolved on the calling thread; files that must be (re)read
+   are rendered on a small pool (read + SHA-256 dominate), then stored in the
+   cache and assembled in selection order back on the calling thread. Each
+   worker takes up to SHA256_LANES files at a time and hashes them together
+   with sha256_many (the multi-buffer kernel where the CPU has one). */
+
+#define PV_MAX_THREADS 8
+
+typedef struct {
+    const char *path;
+    long long mtime_ns, size;
+    pv_entry_t *hit;      // fresh cache entry, or NULL
+    bool stale;           // stat() worked: render it
+    char *block; size_t len;
+    size_t *nl; int lines;
+} pv_slot_t;
+
+typedef struct {
+    pv_slot_t **todo; size_t n;  // stale slots
+    size_t batch;                // files per claim, <= SHA256_LANES
+    atomic_size_t next;
+} pv_pool_t;
+
+// Read a batch of files, hash them in one sha256_many call, render each.
+// Large files are mapped: hashed and copied straight out of the page cache.
+static void render_batch(pv_slot_t **todo, size_t k){
+    fs_view_t v[SHA256_LANES];
+    pv_slot_t *s[SHA256_LANES];
+    const uint8_t *data[SHA256_LANES]; size_t lens[SHA256_LANES];
+    uint8_t dig[SHA256_LANES][32];
+    size_t m = 0;
+    for(size_t j = 0; j < k; j++){
+        if(!fs_view_open(&v[m], todo[j]->path)) continue; // unreadable: block stays NULL
+        s[m] = todo[j];
+        data[m] = (const uint8_t*)v[m].data; lens[m] = v[m].len;
+        m++;
+    }
+    if(m) sha256_many(data, lens, m, dig);
+    for(size_t j = 0; j < m; j++){
+        s[j]->block = render_block(s[j]->path, &v[j], dig[j], &s[j]->len, &s[j]->nl, &s[j]->lines);
+        fs_view_close(&v[j]);
+    }
+}
+
+static void* pv_worker(void *arg){
+    pv_pool_t *P = (pv_pool_t*)arg;
+    for(;;){
+        size_t i = atomic_fetch_add(&P->next, P->batch);
+        if(i >= P->n) break;
+        render_batch(P->todo + i, P->n - i < P->batch ? P->n - i : P->batch);
+    }
+    return NULL;
+}
+
+static void pv_resolve(pv_slot_t *s){
+    struct stat st;
+    if(!s->path || stat(s->path, &st) != 0 || !S_ISREG(st.st_mode)) return;
+    s->mtime_ns = (long long)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+    s->size = (long long)st.st_size;
+    pv_entry_t *e = pv_find(s->path);
+    if(e && e->mtime_ns == s->mtime_ns && e->size == s->size){ e->gen = PV.gen; s->hit = e; return; }
+    s->stale = true;
+}
+
+// Move a rendered block into the cache (takes ownership of s->block and s->nl).
+static pv_entry_t* pv_store(pv_slot_t *s){
+    char *block = s->block; s->block = NULL;
+    size_t *nl = s->nl; s->nl = NULL;
+    if(!block) return NULL;
+    pv_entry_t *e = pv_find(s->path);
+    if(!e){
+        e = (pv_entry_t*)calloc(1, sizeof(*e));
+        if(!e || !(e->path = xstrdup(s->path)) || !pv_insert(e)){
+            if(e) pv_free_entry(e);
+            free(block); free(nl); return NULL;
+        }
+    }
+    free(e->block); free(e->nl);
+    e->block = block; e->len = s->len;
+    e->nl = nl; e->lines = s->lines;
+    e->mtime_ns = s->mtime_ns; e->size = s->size;
+    e->gen = PV.gen;
+    return e;
+}
+
+static void pv_render_stale(pv_slot_t *slots, size_t n){
+    size_t misses = 0;
+    for(size_t i = 0; i < n; i++) if(slots[i].stale) misses++;
+    if(!misses) return;
+    pv_slot_t **todo = (pv_slot_t**)malloc(misses * sizeof(*todo));
+    if(!todo) return; // stale slots stay unrendered: shown as unreadable
+    for(size_t i = 0, k = 0; i < n; i++) if(slots[i].stale) todo[k++] = &slots[i];
+
+    long nc = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t threads = nc > 0 ? (size_t)nc : 1;
+    if(threads > PV_MAX_THREADS) threads = PV_MAX_THREADS;
+    if(threads > misses) threads = misses;
+    // Full batches only when every thread still gets one
+    size_t batch = misses / threads;
+    if(batch < 1) batch = 1;
+    if(batch > SHA256_LANES) batch = SHA256_LANES;
+    pv_pool_t P = { todo, misses, batch, 0 };
+    pthread_t tids[PV_MAX_THREADS];
+    size_t started = 0;
+    for(size_t t = 0; t + 1 < threads; t++)
+        if(pthread_create(&tids[started], NULL, pv_worker, &P) == 0) started++;
+    pv_worker(&P); // the caller works too
+    for(size_t t = 0; t < started; t++) pthread_join(tids[t], NULL);
+    free(todo);
+    if(started) LOG_DEBUG("Context preview: %zu file(s) loaded on %zu threads (%zu per hash batch)",
+                          misses, started + 1, batch);
+}
+
 // --- public API ---
 
-char* preview_build(const char *cwd, char **paths, int count, int *out_lines){
-    char *out=NULL;
+void preview_free(preview_t *pv){
+    if(!pv) return;
+    free(pv->text); free(pv->line_off);
+    memset(pv, 0, sizeof(*pv));
+}
+
+size_t preview_line(const preview_t *pv, int i, const char **start){
+    if(!pv || !pv->text || !pv->line_off || i < 0 || i > pv->lines){ *start = ""; return 0; }
+    size_t a = pv->line_off[i];
+    size_t e = i < pv->lines ? pv->line_off[i+1] - 1 : pv->len;
+    *start = pv->text + a;
+    return e - a;
+}
+
+void preview_build(preview_t *pv, const char *cwd, char **paths, int count){
+    sb_t out = {0};
+    ix_t ix = {0};
+    PV.gen++;
+    preview_free(pv);
 
     // Header
     time_t now = time(NULL); struct tm tm; localtime_r(&now,&tm);
     char tbuf[64]; strftime(tbuf,sizeof(tbuf), "%Y-%m-%d %H:%M:%S %Z", &tm);
-    appendf(&out, "# Multi-project export\n");
-    appendf(&out, "# Roots:\n#   - %s\n", cwd ? cwd : "(unknown)");
-    appendf(&out, "# Date: %s\n", tbuf);
-    appendf(&out, "# Script: idyicyanere ctx-preview v0.1\n\n");
-    appendf(&out, "## Root: %s\n\n", cwd ? cwd : "(unknown)");
+    sb_puts(&out, "# Multi-project export\n");
+    sb_printf(&out, "# Roots:\n#   - %s\n", cwd ? cwd : "(unknown)");
+    sb_printf(&out, "# Date: %s\n", tbuf);
+    sb_puts(&out, "# Script: idyicyanere ctx-preview v0.1\n\n");
+    sb_printf(&out, "## Root: %s\n\n", cwd ? cwd : "(unknown)");
+    ix_push(&ix, 0);
+    if(!out.oom) ix_scan(&ix, out.p, out.n, 0);
+
+    pv_slot_t *slots = count > 0 ? (pv_slot_t*)calloc((size_t)count, sizeof(pv_slot_t)) : NULL;
+    if(count > 0 && !slots) out.oom = true;
+    for(int i=0; slots && i<count; i++){ slots[i].path = paths[i]; pv_resolve(&slots[i]); }
+    if(slots) pv_render_stale(slots, (size_t)count);
 
-    for(int i=0;i<count;i++){
+    for(int i=0; slots && i<count; i++){
         const char *path = paths[i];
-        size_t bytes=0; int lines=0;
-        char *buf = read_entire_file(path, &bytes, &lines);
-        if(!buf){
-            appendf(&out, "===== FILE: %s (unreadable) =====\n\n", path?path:"(null)");
+        pv_entry_t *e = slots[i].hit;
+        // A path selected twice is rendered twice; the later block replaces the cached one
+        if(!e && slots[i].stale) e = pv_store(&slots[i]);
+        size_t at = out.n;
+        if(!e){
+            sb_printf(&out, "===== FILE: %s (unreadable) =====\n\n", path?path:"(null)");
+            if(!out.oom) ix_scan(&ix, out.p + at, out.n - at, at);
             continue;
         }
-        char shahex[65]; sha256_hex((const unsigned char*)buf, bytes, shahex);
-        const char *lang = fence_lang_for(path);
-        appendf(&out, "===== FILE: %s (bytes=%zu, lines=%d, sha256=%s) =====\n", path, bytes, lines, shahex);
-        appendf(&out, "```%s\n", lang);
-        appendf(&out, "%s", buf);
-        if(bytes==0 || buf[bytes-1] != '\n') appendf(&out, "\n");
-        appendf(&out, "```\n\n");
-        free(buf);
+        // Cached blocks carry their own line offsets: only rebase them
+        sb_putn(&out, e->block, e->len);
+        for(int k = 0; k < e->lines; k++) ix_push(&ix, at + e->nl[k]);
     }
+    free(slots);
+    pv_sweep();
 
-    // Count lines for scrolling
-    if(out_lines){
-        int c=0; for(const char *p=out; p && *p; ++p) if(*p=='\n') c++;
-        *out_lines = c;
+    if(out.oom || ix.oom || !out.p){
+        free(out.p); free(ix.v);
+        memset(&ix, 0, sizeof(ix)); ix_push(&ix, 0);
+        out.p = xstrdup(""); out.n = 0;
     }
-    return out ? out : xstrdup("");
+    pv->text = out.p; pv->len = out.n;
+    pv->line_off = ix.v;
+    pv->lines = ix.n ? (int)ix.n - 1 : 0;
 }
@@ -0,0 +1,475 @@
+#include "idy.h"
+#include "rag.h"
+#include "db.h"
+#include "requests.h"
+#include "sha256.h"
+#include "fsutil.h"
+#include "log.h"
+#include <stdarg.h>
+#include <sys/stat.h>
+
+/* ========= Retrieval context =========
+
+   The idydb file mirrors the current selection, one row per distinct chunk:
+     column 1: embedding (IDYDB_VECTOR)
+     column 2: key, hex SHA-256 of (embedding model, chunk text)
+   idydb keeps columns contiguous, so the big column goes first and rows are
+   added by appending to the small one. Chunk texts are not stored: they are
+   re-read from the files on every sync, which is also what detects changes.
+   A row is only valid once its key is written (the vector goes first), so a
+   vector left without a key by an interrupted run is dropped on open.
+   The file is opened per request (rag_sync .. rag_release) and its row keys
+   re-read each time, since another instance may have changed it meanwhile. */
+
+#define RAG_COL_VEC 1
+#define RAG_COL_KEY 2
+#define RAG_EMBED_BATCH 64
+#define RAG_CHUNK_MAX (16 * 1024)   // keeps every chunk well inside embedding input limits
+
+typedef struct {
+    int file;                       // index into r->paths
+    int line0, line1;               // 1-based, inclusive
+    char *text; size_t len;
+    char key[65];
+    idydb_column_row_sizing row;    // 0 while not stored
+} rag_chunk_t;
+
+struct rag {
+    char *path;
+    idydb *db;                      // NULL between requests
+    char **row_key;                 // row_key[row] for rows 1..nrows; NULL: free row
+    size_t nrows, cap;
+    unsigned short dims;            // embedding size of the stored rows (0: unknown yet)
+    char **paths; int npaths;       // as of the last sync
+    rag_chunk_t *chunks; size_t nchunks;
+};
+
+// -------------------- small helpers --------------------
+
+static void set_err(char **err, const char *fmt, ...){
+    if(!err) return;
+    va_list ap; va_start(ap, fmt);
+    char *s = NULL;
+    if(vasprintf(&s, fmt, ap) < 0) s = NULL;
+    va_end(ap);
+    free(*err); *err = s;
+}
+
+typedef struct { char *p; size_t n, cap; bool oom; } sb_t;
+
+static bool sb_reserve(sb_t *b, size_t extra){
+    if(b->oom) return false;
+    if(b->n + extra + 1 <= b->cap) return true;
+    size_t nc = b->cap ? b->cap : 4096;
+    while(nc < b->n + extra + 1) nc *= 2;
+    char *np = (char*)realloc(b->p, nc);
+    if(!np){ b->oom = true; return false; }
+    b->p = np; b->cap = nc;
+    return true;
+}
+
+static void sb_putn(sb_t *b, const char *s, size_t n){
+    if(!sb_reserve(b, n)) return;
+    memcpy(b->p + b->n, s, n);
+    b->n += n; b->p[b->n] = 0;
+}
+
+static void sb_printf(sb_t *b, const char *fmt, ...){
+    va_list ap; va_start(ap, fmt);
+    char *s = NULL;
+    int k = vasprintf(&s, fmt, ap);
+    va_end(ap);
+    if(k < 0){ b->oom = true; return; }
+    sb_putn(b, s, (size_t)k);
+    free(s);
+}
+
+// Open-addressing set over the 64-hex-char keys (their first 16 digits are the hash).
+typedef struct { const char **k; size_t *v; size_t mask; } keyset_t;
+
+static size_t key_hash(const char *key){
+    size_t h = 0;
+    for(int i = 0; i < 16; i++){
+        char c = key[i];
+        h = (h << 4) | (size_t)(c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
+    }
+    return h;
+}
+
+static bool ks_init(keyset_t *s, size_t n){
+    size_t cap = 16;
+    while(cap < n * 2) cap *= 2;
+    s->k = (const char**)calloc(cap, sizeof(*s->k));
+    s->v = (size_t*)calloc(cap, sizeof(*s->v));
+    s->mask = cap - 1;
+    if(!s->k || !s->v){ free(s->k); free(s->v); return false; }
+    return true;
+}
+static void ks_free(keyset_t *s){ free(s->k); free(s->v); }
+
+// Slot of key (empty slot if absent).
+static size_t ks_slot(const keyset_t *s, const char *key){
+    size_t i = key_hash(key) & s->mask;
+    while(s->k[i] && strcmp(s->k[i], key)) i = (i + 1) & s->mask;
+    return i;
+}
+static bool ks_put(keyset_t *s, const char *key, size_t v){
+    size_t i = ks_slot(s, key);
+    if(s->k[i]) return false;
+    s->k[i] = key; s->v[i] = v;
+    return true;
+}
+static bool ks_get(const keyset_t *s, const char *key, size_t *v){
+    size_t i = ks_slot(s, key);
+    if(!s->k[i]) return false;
+    if(v) *v = s->v[i];
+    return true;
+}
+
+// -------------------- open / close --------------------
+
+// $XDG_CACHE_HOME/idyicyanere/context-<16 hex digits of SHA-256(realpath(workspace))>.idydb
+static char* default_db_path(const char *workspace){
+    char *ws = workspace ? realpath(workspace, NULL) : NULL;
+    if(!ws && !(ws = realpath(".", NULL))) return NULL;
+    uint8_t dig[32]; char hex[65];
+    sha256_bytes((const uint8_t*)ws, strlen(ws), dig);
+    sha256_to_hex(dig, hex);
+    free(ws);
+
+    char *base = idy_getenv_trimdup("XDG_CACHE_HOME");
+    char *dir = NULL;
+    if(base){ if(asprintf(&dir, "%s/idyicyanere", base) < 0) dir = NULL; free(base); }
+    else {
+        const char *home = getenv("HOME");
+        if(!home || !*home) return NULL;
+        char *cache = NULL;
+        if(asprintf(&cache, "%s/.cache", home) < 0) return NULL;
+        mkdir(cache, 0700);
+        if(asprintf(&dir, "%s/idyicyanere", cache) < 0) dir = NULL;
+        free(cache);
+    }
+    if(!dir) return NULL;
+    mkdir(dir, 0700);
+    char *path = NULL;
+    if(asprintf(&path, "%s/context-%.16s.idydb", dir, hex) < 0) path = NULL;
+    free(dir);
+    return path;
+}
+
+static bool row_reserve(rag_t *r, size_t row){
+    if(row < r->cap) return true;
+    size_t nc = r->cap ? r->cap : 256;
+    while(nc <= row) nc *= 2;
+    char **nv = (char**)realloc(r->row_key, nc * sizeof(*nv));
+    if(!nv) return false;
+    memset(nv + r->cap, 0, (nc - r->cap) * sizeof(*nv));
+    r->row_key = nv; r->cap = nc;
+    return true;
+}
+
+static void drop_row(rag_t *r, size_t row){
+    idydb_delete(&r->db, RAG_COL_VEC, (idydb_column_row_sizing)row);
+    idydb_delete(&r->db, RAG_COL_KEY, (idydb_column_row_sizing)row);
+    free(r->row_key[row]); r->row_key[row] = NULL;
+    while(r->nrows > 0 && !r->row_key[r->nrows]) r->nrows--;
+}
+
+// Forgets the row keys and closes the file.
+static void db_detach(rag_t *r){
+    for(size_t i = 0; i < r->cap; i++){ free(r->row_key[i]); r->row_key[i] = NULL; }
+    r->nrows = 0; r->dims = 0;
+    if(r->db) idydb_close(&r->db);
+    r->db = NULL;
+}
+
+// Opens the file (if not open yet) and reads the keys of its rows.
+static bool db_attach(rag_t *r, char **err){
+    if(r->db) return true;
+    int rc = idydb_open(r->path, &r->db, IDYDB_CREATE);
+    if(rc != IDYDB_SUCCESS){
+        if(rc == IDYDB_BUSY) set_err(err, "index %s is in use by another instance", r->path);
+        else set_err(err, "cannot open %s: %s", r->path, r->db ? idydb_errmsg(&r->db) : "out of memory");
+        if(r->db) idydb_close(&r->db);
+        r->db = NULL;
+        return false;
+    }
+
+    // Keys of the stored rows; vectors without one are leftovers of an interrupted run
+    idydb_column_row_sizing end = idydb_column_next_row(&r->db, RAG_COL_VEC);
+    idydb_column_row_sizing kend = idydb_column_next_row(&r->db, RAG_COL_KEY);
+    if(kend > end) end = kend;
+    if(end > 1 && !row_reserve(r, (size_t)end)){ db_detach(r); set_err(err, "out of memory"); return false; }
+    size_t orphans = 0;
+    for(idydb_column_row_sizing row = 1; row < end; row++){
+        char *key = NULL;
+        if(idydb_extract(&r->db, RAG_COL_KEY, row) == IDYDB_DONE && idydb_retrieved_type(&r->db) == IDYDB_CHAR){
+            const char *s = idydb_retrieve_char(&r->db);
+            if(s && strlen(s) == 64) key = strdup(s);
+        }
+        if(key){ r->row_key[row] = key; r->nrows = (size_t)row; }
+        else { idydb_delete(&r->db, RAG_COL_VEC, row); idydb_delete(&r->db, RAG_COL_KEY, row); orphans++; }
+    }
+    for(size_t row = 1; row <= r->nrows && !r->dims; row++){
+        unsigned short d = 0;
+        if(r->row_key[row] && idydb_extract(&r->db, RAG_COL_VEC, (idydb_column_row_sizing)row) == IDYDB_DONE)
+            if(idydb_retrieve_vector(&r->db, &d)) r->dims = d;
+    }
+    LOG_DEBUG("Retrieval: index %s (%zu rows, dims=%u%s)", r->path, r->nrows, (unsigned)r->dims,
+              orphans ? ", dropped incomplete rows" : "");
+    return true;
+}
+
+rag_t* rag_open(const char *db_path, const char *workspace){
+    char *path = db_path ? strdup(db_path) : default_db_path(workspace);
+    if(!path){ LOG_WARN("Retrieval: no cache directory for the index (set IDY_RAG_DB)"); return NULL; }
+    rag_t *r = (rag_t*)calloc(1, sizeof(*r));
+    if(!r){ free(path); return NULL; }
+    r->path = path;
+    return r;
+}
+
+void rag_release(rag_t *r){
+    if(r) db_detach(r);
+}
+
+static void free_chunks(rag_t *r){
+    for(size_t i = 0; i < r->nchunks; i++) free(r->chunks[i].text);
+    free(r->chunks); r->chunks = NULL; r->nchunks = 0;
+    for(int i = 0; i < r->npaths; i++) free(r->paths[i]);
+    free(r->paths); r->paths = NULL; r->npaths = 0;
+}
+
+void rag_close(rag_t *r){
+    if(!r) return;
+    free_chunks(r);
+    db_detach(r);
+    free(r->row_key);
+    free(r->path);
+    free(r);
+}
+
+// -------------------- chunking --------------------
+
+static bool push_chunk(rag_t *r, size_t *cap, int file, int line0, int line1, const char *s, size_t n){
+    if(n == 0) return true;
+    if(r->nchunks == *cap){
+        size_t nc = *cap ? *cap * 2 : 64;
+        rag_chunk_t *nv = (rag_chunk_t*)realloc(r->chunks, nc * sizeof(*nv));
+        if(!nv) return false;
+        r->chunks = nv; *cap = nc;
+    }
+    rag_chunk_t *c = &r->chunks[r->nchunks];
+    memset(c, 0, sizeof(*c));
+    if(!(c->text = (char*)malloc(n + 1))) return false;
+    memcpy(c->text, s, n); c->text[n] = 0;
+    c->len = n; c->file = file; c->line0 = line0; c->line1 = line1;
+    r->nchunks++;
+    return true;
+}
+
+// Whole lines up to `target` bytes per chunk; a longer line is split (never inside a UTF-8 sequence).
+static bool chunk_file(rag_t *r, size_t *cap, int file, const char *s, size_t n, size_t target){
+    size_t start = 0, pos = 0;
+    int line = 1, line0 = 1;
+    while(pos < n){
+        const char *nl = memchr(s + pos, '\n', n - pos);
+        size_t end = nl ? (size_t)(nl - s) + 1 : n;
+        if(end - start > target && pos > start){
+            if(!push_chunk(r, cap, file, line0, line - 1, s + start, pos - start)) return false;
+            start = pos; line0 = line;
+        }
+        while(end - start > target){
+            size_t cut = start + target;
+            while(cut > start + 1 && ((unsigned char)s[cut] & 0xC0) == 0x80) cut--;
+            if(!push_chunk(r, cap, file, line0, line, s + start, cut - start)) return false;
+            start = cut;
+        }
+        pos = end;
+        if(nl) line++;
+    }
+    return push_chunk(r, cap, file, line0, line - (n && s[n-1] == '\n'), s + start, n - start);
+}
+
+static void chunk_key(const char *model, const rag_chunk_t *c, char out[65]){
+    sha256_ctx_t h; uint8_t dig[32];
+    sha256_init(&h);
+    sha256_update(&h, model, strlen(model) + 1);
+    sha256_update(&h, c->text, c->len);
+    sha256_final(&h, dig);
+    sha256_to_hex(dig, out);
+}
+
+static const char* embed_model(const idy_config_t *cfg){
+    return (cfg->embeddings_model && *cfg->embeddings_model) ? cfg->embeddings_model : "text-embedding-3-small";
+}
+
+// -------------------- sync --------------------
+
+static idydb_column_row_sizing free_row(rag_t *r){
+    for(size_t row = 1; row <= r->nrows; row++) if(!r->row_key[row]) return (idydb_column_row_sizing)row;
+    return (idydb_column_row_sizing)(r->nrows + 1);
+}
+
+// Embeds chunks[todo[0..n)] and stores them; false (with *err) on the first failure.
+static bool embed_and_store(rag_t *r, idy_config_t *cfg, const size_t *todo, size_t n, char **err){
+    requests_ctx_t rq = { cfg };
+    const char **inputs = (const char**)malloc(RAG_EMBED_BATCH * sizeof(*inputs));
+    if(!inputs){ set_err(err, "out of memory"); return false; }
+    bool ok = true;
+    for(size_t at = 0; ok && at < n; at += RAG_EMBED_BATCH){
+        int nb = (int)((n - at) < RAG_EMBED_BATCH ? (n - at) : RAG_EMBED_BATCH);
+        for(int i = 0; i < nb; i++) inputs[i] = r->chunks[todo[at + (size_t)i]].text;
+        emb_batch_t eb; char *e = NULL;
+        if(!openai_embeddings_batch(&rq, inputs, nb, NULL, 0, &eb, &e)){
+            set_err(err, "embeddings: %s", e ? e : "request failed");
+            free(e); ok = false; break;
+        }
+        for(int i = 0; ok && i < nb && i < eb.count; i++){
+            rag_chunk_t *c = &r->chunks[todo[at + (size_t)i]];
+            size_t d = eb.dims[i];
+            if(d == 0 || d > 16383 || (r->dims && d != r->dims)){
+                set_err(err, "embeddings: unexpected vector size %zu", d); ok = false; break;
+            }
+            idydb_column_row_sizing row = free_row(r);
+            if(!row_reserve(r, (size_t)row)){ set_err(err, "out of memory"); ok = false; break; }
+            if(idydb_insert_vector(&r->db, RAG_COL_VEC, row, eb.vecs[i], (unsigned short)d) != IDYDB_DONE ||
+               idydb_insert_const_char(&r->db, RAG_COL_KEY, row, c->key) != IDYDB_DONE){
+                set_err(err, "index: %s", idydb_errmsg(&r->db));
+                idydb_delete(&r->db, RAG_COL_VEC, row);
+                ok = false; break;
+            }
+            r->dims = (unsigned short)d;
+            r->row_key[row] = strdup(c->key);
+            if((size_t)row > r->nrows) r->nrows = (size_t)row;
+            c->row = row;
+        }
+        emb_batch_free(&eb);
+    }
+    free(inputs);
+    return ok;
+}
+
+bool rag_sync(rag_t *r, idy_config_t *cfg, char **paths, int count, size_t chunk_bytes, char **err){
+    if(err) *err = NULL;
+    if(!r || !cfg){ set_err(err, "invalid arguments"); return false; }
+    if(chunk_bytes < 256) chunk_bytes = 256;
+    if(chunk_bytes > RAG_CHUNK_MAX) chunk_bytes = RAG_CHUNK_MAX;
+    free_chunks(r);
+    if(!db_attach(r, err)) return false;
+
+    // Chunk the selection
+    size_t cap = 0;
+    if(count > 0 && !(r->paths = (char**)calloc((size_t)count, sizeof(*r->paths)))){ set_err(err, "out of memory"); return false; }
+    for(int i = 0; i < count; i++){
+        if(!(r->paths[i] = strdup(paths[i]))){ set_err(err, "out of memory"); return false; }
+        r->npaths++;
+        fs_view_t v;
+        if(!fs_view_open(&v, paths[i])){ LOG_DEBUG("Retrieval: skipping unreadable %s", paths[i]); continue; }
+        bool ok = chunk_file(r, &cap, i, v.data, v.len, chunk_bytes);
+        fs_view_close(&v);
+        if(!ok){ set_err(err, "out of memory"); return false; }
+    }
+    const char *model = embed_model(cfg);
+    for(size_t i = 0; i < r->nchunks; i++) chunk_key(model, &r->chunks[i], r->chunks[i].key);
+
+    // Rows to keep, rows to drop, chunks to embed
+    keyset_t want, have;
+    if(!ks_init(&want, r->nchunks)){ set_err(err, "out of memory"); return false; }
+    if(!ks_init(&have, r->nrows)){ ks_free(&want); set_err(err, "out of memory"); return false; }
+    for(size_t i = 0; i < r->nchunks; i++) ks_put(&want, r->chunks[i].key, i);
+    size_t dropped = 0;
+    for(size_t row = r->nrows; row >= 1; row--){
+        if(!r->row_key[row]) continue;
+        if(!ks_get(&want, r->row_key[row], NULL)){ drop_row(r, row); dropped++; }
+        else ks_put(&have, r->row_key[row], row);
+    }
+    size_t *todo = (size_t*)malloc((r->nchunks ? r->nchunks : 1) * sizeof(*todo));
+    size_t ntodo = 0;
+    bool ok = todo != NULL;
+    if(!ok) set_err(err, "out of memory");
+    for(size_t i = 0; ok && i < r->nchunks; i++){
+        rag_chunk_t *c = &r->chunks[i];
+        size_t row, first;
+        if(ks_get(&have, c->key, &row)) c->row = (idydb_column_row_sizing)row;
+        else if(ks_get(&want, c->key, &first) && first == i) todo[ntodo++] = i;  // duplicates embed once
+    }
+    ks_free(&have);
+    if(ok && ntodo) ok = embed_and_store(r, cfg, todo, ntodo, err);
+
+    // Duplicated chunks share the row of their first occurrence
+    for(size_t i = 0; i < r->nchunks; i++){
+        size_t first;
+        if(!r->chunks[i].row && ks_get(&want, r->chunks[i].key, &first)) r->chunks[i].row = r->chunks[first].row;
+    }
+    ks_free(&want);
+    free(todo);
+    LOG_DEBUG("Retrieval: %zu chunks from %d file(s); embedded %zu, dropped %zu, rows=%zu",
+              r->nchunks, count, ntodo, dropped, r->nrows);
+    return ok;
+}
+
+// -------------------- query --------------------
+
+static int cmp_pick(const void *a, const void *b){
+    const rag_chunk_t *A = *(rag_chunk_t* const*)a, *B = *(rag_chunk_t* const*)b;
+    if(A->file != B->file) return A->file - B->file;
+    return A->line0 - B->line0;
+}
+
+char* rag_query(rag_t *r, idy_config_t *cfg, const char *query, int topk, size_t max_bytes,
+                int *out_chunks, char **err){
+    if(err) *err = NULL;
+    if(out_chunks) *out_chunks = 0;
+    if(!r || !cfg || !query || !*query || topk <= 0){ set_err(err, "invalid arguments"); return NULL; }
+    if(!r->db){ set_err(err, "index is not open"); return NULL; }
+    if(!r->nrows || !r->dims){ set_err(err, "index is empty"); return NULL; }
+
+    requests_ctx_t rq = { cfg };
+    float *qv = NULL; size_t qd = 0; char *e = NULL;
+    if(!openai_embeddings_one(&rq, query, NULL, 0, &qv, &qd, NULL, &e)){
+        set_err(err, "embeddings: %s", e ? e : "request failed"); free(e); return NULL;
+    }
+    if(qd != r->dims){ set_err(err, "query vector size %zu, index has %u", qd, (unsigned)r->dims); free(qv); return NULL; }
+
+    // Row -> first chunk holding it
+    rag_chunk_t **by_row = (rag_chunk_t**)calloc(r->nrows + 1, sizeof(*by_row));
+    if(topk > 65535) topk = 65535;
+    idydb_knn_result *res = (idydb_knn_result*)calloc((size_t)topk, sizeof(*res));
+    rag_chunk_t **pick = (rag_chunk_t**)calloc((size_t)topk, sizeof(*pick));
+    if(!by_row || !res || !pick){ set_err(err, "out of memory"); free(by_row); free(res); free(pick); free(qv); return NULL; }
+    for(size_t i = r->nchunks; i-- > 0; ){
+        rag_chunk_t *c = &r->chunks[i];
+        if(c->row && (size_t)c->row <= r->nrows) by_row[c->row] = c;
+    }
+    int n = idydb_knn_search_vector_column(&r->db, RAG_COL_VEC, qv, (unsigned short)qd, (unsigned short)topk,
+                                           IDYDB_SIM_COSINE, res);
+    free(qv);
+    if(n < 0){ set_err(err, "index: %s", idydb_errmsg(&r->db)); free(by_row); free(res); free(pick); return NULL; }
+
+    // Best first while they fit, then back into reading order
+    int np = 0; size_t used = 0;
+    for(int i = 0; i < n; i++){
+        rag_chunk_t *c = (size_t)res[i].row <= r->nrows ? by_row[res[i].row] : NULL;
+        if(!c) continue;
+        size_t est = c->len + strlen(r->paths[c->file]) + 64;
+        if(used + est > max_bytes) continue;
+        used += est; pick[np++] = c;
+    }
+    qsort(pick, (size_t)np, sizeof(*pick), cmp_pick);
+
+    sb_t b = {0};
+    sb_reserve(&b, used + 64);
+    for(int i = 0; i < np; i++){
+        const rag_chunk_t *c = pick[i];
+        sb_printf(&b, "===== FILE: %s (lines %d-%d) =====\n```\n", r->paths[c->file], c->line0, c->line1);
+        sb_putn(&b, c->text, c->len);
+        if(c->text[c->len-1] != '\n') sb_putn(&b, "\n", 1);
+        sb_putn(&b, "```\n\n", 5);
+    }
+    free(by_row); free(res); free(pick);
+    if(b.oom){ free(b.p); set_err(err, "out of memory"); return NULL; }
+    if(!b.p && !(b.p = strdup(""))){ set_err(err, "out of memory"); return NULL; }
+    if(out_chunks) *out_chunks = np;
+    return b.p;
+}
@@ -1,6 +1,7 @@
 /* requests.c */
 #include "requests.h"
 #include "log.h"
+#include "netstats.h"
 
 #include <curl/curl.h>
 #include <ctype.h>
@@ -131,7 +132,8 @@ static void build_embeddings_url(char *dst, size_t dstsz, const char *base){
  * Internal: single-shot JSON HTTP
  * ============================================================ */
 
-static bool http_json(const char *method,
+static bool http_json(net_kind_t kind,             // timing bucket (netstats)
+                      const char *method,
                       const char *url,
                       struct curl_slist *headers,
                       const char *payload,         // may be NULL for GET/DELETE
@@ -201,6 +203,7 @@ static bool http_json(const char *method,
     if(out_http) *out_http = http_code;
 
     bool ok = (rc == CURLE_OK) && (http_code >= 200 && http_code < 300);
+    netstats_record(kind, curl, payload ? strlen(payload) : 0, buf.len, 0, ok);
     if(!ok){
         if(rc != CURLE_OK){
             LOG_ERROR("HTTP error: %s %s => cURL: %s", method, url, curl_easy_strerror(rc));
@@ -308,7 +311,7 @@ bool openai_embeddings_batch(requests_ctx_t          *ctx,
     // POST
     long http=0;
     char *body=NULL,*err=NULL;
-    bool ok = http_json("POST", url, hdr, payload, &http, &body, &err);
+    bool ok = http_json(NET_EMBED, "POST", url, hdr, payload, &http, &body, &err);
 
     curl_slist_free_all(hdr);
     free(payload);
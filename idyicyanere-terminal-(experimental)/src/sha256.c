@@ -1,4 +1,13 @@
 #include "sha256.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SHA256_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
 
 // Minimal, public-domain style SHA-256
 
@@ -22,22 +31,21 @@ static const uint32_t K[64] = {
   0x748f82ee,0x78a5636f,0x84c87814,0x8cc70208,0x90befffa,0xa4506ceb,0xbef9a3f7,0xc67178f2
 };
 
-void sha256_bytes(const uint8_t *data, size_t len, uint8_t out[32]){
-    uint32_t H[8] = { 0x6a09e667,0xbb67ae85,0x3c6ef372,0xa54ff53a,
-                      0x510e527f,0x9b05688c,0x1f83d9ab,0x5be0cd19 };
-    uint8_t block[64];
-    size_t i;
+static const uint32_t H0[8] = { 0x6a09e667,0xbb67ae85,0x3c6ef372,0xa54ff53a,
+                                0x510e527f,0x9b05688c,0x1f83d9ab,0x5be0cd19 };
 
-    uint64_t bitlen = (uint64_t)len * 8;
+static inline uint32_t load_be32(const uint8_t *p){
+    return ((uint32_t)p[0]<<24) | ((uint32_t)p[1]<<16) | ((uint32_t)p[2]<<8) | (uint32_t)p[3];
+}
 
-    while(len >= 64){
+// ----- block kernels: compress nblocks consecutive 64-byte blocks into H -----
+
+static void blocks_scalar(uint32_t H[8], const uint8_t *data, size_t nblocks){
+    for(; nblocks; nblocks--, data += 64){
         uint32_t W[64];
-        for(i=0;i<16;i++){
-            W[i] = (data[4*i]<<24) | (data[4*i+1]<<16) | (data[4*i+2]<<8) | (data[4*i+3]);
-        }
-        for(i=16;i<64;i++){
-            W[i] = SSIG1(W[i-2]) + W[i-7] + SSIG0(W[i-15]) + W[i-16];
-        }
+        size_t i;
+        for(i=0;i<16;i++) W[i] = load_be32(data + 4*i);
+        for(i=16;i<64;i++) W[i] = SSIG1(W[i-2]) + W[i-7] + SSIG0(W[i-15]) + W[i-16];
         uint32_t a=H[0],b=H[1],c=H[2],d=H[3],e=H[4],f=H[5],g=H[6],h=H[7];
         for(i=0;i<64;i++){
             uint32_t T1 = h + BSIG1(e) + CH(e,f,g) + K[i] + W[i];
@@ -46,63 +54,262 @@ void sha256_bytes(const uint8_t *data, size_t len, uint8_t out[32]){
             d=c; c=b; b=a; a=T1 + T2;
         }
         H[0]+=a; H[1]+=b; H[2]+=c; H[3]+=d; H[4]+=e; H[5]+=f; H[6]+=g; H[7]+=h;
-        data += 64; len -= 64;
     }
+}
 
-    // Pad remaining
-    size_t rem = len;
-    for(i=0;i<rem;i++) block[i] = data[i];
-    block[rem++] = 0x80;
-    if(rem > 56){
-        while(rem < 64) block[rem++] = 0;
-        // process block
-        uint32_t W[64];
-        for(i=0;i<16;i++){
-            W[i] = (block[4*i]<<24) | (block[4*i+1]<<16) | (block[4*i+2]<<8) | (block[4*i+3]);
-        }
-        for(i=16;i<64;i++) W[i] = SSIG1(W[i-2]) + W[i-7] + SSIG0(W[i-15]) + W[i-16];
-        uint32_t a=H[0],b=H[1],c=H[2],d=H[3],e=H[4],f=H[5],g=H[6],h=H[7];
-        for(i=0;i<64;i++){
-            uint32_t T1 = h + BSIG1(e) + CH(e,f,g) + K[i] + W[i];
-            uint32_t T2 = BSIG0(a) + MAJ(a,b,c);
-            h=g; g=f; f=e; e=d + T1;
-            d=c; c=b; b=a; a=T1 + T2;
+#ifdef SHA256_X86
+/* SHA-NI: state kept as ABEF/CDGH; each group of 4 schedule words is
+   msg2(msg1(W[g-4], W[g-3]) + W[g-2..g-1 shifted by one word], W[g-1]). */
+__attribute__((target("sha,sse4.1")))
+static void blocks_shani(uint32_t H[8], const uint8_t *data, size_t nblocks){
+    const __m128i BSWAP = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i tmp = _mm_loadu_si128((const __m128i*)&H[0]);
+    __m128i st1 = _mm_loadu_si128((const __m128i*)&H[4]);
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);             // CDAB
+    st1 = _mm_shuffle_epi32(st1, 0x1B);             // EFGH
+    __m128i st0 = _mm_alignr_epi8(tmp, st1, 8);     // ABEF
+    st1 = _mm_blend_epi16(st1, tmp, 0xF0);          // CDGH
+
+    for(; nblocks; nblocks--, data += 64){
+        __m128i abef = st0, cdgh = st1;
+        __m128i W[4];
+        #pragma GCC unroll 16
+        for(int g = 0; g < 16; g++){
+            if(g < 4){
+                W[g] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 16*g)), BSWAP);
+            } else {
+                __m128i t = _mm_sha256msg1_epu32(W[g&3], W[(g+1)&3]);
+                t = _mm_add_epi32(t, _mm_alignr_epi8(W[(g+3)&3], W[(g+2)&3], 4));
+                W[g&3] = _mm_sha256msg2_epu32(t, W[(g+3)&3]);
+            }
+            __m128i m = _mm_add_epi32(W[g&3], _mm_loadu_si128((const __m128i*)&K[4*g]));
+            st1 = _mm_sha256rnds2_epu32(st1, st0, m);
+            st0 = _mm_sha256rnds2_epu32(st0, st1, _mm_shuffle_epi32(m, 0x0E));
         }
-        H[0]+=a; H[1]+=b; H[2]+=c; H[3]+=d; H[4]+=e; H[5]+=f; H[6]+=g; H[7]+=h;
-        rem = 0;
+        st0 = _mm_add_epi32(st0, abef);
+        st1 = _mm_add_epi32(st1, cdgh);
     }
-    while(rem < 56) block[rem++] = 0;
-    // append length
-    for(i=0;i<8;i++) block[56+7-i] = (uint8_t)((bitlen >> (8*i)) & 0xFF);
 
-    // process final
-    {
-        uint32_t W[64];
-        for(i=0;i<16;i++){
-            W[i] = (block[4*i]<<24) | (block[4*i+1]<<16) | (block[4*i+2]<<8) | (block[4*i+3]);
+    tmp = _mm_shuffle_epi32(st0, 0x1B);             // FEBA
+    st1 = _mm_shuffle_epi32(st1, 0xB1);             // DCHG
+    st0 = _mm_blend_epi16(tmp, st1, 0xF0);          // DCBA
+    st1 = _mm_alignr_epi8(st1, tmp, 8);             // HGFE
+    _mm_storeu_si128((__m128i*)&H[0], st0);
+    _mm_storeu_si128((__m128i*)&H[4], st1);
+}
+
+/* AVX2 multi-buffer: eight independent messages, one per 32-bit lane,
+   advanced by the same number of blocks. */
+#define V_ROTR(x,n) _mm256_or_si256(_mm256_srli_epi32((x),(n)), _mm256_slli_epi32((x),32-(n)))
+
+__attribute__((target("avx2")))
+static void blocks_avx2_x8(uint32_t st[SHA256_LANES][8], const uint8_t *const p[SHA256_LANES], size_t nblocks){
+    __m256i S[8];
+    for(int j=0;j<8;j++)
+        S[j] = _mm256_setr_epi32((int)st[0][j],(int)st[1][j],(int)st[2][j],(int)st[3][j],
+                                 (int)st[4][j],(int)st[5][j],(int)st[6][j],(int)st[7][j]);
+    for(size_t blk = 0; blk < nblocks; blk++){
+        size_t off = blk * 64;
+        __m256i W[16];
+        for(int t=0;t<16;t++){
+            size_t o = off + 4*(size_t)t;
+            W[t] = _mm256_setr_epi32((int)load_be32(p[0]+o),(int)load_be32(p[1]+o),(int)load_be32(p[2]+o),(int)load_be32(p[3]+o),
+                                     (int)load_be32(p[4]+o),(int)load_be32(p[5]+o),(int)load_be32(p[6]+o),(int)load_be32(p[7]+o));
         }
-        for(i=16;i<64;i++) W[i] = SSIG1(W[i-2]) + W[i-7] + SSIG0(W[i-15]) + W[i-16];
-        uint32_t a=H[0],b=H[1],c=H[2],d=H[3],e=H[4],f=H[5],g=H[6],h=H[7];
-        for(i=0;i<64;i++){
-            uint32_t T1 = h + BSIG1(e) + CH(e,f,g) + K[i] + W[i];
-            uint32_t T2 = BSIG0(a) + MAJ(a,b,c);
-            h=g; g=f; f=e; e=d + T1;
-            d=c; c=b; b=a; a=T1 + T2;
+        __m256i a=S[0],b=S[1],c=S[2],d=S[3],e=S[4],f=S[5],g=S[6],h=S[7];
+        for(int t=0;t<64;t++){
+            __m256i w;
+            if(t < 16) w = W[t];
+            else {
+                __m256i w2 = W[(t-2)&15], w15 = W[(t-15)&15];
+                __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(V_ROTR(w2,17), V_ROTR(w2,19)), _mm256_srli_epi32(w2,10));
+                __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(V_ROTR(w15,7), V_ROTR(w15,18)), _mm256_srli_epi32(w15,3));
+                w = _mm256_add_epi32(_mm256_add_epi32(s1, W[(t-7)&15]), _mm256_add_epi32(s0, W[t&15]));
+                W[t&15] = w;
+            }
+            __m256i bs1 = _mm256_xor_si256(_mm256_xor_si256(V_ROTR(e,6), V_ROTR(e,11)), V_ROTR(e,25));
+            __m256i ch  = _mm256_xor_si256(_mm256_and_si256(e,f), _mm256_andnot_si256(e,g));
+            __m256i t1  = _mm256_add_epi32(_mm256_add_epi32(h, bs1),
+                          _mm256_add_epi32(_mm256_add_epi32(ch, _mm256_set1_epi32((int)K[t])), w));
+            __m256i bs0 = _mm256_xor_si256(_mm256_xor_si256(V_ROTR(a,2), V_ROTR(a,13)), V_ROTR(a,22));
+            __m256i maj = _mm256_xor_si256(_mm256_xor_si256(_mm256_and_si256(a,b), _mm256_and_si256(a,c)), _mm256_and_si256(b,c));
+            __m256i t2  = _mm256_add_epi32(bs0, maj);
+            h=g; g=f; f=e; e=_mm256_add_epi32(d, t1);
+            d=c; c=b; b=a; a=_mm256_add_epi32(t1, t2);
         }
-        H[0]+=a; H[1]+=b; H[2]+=c; H[3]+=d; H[4]+=e; H[5]+=f; H[6]+=g; H[7]+=h;
+        S[0]=_mm256_add_epi32(S[0],a); S[1]=_mm256_add_epi32(S[1],b); S[2]=_mm256_add_epi32(S[2],c); S[3]=_mm256_add_epi32(S[3],d);
+        S[4]=_mm256_add_epi32(S[4],e); S[5]=_mm256_add_epi32(S[5],f); S[6]=_mm256_add_epi32(S[6],g); S[7]=_mm256_add_epi32(S[7],h);
+    }
+    for(int j=0;j<8;j++){
+        uint32_t lane[8];
+        _mm256_storeu_si256((__m256i*)lane, S[j]);
+        for(int l=0;l<SHA256_LANES;l++) st[l][j] = lane[l];
+    }
+}
+#endif
+
+// ----- dispatch -----
+
+typedef struct {
+    const char *name;
+    void (*blocks)(uint32_t H[8], const uint8_t *data, size_t nblocks);
+    bool multi;     // sha256_many uses the AVX2 8-lane kernel
+} sha256_impl_t;
+
+enum { IMPL_SCALAR, IMPL_SHANI, IMPL_AVX2 };
+static const sha256_impl_t IMPLS[] = {
+    { "scalar", blocks_scalar, false },
+#ifdef SHA256_X86
+    { "sha-ni", blocks_shani,  false },
+    { "avx2",   blocks_scalar, true  },
+#endif
+};
+static _Atomic int g_impl = -1;
+
+static bool cpu_has(int which){
+#ifdef SHA256_X86
+    unsigned a, b, c, d;
+    if(!__get_cpuid(1, &a, &b, &c, &d)) return false;
+    bool sse41 = (c >> 19) & 1, ssse3 = (c >> 9) & 1, osxsave = (c >> 27) & 1, avx = (c >> 28) & 1;
+    if(!__get_cpuid_count(7, 0, &a, &b, &c, &d)) return false;
+    if(which == IMPL_SHANI) return sse41 && ssse3 && ((b >> 29) & 1);
+    if(which == IMPL_AVX2){
+        if(!osxsave || !avx || !((b >> 5) & 1)) return false;
+        unsigned lo, hi;
+        __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+        return (lo & 6) == 6;   // OS saves XMM and YMM state
     }
+#endif
+    return which == IMPL_SCALAR;
+}
 
-    for(i=0;i<8;i++){
-        out[4*i  ] = (uint8_t)((H[i] >> 24) & 0xFF);
-        out[4*i+1] = (uint8_t)((H[i] >> 16) & 0xFF);
-        out[4*i+2] = (uint8_t)((H[i] >> 8) & 0xFF);
-        out[4*i+3] = (uint8_t)((H[i]      ) & 0xFF);
+static int impl_by_name(const char *name){
+    if(!name || !*name || !strcmp(name, "auto")){
+        if(cpu_has(IMPL_SHANI)) return IMPL_SHANI;
+        if(cpu_has(IMPL_AVX2))  return IMPL_AVX2;
+        return IMPL_SCALAR;
     }
+    for(int i = 0; i < (int)(sizeof(IMPLS)/sizeof(IMPLS[0])); i++)
+        if(!strcmp(name, IMPLS[i].name)) return cpu_has(i) ? i : -1;
+    return -1;
 }
 
-void sha256_hex(const uint8_t *data, size_t len, char out_hex[65]){
+static const sha256_impl_t* impl(void){
+    int i = atomic_load_explicit(&g_impl, memory_order_relaxed);
+    if(i < 0){
+        // Racing first callers compute the same answer
+        i = impl_by_name(getenv("IDY_SHA256"));
+        if(i < 0) i = impl_by_name("auto");
+        atomic_store_explicit(&g_impl, i, memory_order_relaxed);
+    }
+    return &IMPLS[i];
+}
+
+bool sha256_select(const char *name){
+    int i = impl_by_name(name);
+    if(i < 0) return false;
+    atomic_store_explicit(&g_impl, i, memory_order_relaxed);
+    return true;
+}
+
+const char* sha256_impl_name(void){ return impl()->name; }
+
+// ----- streaming -----
+
+void sha256_init(sha256_ctx_t *c){
+    memcpy(c->h, H0, sizeof(H0));
+    c->len = 0;
+    c->nbuf = 0;
+}
+
+void sha256_update(sha256_ctx_t *c, const void *data, size_t len){
+    const uint8_t *p = (const uint8_t*)data;
+    const sha256_impl_t *im = impl();
+    c->len += len;
+    if(c->nbuf){
+        size_t take = 64 - c->nbuf < len ? 64 - c->nbuf : len;
+        memcpy(c->buf + c->nbuf, p, take);
+        c->nbuf += take; p += take; len -= take;
+        if(c->nbuf < 64) return;
+        im->blocks(c->h, c->buf, 1);
+        c->nbuf = 0;
+    }
+    if(len >= 64){
+        size_t nb = len / 64;
+        im->blocks(c->h, p, nb);
+        p += nb * 64; len -= nb * 64;
+    }
+    if(len){ memcpy(c->buf, p, len); c->nbuf = len; }
+}
+
+void sha256_final(sha256_ctx_t *c, uint8_t out[32]){
+    const sha256_impl_t *im = impl();
+    uint64_t bitlen = c->len * 8;
+    size_t rem = c->nbuf;
+    c->buf[rem++] = 0x80;
+    if(rem > 56){
+        memset(c->buf + rem, 0, 64 - rem);
+        im->blocks(c->h, c->buf, 1);
+        rem = 0;
+    }
+    memset(c->buf + rem, 0, 56 - rem);
+    for(int i=0;i<8;i++) c->buf[56+7-i] = (uint8_t)((bitlen >> (8*i)) & 0xFF);
+    im->blocks(c->h, c->buf, 1);
+
+    for(int i=0;i<8;i++){
+        out[4*i  ] = (uint8_t)((c->h[i] >> 24) & 0xFF);
+        out[4*i+1] = (uint8_t)((c->h[i] >> 16) & 0xFF);
+        out[4*i+2] = (uint8_t)((c->h[i] >> 8) & 0xFF);
+        out[4*i+3] = (uint8_t)((c->h[i]      ) & 0xFF);
+    }
+}
+
+// ----- one-shot -----
+
+void sha256_bytes(const uint8_t *data, size_t len, uint8_t out[32]){
+    sha256_ctx_t c;
+    sha256_init(&c);
+    sha256_update(&c, data, len);
+    sha256_final(&c, out);
+}
+
+void sha256_many(const uint8_t *const *data, const size_t *len, size_t n, uint8_t (*out)[32]){
+    size_t i = 0;
+#ifdef SHA256_X86
+    if(impl()->multi){
+        // Lanes share the common whole-block prefix; each tail finishes on its own
+        for(; i + 1 < n; i += SHA256_LANES){
+            size_t k = n - i < SHA256_LANES ? n - i : SHA256_LANES;
+            const uint8_t *p[SHA256_LANES];
+            uint32_t st[SHA256_LANES][8];
+            size_t common = SIZE_MAX;
+            for(size_t l = 0; l < SHA256_LANES; l++){
+                size_t m = i + (l < k ? l : 0);   // idle lanes shadow the first one
+                p[l] = data[m];
+                memcpy(st[l], H0, sizeof(H0));
+                if(len[m] / 64 < common) common = len[m] / 64;
+            }
+            blocks_avx2_x8(st, p, common);
+            for(size_t l = 0; l < k; l++){
+                sha256_ctx_t c;
+                memcpy(c.h, st[l], sizeof(c.h));
+                c.len = common * 64; c.nbuf = 0;
+                sha256_update(&c, data[i+l] + common * 64, len[i+l] - common * 64);
+                sha256_final(&c, out[i+l]);
+            }
+        }
+    }
+#endif
+    for(; i < n; i++) sha256_bytes(data[i], len[i], out[i]);
+}
+
+void sha256_to_hex(const uint8_t dig[32], char out_hex[65]){
     static const char *hex = "0123456789abcdef";
-    uint8_t dig[32]; sha256_bytes(data, len, dig);
     for(int i=0;i<32;i++){ out_hex[2*i] = hex[(dig[i]>>4)&0xF]; out_hex[2*i+1] = hex[dig[i]&0xF]; }
     out_hex[64] = '\0';
 }
+
+void sha256_hex(const uint8_t *data, size_t len, char out_hex[65]){
+    uint8_t dig[32]; sha256_bytes(data, len, dig);
+    sha256_to_hex(dig, out_hex);
+}
@@ -1,6 +1,7 @@
 /* stream.c */
 #include "stream.h"
 #include "log.h"
+#include "netstats.h"
 
 #include <ctype.h>
 #include <string.h>
@@ -15,6 +16,8 @@ typedef struct {
     size_t total_bytes;
     int events;
     int data_chunks;
+    int deltas;            // content deltas seen (token estimate when usage is missing)
+    long usage_tokens;     // usage.completion_tokens, when the server reports it
     bool saw_done;
 } sse_accum_t;
 
@@ -195,14 +198,17 @@ static void handle_sse_payload_line(sse_accum_t *acc, const char *payload){
         json_t *delta = json_object_get(c0, "delta");
         if(json_is_object(delta)){
             json_t *cont = json_object_get(delta, "content");
-            if(json_is_string(cont) && acc->ctx->on_delta){
-                acc->ctx->on_delta(json_string_value(cont), acc->ctx->user);
+            if(json_is_string(cont)){
+                acc->deltas++;
+                if(acc->ctx->on_delta) acc->ctx->on_delta(json_string_value(cont), acc->ctx->user);
             }
         }
     }
 
     // Optional usage (may arrive at the end or intermixed on some stacks)
     json_t *usage = json_object_get(j, "usage");
+    json_t *ctoks = json_object_get(usage, "completion_tokens");
+    if(json_is_integer(ctoks)) acc->usage_tokens = (long)json_integer_value(ctoks);
     if(usage && acc->ctx->on_done){
         acc->ctx->on_done(usage, acc->ctx->user);
     }
@@ -327,7 +333,7 @@ static int setup_http_version(CURL *curl){
     return want_h2;
 }
 
-static bool perform_with_h2_fallback(http_handles_t *h, int want_h2, const char *url){
+static bool perform_with_h2_fallback(http_handles_t *h, int want_h2, const char *url, size_t up_bytes){
     CURLcode rc = curl_easy_perform(h->curl);
     long http_code = 0; curl_easy_getinfo(h->curl, CURLINFO_RESPONSE_CODE, &http_code);
 #ifdef CURLINFO_SSL_VERIFYRESULT
@@ -339,12 +345,14 @@ static bool perform_with_h2_fallback(http_handles_t *h, int want_h2, const char
         LOG_WARN("HTTP/2 streaming failed (rc=%d, http=%ld). Retrying with HTTP/1.1…", (int)rc, http_code);
         curl_easy_setopt(h->curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1);
         // reset accumulator
-        free(h->acc.buf); h->acc.buf=NULL; h->acc.len=0; h->acc.cap=0; h->acc.total_bytes=0; h->acc.events=0; h->acc.data_chunks=0; h->acc.saw_done=false;
+        free(h->acc.buf); h->acc.buf=NULL; h->acc.len=0; h->acc.cap=0; h->acc.total_bytes=0; h->acc.events=0; h->acc.data_chunks=0; h->acc.deltas=0; h->acc.usage_tokens=0; h->acc.saw_done=false;
         rc = curl_easy_perform(h->curl);
         curl_easy_getinfo(h->curl, CURLINFO_RESPONSE_CODE, &http_code);
     }
 
     bool ok = (rc == CURLE_OK) && (http_code >= 200 && http_code < 300);
+    netstats_record(NET_CHAT, h->curl, up_bytes, h->acc.total_bytes,
+                    h->acc.usage_tokens > 0 ? h->acc.usage_tokens : h->acc.deltas, ok);
     if(!ok){
         if(rc != CURLE_OK){
             LOG_ERROR("Suggest stream: cURL error on %s: %s", url, curl_easy_strerror(rc));
@@ -412,7 +420,7 @@ bool openai_stream_chat(stream_ctx_t *ctx,
     LOG_TRACE("Suggest stream: POST %s (model=%s)", url,
               (ctx->cfg->model && *ctx->cfg->model) ? ctx->cfg->model : "gpt-4o-mini");
 
-    bool ok = perform_with_h2_fallback(&hh, want_h2, url);
+    bool ok = perform_with_h2_fallback(&hh, want_h2, url, payload ? strlen(payload) : 0);
 
     free(base);
     http_handles_cleanup(&hh, payload);
@@ -451,7 +459,7 @@ bool openai_stream_chat_multi(stream_ctx_t *ctx,
     LOG_TRACE("Suggest stream (multi): POST %s (model=%s)", url,
               (ctx->cfg->model && *ctx->cfg->model) ? ctx->cfg->model : "gpt-4o-mini");
 
-    bool ok = perform_with_h2_fallback(&hh, want_h2, url);
+    bool ok = perform_with_h2_fallback(&hh, want_h2, url, payload ? strlen(payload) : 0);
 
     free(base);
     http_handles_cleanup(&hh, payload);
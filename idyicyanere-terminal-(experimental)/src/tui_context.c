@@ -12,12 +12,13 @@ void tui_draw_context(tui_t *t,
                       const idy_config_t *cfg,
                       char **ctx_files,
                       int ctx_count,
-                      const char *ctx_preview,
+                      const preview_t *ctx_preview,
                       int ctx_scroll,
                       const char *status)
 {
     (void)cfg; // currently unused in Context panel
 
+    t->painted = SCREEN_CONTEXT; // editor rows must be fully repainted when we come back
     werase(t->left);
     if(t->colors_ready) wattron(t->left, COLOR_PAIR(IDY_PAIR_BORDER));
     box(t->left,0,0);
@@ -114,7 +115,7 @@ void tui_draw_context(tui_t *t,
     }
 
     if(is_last) free(is_last);
-    wrefresh(t->left);
+    wnoutrefresh(t->left);
 
     // ----- Right: Context preview (full height) -----
     int rowsR = getmaxy(t->right)-2, colsR = getmaxx(t->right)-2;
@@ -134,26 +135,19 @@ void tui_draw_context(tui_t *t,
 
     if(t->colors_ready) wattron(t->right, COLOR_PAIR(IDY_PAIR_TEXT));
     if(ctx_preview){
-        int cur_line = 0;
-        const char *p = ctx_preview;
-        int ydraw = ybot;
-        while(*p && ydraw < ybot + bot_rows){
-            const char *nl = strchr(p, '\n');
-            size_t len = nl ? (size_t)(nl - p) : strlen(p);
-            size_t maxw_sz = (size_t)(colsR - 1);
-            if(maxw_sz < 1) maxw_sz = 1;
-            if(cur_line >= ctx_scroll){
-                size_t clamp = (len > maxw_sz) ? maxw_sz : len;
-                mvwprintw(t->right, ydraw, 1, "%.*s", (int)clamp, p);
-                ydraw++;
-            }
-            if(!nl) break;
-            p = nl + 1;
-            cur_line++;
+        size_t maxw_sz = (size_t)(colsR - 1);
+        if(maxw_sz < 1) maxw_sz = 1;
+        int line = ctx_scroll < 0 ? 0 : ctx_scroll;
+        for(int ydraw = ybot; ydraw < ybot + bot_rows && line <= ctx_preview->lines; ydraw++, line++){
+            const char *p;
+            size_t len = preview_line(ctx_preview, line, &p);
+            if(line == ctx_preview->lines && len == 0) break; // nothing after the last newline
+            size_t clamp = (len > maxw_sz) ? maxw_sz : len;
+            mvwprintw(t->right, ydraw, 1, "%.*s", (int)clamp, p);
         }
     }
     if(t->colors_ready) wattroff(t->right, COLOR_PAIR(IDY_PAIR_TEXT));
 
-    wrefresh(t->right);
+    wnoutrefresh(t->right);
     tui_draw_status(t->status, status);
 }
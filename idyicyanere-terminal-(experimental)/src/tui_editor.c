@@ -28,84 +28,202 @@ static void draw_title_filepath(WINDOW *w, const char *filepath, bool dirty){
     free(full);
 }
 
-// Render left editor pane with gutter (line numbers), selection highlight, and soft-blink caret
+/* ---------- Damage tracking helpers ---------- */
+
+// FNV-1a, used for row/pane signatures (0 is reserved for "unknown").
+static uint64_t sig_mix(uint64_t h, const void *p, size_t n){
+    const unsigned char *c = (const unsigned char*)p;
+    for(size_t i=0;i<n;i++){ h ^= c[i]; h *= 1099511628211ULL; }
+    return h;
+}
+static uint64_t sig_int(uint64_t h, long long v){ return sig_mix(h, &v, sizeof(v)); }
+static uint64_t sig_done(uint64_t h){ return h ? h : 1; }
+#define SIG_SEED 1469598103934665603ULL
+
+// Flip reverse video on one cell, keeping its glyph, attributes and color.
+static void caret_toggle(WINDOW *w, int y, int x){
+    chtype ch = mvwinch(w, y, x);
+    attr_t a = (attr_t)(ch & A_ATTRIBUTES & ~A_COLOR);
+    mvwchgat(w, y, x, 1, a ^ A_REVERSE, (short)PAIR_NUMBER(ch), NULL);
+}
+
+static void caret_overlay_off(tui_t *t){
+    if(t->caret_lit && t->caret_y >= 0) caret_toggle(t->left, t->caret_y, t->caret_x);
+    t->caret_lit = false;
+}
+
+static void caret_overlay_sync(tui_t *t){
+    if(t->caret_y < 0) return;
+    if(t->blink_on != t->caret_lit){
+        caret_toggle(t->left, t->caret_y, t->caret_x);
+        t->caret_lit = t->blink_on;
+    }
+    wmove(t->left, t->caret_y, t->caret_x);
+}
+
+// Signature of one editor row: everything that affects how it is painted.
+static uint64_t row_signature(const editor_t *ed, size_t row, int lnw, int text_cols,
+                              bool has_sel, size_t sel_lo, size_t sel_hi,
+                              size_t *out_a, size_t *out_e)
+{
+    uint64_t h = sig_int(SIG_SEED, (long long)lnw);
+    h = sig_int(h, text_cols);
+    if(!buf_has_row(ed->doc, row)){ *out_a = *out_e = 0; return sig_done(sig_int(h, -1)); }
+
+    size_t a = buf_line_start(ed->doc, row);
+    size_t e = buf_has_row(ed->doc, row + 1) ? buf_line_start(ed->doc, row + 1) - 1 : ed->doc->len;
+    // Visible byte window of the line
+    size_t va = a + (size_t)ed->left_col; if(va > e) va = e;
+    size_t ve = va + (size_t)(text_cols > 0 ? text_cols : 0); if(ve > e) ve = e;
+    *out_a = va; *out_e = ve;
+
+    h = sig_int(h, (long long)row);
+    h = sig_int(h, (long long)(ve - va));
+    for(size_t pos = va; pos < ve; ){
+        const char *p; size_t n = buf_chunk(ed->doc, pos, &p);
+        if(n == 0) break;
+        if(n > ve - pos) n = ve - pos;
+        h = sig_mix(h, p, n);
+        pos += n;
+    }
+    if(has_sel && sel_lo < ve && sel_hi > va){
+        size_t lo = sel_lo > va ? sel_lo - va : 0;
+        size_t hi = (sel_hi < ve ? sel_hi : ve) - va;
+        h = sig_int(h, (long long)lo);
+        h = sig_int(h, (long long)hi);
+    }
+    return sig_done(h);
+}
+
+// Render left editor pane with gutter (line numbers), selection highlight, and soft-blink caret.
+// Only rows whose signature changed are repainted; the rest of the window is left alone.
 static void draw_editor_left(tui_t *t, editor_t *ed, const char *filepath){
     WINDOW *w = t->left;
-    werase(w);
-    if(t->colors_ready) wattron(w, COLOR_PAIR(IDY_PAIR_BORDER));
-    box(w,0,0);
-    if(t->colors_ready) wattroff(w, COLOR_PAIR(IDY_PAIR_BORDER));
-
     int rows = getmaxy(w)-2, cols = getmaxx(w)-2;
+    if(rows < 0) rows = 0;
+    bool full = t->damage_all || t->painted != SCREEN_EDITOR;
+
+    // Lift the blink overlay before any cell underneath it is reused
+    if(full) t->caret_lit = false; else caret_overlay_off(t);
+
+    if(t->row_sig_n != rows){
+        uint64_t *nv = (uint64_t*)realloc(t->row_sig, sizeof(uint64_t) * (size_t)(rows > 0 ? rows : 1));
+        if(nv){ t->row_sig = nv; t->row_sig_n = rows; }
+        full = true;
+    }
+    if(full){
+        werase(w);
+        if(t->colors_ready) wattron(w, COLOR_PAIR(IDY_PAIR_BORDER));
+        box(w,0,0);
+        if(t->colors_ready) wattroff(w, COLOR_PAIR(IDY_PAIR_BORDER));
+        if(t->row_sig) memset(t->row_sig, 0, sizeof(uint64_t) * (size_t)t->row_sig_n);
+        t->title_sig = 0;
+    }
 
     // Title bar: file path (Ln/Col are shown in the status bar)
-    draw_title_filepath(w, filepath, ed->dirty);
+    uint64_t tsig = sig_int(sig_int(SIG_SEED, cols), ed->dirty);
+    if(filepath) tsig = sig_mix(tsig, filepath, strlen(filepath));
+    tsig = sig_done(tsig);
+    if(tsig != t->title_sig){
+        if(t->colors_ready) wattron(w, COLOR_PAIR(IDY_PAIR_BORDER));
+        box(w,0,0); // restore the top rule under a previously longer title
+        if(t->colors_ready) wattroff(w, COLOR_PAIR(IDY_PAIR_BORDER));
+        draw_title_filepath(w, filepath, ed->dirty);
+        t->title_sig = tsig;
+    }
 
-    // Compute gutter width (min 3 digits) + one space
-    int total_lines = editor_total_lines(ed->doc);
-    int lnw = digits_i(total_lines < 1 ? 1 : total_lines);
+    // Compute gutter width (min 3 digits) + one space. Rows are counted as far
+    // as the viewport has been indexed, so on a large file the gutter widens as
+    // it is paged in.
+    buf_has_row(ed->doc, (size_t)ed->top_line + (size_t)rows);
+    size_t total_lines = buf_line_count_known(ed->doc);
+    int lnw = digits_i((int)total_lines);
     if(lnw < 3) lnw = 3;
     int gutter = lnw + 1;
     t->gutter_cols = gutter;
+    int text_cols = cols - gutter;
+
+    // Keep the caret visible before deciding what the rows show
+    int crow, ccol; editor_cursor_row_col(ed, &crow, &ccol);
+    editor_scroll_into_view(ed, crow, ccol, rows, text_cols);
 
     // Selection range (absolute byte indexes)
     bool has_sel = editor_has_selection(ed);
     size_t sel_lo=0, sel_hi=0; if(has_sel) editor_get_selection(ed,&sel_lo,&sel_hi);
 
-    if(t->colors_ready) wattron(w, COLOR_PAIR(IDY_PAIR_TEXT));
-    // find start index of top line
-    size_t idx = editor_line_start_index(ed->doc, ed->top_line);
-    int y=1, x=1+gutter, col=0;
-    bool attr_sel=false;
-    for(size_t i=idx; i<=ed->doc->len && y<=rows; i++){
-        char c = (i<ed->doc->len) ? ed->doc->data[i] : '\0';
-        if(c=='\n' || c=='\0'){
-            int lineno = ed->top_line + (y-1) + 1;
-            if(t->colors_ready) wattron(w, COLOR_PAIR(IDY_PAIR_GUTTER));
-            wattron(w, A_DIM);
-            mvwprintw(w, y, 1, "%*d ", lnw, lineno);
-            wattroff(w, A_DIM);
-            if(t->colors_ready) wattroff(w, COLOR_PAIR(IDY_PAIR_GUTTER));
-            if(attr_sel){ wattroff(w, A_REVERSE); attr_sel=false; }
-            y++; x=1+gutter; col=0;
-            if(c=='\0') break;
-            continue;
-        } else {
-            if(col >= ed->left_col){
+    for(int y=1; y<=rows; y++){
+        size_t row = (size_t)ed->top_line + (size_t)(y-1);
+        size_t va, ve;
+        uint64_t sig = row_signature(ed, row, lnw, text_cols, has_sel, sel_lo, sel_hi, &va, &ve);
+        if(t->row_sig && t->row_sig[y-1] == sig) continue;
+        if(t->row_sig) t->row_sig[y-1] = sig;
+
+        mvwhline(w, y, 1, ' ', cols);
+        if(!buf_has_row(ed->doc, row)) continue;
+
+        if(t->colors_ready) wattron(w, COLOR_PAIR(IDY_PAIR_GUTTER));
+        wattron(w, A_DIM);
+        mvwprintw(w, y, 1, "%*zu ", lnw, row + 1);
+        wattroff(w, A_DIM);
+        if(t->colors_ready) wattroff(w, COLOR_PAIR(IDY_PAIR_GUTTER));
+
+        if(t->colors_ready) wattron(w, COLOR_PAIR(IDY_PAIR_TEXT));
+        bool attr_sel=false;
+        int x = 1 + gutter;
+        for(size_t pos = va; pos < ve; ){
+            const char *p; size_t n = buf_chunk(ed->doc, pos, &p);
+            if(n == 0) break;
+            if(n > ve - pos) n = ve - pos;
+            for(size_t k=0;k<n;k++, x++){
+                size_t i = pos + k;
                 bool in_sel = has_sel && (i>=sel_lo && i<sel_hi);
                 if(in_sel && !attr_sel){ wattron(w, A_REVERSE); attr_sel=true; }
                 if(!in_sel && attr_sel){ wattroff(w, A_REVERSE); attr_sel=false; }
-                if(x <= cols){ mvwaddch(w, y, x, c); }
-                x++;
+                mvwaddch(w, y, x, (unsigned char)p[k]);
             }
-            col++;
+            pos += n;
         }
+        if(attr_sel){ wattroff(w, A_REVERSE); }
+        if(t->colors_ready) wattroff(w, COLOR_PAIR(IDY_PAIR_TEXT));
     }
-    if(attr_sel){ wattroff(w, A_REVERSE); }
-    if(t->colors_ready) wattroff(w, COLOR_PAIR(IDY_PAIR_TEXT));
 
-    // draw caret + soft blink overlay
-    int crow, ccol; editor_cursor_row_col(ed, &crow, &ccol);
-    editor_scroll_into_view(ed, crow, ccol, rows, cols - gutter);
+    // caret + soft blink overlay
     int cy = 1 + (crow - ed->top_line);
     int cx = 1 + gutter + (ccol - ed->left_col);
-    if(cy>=1 && cy<=rows && cx>=1 && cx<=cols){
-        wmove(w, cy, cx);
-        if(t->blink_on) mvwchgat(w, cy, cx, 1, A_REVERSE, 0, NULL);
-    }
-    wrefresh(w);
+    if(cy>=1 && cy<=rows && cx>=1 && cx<=cols){ t->caret_y = cy; t->caret_x = cx; }
+    else { t->caret_y = t->caret_x = -1; }
+    caret_overlay_sync(t);
+    wnoutrefresh(w);
 }
 
-// Colorize unified diff in right pane
-static void draw_diff_right(WINDOW *w, const char *diff, bool colors_ready){
+// Colorize unified diff in right pane (skipped when the visible part is unchanged)
+static void draw_diff_right(tui_t *t, const char *diff, bool full){
+    WINDOW *w = t->right;
+    bool colors_ready = t->colors_ready;
+    int rows = getmaxy(w)-2, cols = getmaxx(w)-2;
+
+    uint64_t sig = sig_int(sig_int(SIG_SEED, rows), cols);
+    if(diff){
+        const char *p = diff;
+        for(int y=1; *p && y<=rows; y++){
+            const char *nl = strchr(p, '\n');
+            size_t len = nl ? (size_t)(nl - p) : strlen(p);
+            sig = sig_mix(sig, p, len < (size_t)cols ? len : (size_t)(cols > 0 ? cols : 0));
+            sig = sig_int(sig, y);
+            p = nl ? nl+1 : p+len;
+        }
+    }
+    sig = sig_done(sig);
+    if(!full && sig == t->diff_sig) return;
+    t->diff_sig = sig;
+
     werase(w);
     if(colors_ready) wattron(w, COLOR_PAIR(IDY_PAIR_BORDER));
     box(w,0,0);
     if(colors_ready) wattroff(w, COLOR_PAIR(IDY_PAIR_BORDER));
 
-    int rows = getmaxy(w)-2, cols = getmaxx(w)-2;
     int y=1;
-    if(!diff){ wrefresh(w); return; }
+    if(!diff){ wnoutrefresh(w); return; }
     const char *p=diff;
     while(*p && y<=rows){
         const char *nl = strchr(p, '\n');
@@ -127,12 +245,15 @@ static void draw_diff_right(WINDOW *w, const char *diff, bool colors_ready){
         y++;
         p = nl ? nl+1 : p+len;
     }
-    wrefresh(w);
+    wnoutrefresh(w);
 }
 
 void tui_draw_editor(tui_t *t, editor_t *ed, const char *rightbuf, const char *status, const char *filepath){
+    bool full = t->damage_all || t->painted != SCREEN_EDITOR;
     draw_editor_left(t, ed, filepath);
-    draw_diff_right(t->right, rightbuf, t->colors_ready);
+    draw_diff_right(t, rightbuf, full);
+    t->painted = SCREEN_EDITOR;
+    t->damage_all = false;
     int r=0,c=0; editor_cursor_row_col(ed,&r,&c);
     char sbuf[512];
     if(status && *status)
@@ -141,3 +262,10 @@ void tui_draw_editor(tui_t *t, editor_t *ed, const char *rightbuf, const char *s
         snprintf(sbuf, sizeof(sbuf), "%sLn %d, Col %d", ed->dirty?"*":"", r+1, c+1);
     tui_draw_status(t->status, sbuf);
 }
+
+void tui_blink_caret(tui_t *t){
+    if(t->painted != SCREEN_EDITOR || t->caret_y < 0) return;
+    caret_overlay_sync(t);
+    wnoutrefresh(t->left);
+    doupdate();
+}
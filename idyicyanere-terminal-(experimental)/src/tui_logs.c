@@ -1,5 +1,7 @@
 #include "tui.h"
 #include "stream.h"  // for IDY_PROMPT_MAX_ORIG / IDY_PROMPT_MAX_CTX
+#include "sha256.h"
+#include "netstats.h"
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h>
@@ -14,7 +16,8 @@
    Right:
    - Static controls at the top (filter keys, instructions, shortcuts).
    - Config section moved BELOW; it is independently scrollable
-     via mouse wheel over the RIGHT pane (rhs_scroll).
+     via mouse wheel over the RIGHT pane (rhs_scroll). It opens with
+     rolling request timings (p50 / p90 / p99, see netstats.h).
 
    Env knobs affecting rendering:
    - IDY_LOG_TABSTOP (default 4) : expand tabs in logs to N spaces.
@@ -98,6 +101,21 @@ static void fmt_bytes_iec(size_t v, char *out, size_t outsz){
     }
 }
 
+/* Compact value for the timing table: ms with one decimal, bytes in IEC units. */
+static void fmt_metric(net_metric_t m, double v, char *out, size_t outsz){
+    if(m == NET_UP || m == NET_DOWN){
+        const char *u[] = {"B","KiB","MiB","GiB"};
+        int idx = 0;
+        while(v >= 1024.0 && idx < 3){ v /= 1024.0; idx++; }
+        if(idx == 0) snprintf(out, outsz, "%.0f B", v);
+        else snprintf(out, outsz, "%.1f %s", v, u[idx]);
+    } else if(m == NET_TPS){
+        snprintf(out, outsz, "%.1f", v);
+    } else {
+        snprintf(out, outsz, "%.1f ms", v);
+    }
+}
+
 /* ---------- Sanitization for LEFT logs ---------- */
 
 static int env_tabstop(void){
@@ -255,6 +273,130 @@ static int draw_wrapped_entry(WINDOW *w, int y, int x, int cols,
     return drawn;
 }
 
+/* ---------- Cache of sanitized + wrapped entries for LEFT logs ----------
+
+   Each entry is sanitized (and its prefix formatted) once, when it is first
+   seen; row counts are redone only when the pane width changes. before[i]
+   counts the wrapped rows above entry i, so finding the first visible entry
+   for a scroll offset is a binary search. Entries are keyed by their log
+   sequence number: new ones are appended, ones the ring has overwritten drop
+   off the front. A filter or tab-stop change starts over. */
+
+typedef struct {
+    uint64_t seq;
+    log_level_t level;
+    char prefix[32];   // "[HH:MM:SS] LEVEL "
+    char *san;
+    int rows;
+} log_row_t;
+
+struct log_rows {
+    log_row_t *v;
+    size_t *before;          // wrapped rows above v[i], counted from v[0]
+    size_t first, n, cap;    // live entries are v[first..n-1]
+    size_t end_rows;         // before[] of a would-be v[n]
+    int cols, tabstop;
+    log_level_t filter;
+    uint64_t last_seq;
+};
+
+static int row_prefix_width(const log_row_t *r, int cols){
+    int eff = (int)strlen(r->prefix);
+    return eff > cols - 1 ? cols - 1 : eff;
+}
+
+static void log_rows_clear(struct log_rows *c){
+    for(size_t i=c->first; i<c->n; i++) free(c->v[i].san);
+    c->first = c->n = 0;
+    c->end_rows = 0;
+    c->last_seq = 0;
+}
+
+void tui_logs_free(tui_t *t){
+    struct log_rows *c = t->log_rows;
+    if(!c) return;
+    log_rows_clear(c);
+    free(c->v); free(c->before); free(c);
+    t->log_rows = NULL;
+}
+
+static void log_rows_recount(struct log_rows *c){
+    size_t acc = 0;
+    for(size_t i=c->first; i<c->n; i++){
+        log_row_t *r = &c->v[i];
+        r->rows = wrapped_rows_count(r->san, c->cols, row_prefix_width(r, c->cols));
+        c->before[i] = acc;
+        acc += (size_t)r->rows;
+    }
+    c->end_rows = acc;
+}
+
+static bool log_rows_append(struct log_rows *c, const log_entry_t *e){
+    if(c->n == c->cap){
+        // Reuse the dead front before growing
+        if(c->first > 0 && c->first >= c->n / 2){
+            size_t live = c->n - c->first;
+            memmove(c->v, c->v + c->first, live * sizeof(*c->v));
+            memmove(c->before, c->before + c->first, live * sizeof(*c->before));
+            c->first = 0; c->n = live;
+        } else {
+            size_t nc = c->cap ? c->cap * 2 : 256;
+            log_row_t *nv = (log_row_t*)realloc(c->v, nc * sizeof(*nv));
+            if(!nv) return false;
+            c->v = nv;
+            size_t *nb = (size_t*)realloc(c->before, nc * sizeof(*nb));
+            if(!nb) return false;
+            c->before = nb;
+            c->cap = nc;
+        }
+    }
+    log_row_t *r = &c->v[c->n];
+    r->seq = e->seq;
+    r->level = e->level;
+    struct tm tm; time_t sec = e->ts.tv_sec; localtime_r(&sec, &tm);
+    char tsbuf[16]; strftime(tsbuf,sizeof(tsbuf),"%H:%M:%S",&tm);
+    snprintf(r->prefix, sizeof(r->prefix), "[%s] %-5s ", tsbuf, log_level_name(e->level));
+    r->san = sanitize_log_copy(e->msg);
+    r->rows = wrapped_rows_count(r->san, c->cols, row_prefix_width(r, c->cols));
+    c->before[c->n] = c->end_rows;
+    c->end_rows += (size_t)r->rows;
+    c->n++;
+    c->last_seq = e->seq;
+    return true;
+}
+
+// Bring the cache in line with the log ring: only entries it has not seen are read.
+static struct log_rows* log_rows_sync(tui_t *t, log_level_t filter, int cols){
+    struct log_rows *c = t->log_rows;
+    if(!c){
+        c = (struct log_rows*)calloc(1, sizeof(*c));
+        if(!c) return NULL;
+        c->filter = filter; c->cols = cols; c->tabstop = env_tabstop();
+        t->log_rows = c;
+    }
+    int tabstop = env_tabstop();
+    if(c->filter != filter || c->tabstop != tabstop){
+        log_rows_clear(c);
+        c->filter = filter; c->tabstop = tabstop;
+    }
+
+    // Overwritten by the ring
+    log_iter_t it = log_iter_from(c->last_seq + 1, filter);
+    uint64_t oldest = log_oldest_seq();
+    while(c->first < c->n && c->v[c->first].seq < oldest){
+        free(c->v[c->first].san);
+        c->first++;
+    }
+    if(c->first == c->n){ c->first = c->n = 0; c->end_rows = 0; }
+
+    if(c->cols != cols){ c->cols = cols; log_rows_recount(c); }
+
+    // New since last draw
+    for(const log_entry_t *e; (e = log_iter_next(&it)); )
+        if(!log_rows_append(c, e)) break;
+    return c;
+}
+
 /* ---------- Helpers for RIGHT Config: richer line buffer ---------- */
 
 typedef enum { LB_PLAIN, LB_RULE, LB_KV } lb_type_t;
@@ -300,6 +442,32 @@ static void lb_push_kv(linebuf_t *lb, const char *k, const char *v){
 static void build_config_lines(linebuf_t *out){
     lb_init(out);
 
+    // [Requests] rolling timings, so network-bound and generation-bound slowness can be told apart
+    char title[80];
+    snprintf(title, sizeof(title), "[Requests] last %d OK: p50 / p90 / p99", NET_WINDOW);
+    lb_push_plain(out, title);
+    bool any = false;
+    for(int k = 0; k < NET_KINDS; k++){
+        net_summary_t ns;
+        if(!netstats_summary((net_kind_t)k, &ns)) continue;
+        any = true;
+        char head[96];
+        snprintf(head, sizeof(head), "%d request(s), %d failed", ns.total, ns.failed);
+        lb_push_kv(out, netstats_kind_name((net_kind_t)k), head);
+        for(int m = 0; m < NET_METRICS && ns.samples > 0; m++){
+            if(m == NET_TPS && k != NET_CHAT) continue;
+            char a[32], b[32], c[32], line[112], key[32];
+            fmt_metric((net_metric_t)m, ns.p50[m], a, sizeof(a));
+            fmt_metric((net_metric_t)m, ns.p90[m], b, sizeof(b));
+            fmt_metric((net_metric_t)m, ns.p99[m], c, sizeof(c));
+            snprintf(line, sizeof(line), "%s / %s / %s", a, b, c);
+            snprintf(key, sizeof(key), "  %s", netstats_metric_name((net_metric_t)m));
+            lb_push_kv(out, key, line);
+        }
+    }
+    if(!any) lb_push_kv(out, "(no requests yet)", "");
+    lb_push_plain(out, "");
+
     // [OpenAI]
     lb_push_plain(out, "[OpenAI]");
     char *v_base  = getenv_clean("OPENAI_BASE_URL");
@@ -328,6 +496,19 @@ static void build_config_lines(linebuf_t *out){
     }
     free(v_pmo); free(v_pmc);
 
+    // [Retrieval]
+    lb_push_plain(out, "");
+    lb_push_plain(out, "[Retrieval]");
+    char *v_rtk = getenv_clean("IDY_RAG_TOPK");
+    char *v_rch = getenv_clean("IDY_RAG_CHUNK");
+    char *v_rdb = getenv_clean("IDY_RAG_DB");
+    char *v_emb = getenv_clean("OPENAI_EMBEDDINGS_MODEL");
+    lb_push_kv(out, "IDY_RAG_TOPK",  v_rtk?v_rtk:"(unset: 12; 0 sends the full context)");
+    lb_push_kv(out, "IDY_RAG_CHUNK", v_rch?v_rch:"(unset: 2 KiB)");
+    lb_push_kv(out, "IDY_RAG_DB",    v_rdb?v_rdb:"(unset: $XDG_CACHE_HOME/idyicyanere/context-<workspace hash>.idydb)");
+    lb_push_kv(out, "OPENAI_EMBEDDINGS_MODEL", v_emb?v_emb:"(unset: text-embedding-3-small)");
+    free(v_rtk); free(v_rch); free(v_rdb); free(v_emb);
+
     // [TUI / Display]
     lb_push_plain(out, "");
     lb_push_plain(out, "[TUI / Display]");
@@ -337,6 +518,9 @@ static void build_config_lines(linebuf_t *out){
     lb_push_kv(out, "IDY_LOG_TABSTOP",  v_tab?v_tab:"(unset: 4)");
     lb_push_kv(out, "unicode_tree (effective)", tui_unicode_tree_enabled() ? "enabled" : "disabled");
     free(v_tree); free(v_tab);
+    char *v_ign = getenv_clean("IDY_CTX_IGNORE");
+    lb_push_kv(out, "IDY_CTX_IGNORE", v_ign?v_ign:"(unset: .gitignore + .git only)");
+    free(v_ign);
 
     // [Network / TLS]
     lb_push_plain(out, "");
@@ -369,6 +553,23 @@ static void build_config_lines(linebuf_t *out){
     }
     lb_push_kv(out, "IDY_SAVE_AS", v_saveas?v_saveas:"(unset)");
     free(v_verbose); free(v_saveas);
+    char *v_lvl = getenv_clean("IDY_LOG_LEVEL");
+    lb_push_kv(out, "IDY_LOG_LEVEL", v_lvl?v_lvl:"(unset: TRACE)");
+    lb_push_kv(out, "log_level (effective)", log_level_name(log_get_level()));
+    free(v_lvl);
+    char *v_sha = getenv_clean("IDY_SHA256");
+    lb_push_kv(out, "IDY_SHA256", v_sha?v_sha:"(unset: auto)");
+    lb_push_kv(out, "sha256 kernel (effective)", sha256_impl_name());
+    free(v_sha);
+
+    // [Patching]
+    lb_push_plain(out, "");
+    lb_push_plain(out, "[Patching]");
+    char *v_strict = getenv_clean("IDY_PATCH_STRICT");
+    char *v_window = getenv_clean("IDY_PATCH_WINDOW");
+    lb_push_kv(out, "IDY_PATCH_STRICT", v_strict?v_strict:"(unset: fuzzy relocation on)");
+    lb_push_kv(out, "IDY_PATCH_WINDOW", v_window?v_window:"(unset: whole document)");
+    free(v_strict); free(v_window);
 
     // Locale / TERM
     lb_push_plain(out, "");
@@ -384,6 +585,7 @@ static void build_config_lines(linebuf_t *out){
 
 void tui_draw_logs(tui_t *t, log_level_t filter, const char *status, int *scroll_lines, int *rhs_scroll){
     // Left: logs
+    t->painted = SCREEN_LOGS; // editor rows must be fully repainted when we come back
     werase(t->left);
     if(t->colors_ready) wattron(t->left, COLOR_PAIR(IDY_PAIR_BORDER));
     box(t->left,0,0);
@@ -395,95 +597,63 @@ void tui_draw_logs(tui_t *t, log_level_t filter, const char *status, int *scroll
     box(t->right,0,0);
     if(t->colors_ready) wattroff(t->right, COLOR_PAIR(IDY_PAIR_BORDER));
 
-    log_entry_t *snap=NULL; size_t n=log_snapshot(filter, &snap);
     const int rowsL = getmaxy(t->left)-2;
     const int colsL = getmaxx(t->left)-2;
     const int x0 = 1;
     int y = 1;
 
+    struct log_rows *c = log_rows_sync(t, filter, colsL < 1 ? 1 : colsL);
+
     /* Total wrapped rows for scroll clamp (left) */
-    size_t total_rows = 0;
-    for(size_t i=0; i<n; ++i){
-        const log_entry_t *e = &snap[i];
-        struct tm tm; time_t sec = e->ts.tv_sec; localtime_r(&sec, &tm);
-        char tsbuf[32]; strftime(tsbuf,sizeof(tsbuf),"%H:%M:%S",&tm);
-        char prefix[64]; snprintf(prefix, sizeof(prefix), "[%s] %-5s ", tsbuf, log_level_name(e->level));
-        int eff_prefix = (int)strlen(prefix);
-        if(eff_prefix > colsL - 1) eff_prefix = colsL - 1;
-        char *san = sanitize_log_copy(e->msg);
-        total_rows += (size_t)wrapped_rows_count(san, colsL, eff_prefix);
-        free(san);
-    }
+    size_t base = (c && c->first < c->n) ? c->before[c->first] : 0;
+    size_t total_rows = c ? c->end_rows - base : 0;
     int max_scroll = 0;
-    if((int)total_rows > rowsL) max_scroll = (int)total_rows - rowsL;
+    if(total_rows > (size_t)rowsL) max_scroll = (int)(total_rows - (size_t)rowsL);
     if(scroll_lines){
         if(*scroll_lines < 0) *scroll_lines = 0;
         if(*scroll_lines > max_scroll) *scroll_lines = max_scroll;
     }
     int scroll = scroll_lines ? *scroll_lines : 0;
 
-    /* Determine starting index + intra-entry skip (left) */
-    size_t start_idx = 0;
+    /* First visible row, then the entry holding it + intra-entry skip (left) */
+    size_t top = (size_t)max_scroll - (size_t)scroll;
+    size_t start_idx = c ? c->n : 0;
     int start_skip_rows = 0;
-    int remaining = rowsL + scroll;
-    if(remaining < 0) remaining = 0;
-
-    for(ssize_t i=(ssize_t)n-1; i>=0; --i){
-        const log_entry_t *e = &snap[i];
-        struct tm tm; time_t sec = e->ts.tv_sec; localtime_r(&sec, &tm);
-        char tsbuf[32]; strftime(tsbuf,sizeof(tsbuf),"%H:%M:%S",&tm);
-        char prefix[64]; snprintf(prefix, sizeof(prefix), "[%s] %-5s ", tsbuf, log_level_name(e->level));
-        int eff_prefix = (int)strlen(prefix);
-        if(eff_prefix > colsL - 1) eff_prefix = colsL - 1;
-
-        char *san = sanitize_log_copy(e->msg);
-        int rows_for_e = wrapped_rows_count(san, colsL, eff_prefix);
-        free(san);
-
-        if(rows_for_e >= remaining){
-            start_idx = (size_t)i;
-            start_skip_rows = rows_for_e - remaining;
-            break;
-        } else {
-            remaining -= rows_for_e;
-            if(i==0){ start_idx = 0; start_skip_rows = 0; }
+    if(c && c->first < c->n){
+        size_t lo = c->first, hi = c->n - 1;   // last entry with before <= top
+        while(lo < hi){
+            size_t mid = lo + (hi - lo + 1) / 2;
+            if(c->before[mid] - base <= top) lo = mid; else hi = mid - 1;
         }
+        start_idx = lo;
+        start_skip_rows = (int)(top - (c->before[lo] - base));
     }
 
     if(t->colors_ready) wattron(t->left, COLOR_PAIR(IDY_PAIR_TEXT));
     // Draw forward from start_idx (left)
-    for(size_t i=start_idx; i<n && y<=rowsL; ++i){
-        const log_entry_t *e = &snap[i];
-        struct tm tm; time_t sec = e->ts.tv_sec; localtime_r(&sec, &tm);
-        char tsbuf[32]; strftime(tsbuf,sizeof(tsbuf),"%H:%M:%S",&tm);
+    for(size_t i=start_idx; c && i<c->n && y<=rowsL; ++i){
+        const log_row_t *r = &c->v[i];
 
         int pair=IDY_PAIR_TEXT;
         if(t->colors_ready){
-            if(e->level==LOG_ERROR) pair=7;
-            else if(e->level==LOG_WARN) pair=6;
-            else if(e->level==LOG_INFO) pair=5;
-            else if(e->level==LOG_DEBUG) pair=8;
-            else if(e->level==LOG_TRACE) pair=9;
+            if(r->level==LOG_ERROR) pair=7;
+            else if(r->level==LOG_WARN) pair=6;
+            else if(r->level==LOG_INFO) pair=5;
+            else if(r->level==LOG_DEBUG) pair=8;
+            else if(r->level==LOG_TRACE) pair=9;
         }
 
-        char prefix[64];
-        snprintf(prefix, sizeof(prefix), "[%s] %-5s ", tsbuf, log_level_name(e->level));
-        int eff_prefix = (int)strlen(prefix);
-        if(eff_prefix > colsL - 1) eff_prefix = colsL - 1;
-
-        char *san = sanitize_log_copy(e->msg);
         int avail = rowsL - (y - 1);
         int drawn = draw_wrapped_entry(t->left, y, x0, colsL,
-                                       prefix, eff_prefix, pair,
-                                       san,
+                                       r->prefix, row_prefix_width(r, colsL), pair,
+                                       r->san,
                                        (i==start_idx)?start_skip_rows:0,
                                        avail);
-        free(san);
         y += drawn;
         if(y > rowsL) break;
     }
     if(t->colors_ready) wattroff(t->left, COLOR_PAIR(IDY_PAIR_TEXT));
-    wrefresh(t->left);
+    wnoutrefresh(t->left);
 
     /* -------- RIGHT PANE -------- */
     int rowsR = getmaxy(t->right)-2, colsR = getmaxx(t->right)-2;
@@ -536,6 +706,7 @@ void tui_draw_logs(tui_t *t, log_level_t filter, const char *status, int *scroll
     mvwprintw(t->right, cy++, 2, "F5: latexmk build (local)");
     mvwprintw(t->right, cy++, 2, "Ctrl-S: Save      Ctrl-Q: Quit");
     mvwprintw(t->right, cy++, 2, "Ctrl-C/V/X: Copy / Paste / Cut");
+    mvwprintw(t->right, cy++, 2, "Ctrl-Z/Y: Undo / Redo");
     mvwprintw(t->right, cy++, 2, "Shift+Arrows: Select text");
     mvwprintw(t->right, cy++, 2, "Backspace/Delete: Delete char");
     if(t->colors_ready) wattroff(t->right, COLOR_PAIR(IDY_PAIR_TEXT));
@@ -609,9 +780,8 @@ void tui_draw_logs(tui_t *t, log_level_t filter, const char *status, int *scroll
         }
     }
 
-    wrefresh(t->right);
+    wnoutrefresh(t->right);
     tui_draw_status(t->status, status);
 
     lb_free(&cfg);
-    free(snap);
 }
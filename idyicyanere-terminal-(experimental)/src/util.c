@@ -291,6 +291,13 @@ void tui_init(tui_t *t){
     scrollok(t->right, TRUE);
     t->gutter_cols = 0;
     t->blink_on = false;
+    t->painted = SCREEN_EDITOR;
+    t->damage_all = true;
+    t->row_sig = NULL; t->row_sig_n = 0;
+    t->title_sig = t->diff_sig = 0;
+    t->caret_y = t->caret_x = -1;
+    t->caret_lit = false;
+    t->log_rows = NULL;
     init_colors(t);
 
     // Decide whether to use Unicode tree guides.
@@ -305,7 +312,16 @@ void tui_init(tui_t *t){
     }
 }
 
-void tui_end(void){ endwin(); }
+void tui_end(tui_t *t){
+    endwin();
+    free(t->row_sig);
+    t->row_sig = NULL; t->row_sig_n = 0;
+    tui_logs_free(t);
+}
+
+// Last painted status line; lets tui_draw_status skip identical frames.
+static char STATUS_LAST[1024];
+static int  STATUS_LAST_W = -1;
 
 void tui_resize(tui_t *t){
     getmaxyx(stdscr, t->rows, t->cols);
@@ -316,12 +332,24 @@ void tui_resize(tui_t *t){
     wresize(t->status, 1, t->cols);
     mvwin(t->status, t->rows-1, 0);
     wclear(t->left); wclear(t->right); wclear(t->status);
+    t->damage_all = true;
+    t->caret_lit = false; // wclear dropped the overlay with everything else
+    STATUS_LAST_W = -1;
 }
 
-// Common status bar drawing (exported)
+// Common status bar drawing (exported). Also flushes the frame: panes only
+// stage their changes with wnoutrefresh, and this emits one doupdate().
 void tui_draw_status(WINDOW *w, const char *status){
-    werase(w);
     int width = getmaxx(w) - 2;
+    const char *cur = status ? status : "";
+    if(width == STATUS_LAST_W && strncmp(cur, STATUS_LAST, sizeof(STATUS_LAST)-1) == 0){
+        doupdate();
+        return;
+    }
+    snprintf(STATUS_LAST, sizeof(STATUS_LAST), "%s", cur);
+    STATUS_LAST_W = width;
+
+    werase(w);
 
     if(has_colors()){
         wattron(w, COLOR_PAIR(IDY_PAIR_TEXT));
@@ -331,7 +359,7 @@ void tui_draw_status(WINDOW *w, const char *status){
     const char *shortcuts =
         "F1:Editor  F2:Context  F3:Logs  "
         "Ctrl-G:Suggest  Ctrl-A:Apply  Ctrl-S:Save  "
-        "F5:latexmk  Ctrl-C/V/X  Shift+Arrows  Ctrl-Q:Quit";
+        "F5:latexmk  Ctrl-C/V/X  Ctrl-Z/Y  Shift+Arrows  Ctrl-Q:Quit";
     int slen = (int)strlen(shortcuts);
     int left_space = width - slen - 2; // 2 for padding and separator
     if(left_space < 10) left_space = 10;
@@ -359,5 +387,6 @@ void tui_draw_status(WINDOW *w, const char *status){
         wattroff(w, COLOR_PAIR(IDY_PAIR_TEXT));
     }
 
-    wrefresh(w);
+    wnoutrefresh(w);
+    doupdate();
 }
@@ -1,9 +1,17 @@
 #include <napi.h>
+#include <algorithm>
+#include <atomic>
 #include <string>
+#include <thread>
+#include <unordered_set>
 #include <vector>
 #include <cstdlib>
 
 #include "db.h"
+#include "context_dump.h"
+#include "native_fs.h"
+#include "pdf_text.h"
+#include "unified_diff.h"
 
 class IdyDbWrap : public Napi::ObjectWrap<IdyDbWrap> {
 public:
@@ -27,6 +35,9 @@ public:
       InstanceMethod("ragQueryHitsIncludedOnly", &IdyDbWrap::RagQueryHitsIncludedOnly),
 
       InstanceMethod("deleteCell", &IdyDbWrap::DeleteCell),
+
+      // engine counters + manifest liveness + per-file stat, off the JS thread
+      InstanceMethod("statsSnapshot", &IdyDbWrap::StatsSnapshot),
     });
 
     exports.Set("IdyDb", fn);
@@ -37,7 +48,9 @@ public:
 
 private:
   idydb* db_ = nullptr;
-  
+  // Set while a worker owns db_; the handle is not safe for concurrent use.
+  bool busy_ = false;
+
   bool IsOk(int rc) {
     return rc == IDYDB_DONE || rc == IDYDB_SUCCESS;
   }
@@ -60,11 +73,20 @@ private:
       Napi::Error::New(env, "IdyDb is not open").ThrowAsJavaScriptException();
       return false;
     }
+    return EnsureIdle(env);
+  }
+
+  bool EnsureIdle(const Napi::Env& env) {
+    if (busy_) {
+      Napi::Error::New(env, "IdyDb is busy (statsSnapshot in flight)").ThrowAsJavaScriptException();
+      return false;
+    }
     return true;
   }
 
   Napi::Value Open(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
+    if (!EnsureIdle(env)) return env.Null();
     std::string path = info[0].As<Napi::String>();
     int flags = info[1].As<Napi::Number>().Int32Value();
 
@@ -78,6 +100,7 @@ private:
 
   Napi::Value Close(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
+    if (!EnsureIdle(env)) return env.Null();
     if (db_) {
       idydb_close(&db_);
       db_ = nullptr;
@@ -439,9 +462,228 @@ private:
 
     return arr;
   }
+
+  // ---------------------------------------------------------------------------
+  // stats snapshot
+  // ---------------------------------------------------------------------------
+
+  // One pass over the store (idydb_stats_collect) plus a parallel stat of every
+  // manifest file. Rows referenced by no manifest entry are reported as dead.
+  class StatsSnapshotWorker : public Napi::AsyncWorker {
+  public:
+    StatsSnapshotWorker(Napi::Env env, IdyDbWrap* wrap)
+      : Napi::AsyncWorker(env, "IdyDbStatsSnapshot"), wrap_(wrap), deferred_(Napi::Promise::Deferred::New(env)) {}
+
+    ~StatsSnapshotWorker() { idydb_stats_free(&stats_); }
+
+    Napi::Promise Promise() { return deferred_.Promise(); }
+
+    std::vector<std::string> paths;   // "" = not a local file, caller stats it
+    std::vector<double> mtimes;
+    std::vector<uint8_t> included;
+    std::vector<uint32_t> rows;       // all files' rows, concatenated
+    std::vector<uint32_t> rowEnds;    // end offset into rows, per file
+
+  protected:
+    void Execute() override {
+      int rc = idydb_stats_collect(&wrap_->db_, true, &stats_);
+      if (rc != IDYDB_DONE) {
+        const char* raw = wrap_->db_ ? idydb_errmsg(&wrap_->db_) : nullptr;
+        SetError(std::string("StatsSnapshot: IdyDB error rc=") + std::to_string(rc) +
+                 " msg=" + ((raw && *raw) ? raw : "(no error detail)"));
+        return;
+      }
+      Tally();
+      StatFiles();
+    }
+
+    void OnOK() override {
+      Napi::Env env = Env();
+      Release();
+
+      Napi::Object out = Napi::Object::New(env);
+      out.Set("fileBytes", Napi::Number::New(env, (double)stats_.file_bytes));
+      out.Set("cells", Napi::Number::New(env, (double)stats_.cells));
+      out.Set("nextRow", Napi::Number::New(env, (double)stats_.next_row));
+
+      Napi::Array cols = Napi::Array::New(env, stats_.ncolumns);
+      for (size_t i = 0; i < stats_.ncolumns; i++) {
+        const idydb_column_stats& c = stats_.columns[i];
+        Napi::Object o = Napi::Object::New(env);
+        o.Set("column", Napi::Number::New(env, (double)c.column));
+        o.Set("cells", Napi::Number::New(env, (double)c.cells));
+        o.Set("bytes", Napi::Number::New(env, (double)c.bytes));
+        o.Set("nextRow", Napi::Number::New(env, (double)c.next_row));
+        cols.Set((uint32_t)i, o);
+      }
+      out.Set("columns", cols);
+
+      out.Set("liveRows", Napi::Number::New(env, (double)liveRows_));
+      out.Set("liveBytes", Napi::Number::New(env, (double)liveBytes_));
+      out.Set("deadRows", Napi::Number::New(env, (double)deadRows_));
+      out.Set("deadBytes", Napi::Number::New(env, (double)deadBytes_));
+      out.Set("uniqueRowsAll", Napi::Number::New(env, (double)uniqueAll_));
+      out.Set("uniqueRowsIncluded", Napi::Number::New(env, (double)uniqueIncluded_));
+
+      Napi::Array files = Napi::Array::New(env, paths.size());
+      for (size_t i = 0; i < paths.size(); i++) {
+        Napi::Object f = Napi::Object::New(env);
+        f.Set("checked", Napi::Boolean::New(env, status_[i] != kUnchecked));
+        f.Set("stale", Napi::Boolean::New(env, status_[i] == kStale));
+        f.Set("missing", Napi::Boolean::New(env, status_[i] == kMissing));
+        f.Set("storedRows", Napi::Number::New(env, (double)fileRows_[i]));
+        f.Set("bytes", Napi::Number::New(env, (double)fileBytes_[i]));
+        files.Set((uint32_t)i, f);
+      }
+      out.Set("files", files);
+
+      deferred_.Resolve(out);
+    }
+
+    void OnError(const Napi::Error& e) override {
+      Release();
+      deferred_.Reject(e.Value());
+    }
+
+  private:
+    enum : uint8_t { kUnchecked = 0, kFresh, kStale, kMissing };
+
+    void Release() {
+      wrap_->busy_ = false;
+      wrap_->Unref();
+    }
+
+    unsigned long long RowBytes(uint32_t row) const {
+      return (row > 0 && row < stats_.next_row) ? stats_.row_bytes[row] : 0ULL;
+    }
+
+    void Tally() {
+      const size_t n = paths.size();
+      fileRows_.assign(n, 0);
+      fileBytes_.assign(n, 0);
+
+      // 1 = referenced, 2 = referenced by an included file; rows past the
+      // store's end hold no data and only count towards the unique totals.
+      std::vector<uint8_t> mark((size_t)stats_.next_row, 0);
+      std::unordered_set<uint32_t> beyondAll, beyondIncluded;
+
+      uint32_t begin = 0;
+      for (size_t i = 0; i < n; i++) {
+        const uint32_t end = std::min<uint32_t>(rowEnds[i], (uint32_t)rows.size());
+        const uint8_t bits = included[i] ? 3 : 1;
+        for (uint32_t j = begin; j < end; j++) {
+          const uint32_t row = rows[j];
+          if (row == 0) continue;
+          const unsigned long long b = RowBytes(row);
+          if (b) {
+            fileRows_[i]++;
+            fileBytes_[i] += b;
+          }
+          if (row < stats_.next_row) {
+            mark[row] |= bits;
+          } else {
+            beyondAll.insert(row);
+            if (included[i]) beyondIncluded.insert(row);
+          }
+        }
+        begin = std::max(begin, end);
+      }
+
+      uniqueAll_ = beyondAll.size();
+      uniqueIncluded_ = beyondIncluded.size();
+      for (size_t row = 1; row < mark.size(); row++) {
+        if (mark[row] & 1) uniqueAll_++;
+        if (mark[row] & 2) uniqueIncluded_++;
+        const unsigned long long b = stats_.row_bytes[row];
+        if (!b) continue;
+        if (mark[row]) {
+          liveRows_++;
+          liveBytes_ += b;
+        } else {
+          deadRows_++;
+          deadBytes_ += b;
+        }
+      }
+    }
+
+    void StatFiles() {
+      const size_t n = paths.size();
+      status_.assign(n, kUnchecked);
+      if (!n) return;
+
+      size_t workers = std::max(1u, std::thread::hardware_concurrency());
+      workers = std::min<size_t>(std::min<size_t>(workers, 8), (n + 63) / 64);
+
+      std::atomic<size_t> next(0);
+      auto run = [&]() {
+        for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < n;) {
+          if (paths[i].empty()) continue;
+          double m = 0;
+          if (!StatPath(paths[i], nullptr, &m)) status_[i] = kMissing;
+          else status_[i] = (m != mtimes[i]) ? kStale : kFresh;
+        }
+      };
+
+      std::vector<std::thread> pool;
+      for (size_t t = 1; t < workers; t++) pool.emplace_back(run);
+      run();
+      for (auto& th : pool) th.join();
+    }
+
+    IdyDbWrap* wrap_;
+    Napi::Promise::Deferred deferred_;
+    idydb_stats stats_ = {};
+
+    std::vector<uint8_t> status_;
+    std::vector<uint64_t> fileRows_, fileBytes_;
+    uint64_t liveRows_ = 0, liveBytes_ = 0, deadRows_ = 0, deadBytes_ = 0;
+    uint64_t uniqueAll_ = 0, uniqueIncluded_ = 0;
+  };
+
+  // JS: statsSnapshot(paths, mtimesMs, includedFlags, rows, rowEnds) -> Promise<snapshot>
+  //  paths:   string[] (local fs paths; "" skips the stat for that file)
+  //  mtimesMs: Float64Array, includedFlags: Uint8Array (per file)
+  //  rows:    Uint32Array, every file's rows concatenated; rowEnds: Uint32Array end offsets
+  Napi::Value StatsSnapshot(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (!EnsureOpen(env)) return env.Null();
+
+    Napi::Array pathsJs = info[0].As<Napi::Array>();
+    Napi::Float64Array mtimesJs = info[1].As<Napi::Float64Array>();
+    Napi::Uint8Array includedJs = info[2].As<Napi::Uint8Array>();
+    Napi::Uint32Array rowsJs = info[3].As<Napi::Uint32Array>();
+    Napi::Uint32Array rowEndsJs = info[4].As<Napi::Uint32Array>();
+
+    const uint32_t n = pathsJs.Length();
+    if (mtimesJs.ElementLength() != n || includedJs.ElementLength() != n || rowEndsJs.ElementLength() != n) {
+      Napi::TypeError::New(env, "statsSnapshot: per-file arrays must have one entry per path")
+        .ThrowAsJavaScriptException();
+      return env.Null();
+    }
+
+    auto* w = new StatsSnapshotWorker(env, this);
+    w->paths.reserve(n);
+    for (uint32_t i = 0; i < n; i++) {
+      Napi::Value v = pathsJs.Get(i);
+      w->paths.push_back(v.IsString() ? v.As<Napi::String>().Utf8Value() : std::string());
+    }
+    w->mtimes.assign(mtimesJs.Data(), mtimesJs.Data() + n);
+    w->included.assign(includedJs.Data(), includedJs.Data() + n);
+    w->rows.assign(rowsJs.Data(), rowsJs.Data() + rowsJs.ElementLength());
+    w->rowEnds.assign(rowEndsJs.Data(), rowEndsJs.Data() + n);
+
+    Napi::Promise promise = w->Promise();
+    busy_ = true;
+    Ref();
+    w->Queue();
+    return promise;
+  }
 };
 
 Napi::Object InitAll(Napi::Env env, Napi::Object exports) {
+  exports.Set("writeContextDump", Napi::Function::New(env, WriteContextDump, "writeContextDump"));
+  exports.Set("extractPdfText", Napi::Function::New(env, ExtractPdfText, "extractPdfText"));
+  exports.Set("applyUnifiedDiff", Napi::Function::New(env, ApplyUnifiedDiff, "applyUnifiedDiff"));
   return IdyDbWrap::Init(env, exports);
 }
 
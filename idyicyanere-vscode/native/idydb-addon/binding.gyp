@@ -4,6 +4,9 @@
       "target_name": "idydb",
       "sources": [
         "addon.cpp",
+        "context_dump.cpp",
+        "pdf_text.cpp",
+        "unified_diff.cpp",
         "idydb/impl/db.cpp"
       ],
       "include_dirs": [
@@ -14,7 +17,8 @@
         "<!(node -p \"require('node-addon-api').gyp\")"
       ],
       "defines": [
-        "NODE_ADDON_API_DISABLE_CPP_EXCEPTIONS"
+        "NODE_ADDON_API_DISABLE_CPP_EXCEPTIONS",
+        "CUWACUNU_CAMAHJUCUNU_DB_VERBOSE_DEBUG=1"
       ],
       "cflags_cc": [ "-std=c++17" ],
 
@@ -24,6 +28,7 @@
             "-Wl,-Bstatic",
             "-lcrypto",
             "-Wl,-Bdynamic",
+            "-lz",
             "-ldl",
             "-lpthread"
           ]
@@ -34,7 +39,7 @@
             "CLANG_CXX_LANGUAGE_STANDARD": "c++17",
             "MACOSX_DEPLOYMENT_TARGET": "10.15"
           },
-          "libraries": [ "-lssl", "-lcrypto" ],
+          "libraries": [ "-lssl", "-lcrypto", "-lz" ],
           "include_dirs": [
             "<!@(node -p \"require('node-addon-api').include\")",
             "idydb/include",
@@ -62,14 +67,17 @@
           "include_dirs": [
             "<!@(node -p \"require('node-addon-api').include\")",
             "idydb/include",
-            "<!(node -p \"process.env.OPENSSL_INCLUDE_DIR || ''\")"
+            "<!(node -p \"process.env.OPENSSL_INCLUDE_DIR || ''\")",
+            "<!(node -p \"process.env.ZLIB_INCLUDE_DIR || ''\")"
           ],
           "library_dirs": [
-            "<!(node -p \"process.env.OPENSSL_LIB_DIR || ''\")"
+            "<!(node -p \"process.env.OPENSSL_LIB_DIR || ''\")",
+            "<!(node -p \"process.env.ZLIB_LIB_DIR || ''\")"
           ],
           "libraries": [
             "libssl.lib",
-            "libcrypto.lib"
+            "libcrypto.lib",
+            "zlib.lib"
           ]
         }]
       ]
@@ -0,0 +1,578 @@
+#include "context_dump.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <openssl/evp.h>
+
+#include "native_fs.h"
+
+// Readers stat, probe, hash and decode files ahead of the writer; the writer
+// emits them strictly in order. The readahead window is bounded both in files
+// and in buffered bytes so a dump of a huge tree never holds it all in memory:
+// a reader reserves a file's bytes before reading it, and text larger than
+// kBufferFileBytes is not buffered at all (the writer re-reads and streams it).
+static const size_t kNullProbeBytes = 2048;
+static const size_t kReadChunk = 64 * 1024;
+static const size_t kReadaheadItems = 32;
+static const uint64_t kReadaheadBytes = 64ULL << 20;
+static const uint64_t kBufferFileBytes = kReadaheadBytes / 8;
+static const auto kProgressEvery = std::chrono::milliseconds(25);
+
+struct DumpItem {
+  std::string path;
+  std::string rel;
+  std::string lang;  // fence language ("" = bare fence)
+  bool hidden = false;
+  bool indexed = false;
+  bool stale = false;
+  bool hasMtime = false;  // stale derived from this writer's stat when set
+  double mtimeMs = 0;
+};
+
+struct DumpOptions {
+  uint64_t maxFileBytes = 0;  // 0 = unlimited
+  uint64_t maxTotalBytes = 0;
+  bool noFences = false;
+  bool listOnly = false;
+};
+
+struct DumpSlot {
+  bool ready = false;
+  bool missing = false;
+  bool binary = false;
+  bool stale = false;
+  bool stream = false;  // text over kBufferFileBytes: the writer reads it itself
+  uint64_t size = 0;  // stat size
+  uint64_t read = 0;  // content bytes read (<= maxFileBytes)
+  size_t lines = 0;
+  std::string sha;    // hex, or "n/a"
+  std::string text;   // decoded content (empty for listOnly and stream)
+};
+
+struct ProgressMsg {
+  size_t done;
+  size_t total;
+  std::string rel;
+  std::shared_ptr<std::atomic<bool>> cancel;
+};
+
+// Re-encodes bytes the way TextDecoder("utf-8", { fatal: false }) decodes them:
+// each maximal ill-formed subsequence becomes U+FFFD. Appends to *out and adds
+// to *lines; unless last, stops before a sequence cut off by the end of p and
+// returns how many bytes it consumed.
+static size_t DecodeUtf8(const unsigned char* p, size_t n, bool last, std::string* out, size_t* lines) {
+  static const char kReplacement[] = "\xEF\xBF\xBD";
+  size_t nl = 0;
+  size_t i = 0;
+  while (i < n) {
+    const unsigned char b = p[i];
+    if (b < 0x80) {
+      size_t j = i;
+      while (j < n && p[j] < 0x80) {
+        if (p[j] == '\n') nl++;
+        j++;
+      }
+      out->append((const char*)p + i, j - i);
+      i = j;
+      continue;
+    }
+
+    size_t need = 0;
+    unsigned char lo = 0x80, hi = 0xBF;
+    if (b >= 0xC2 && b <= 0xDF) {
+      need = 1;
+    } else if (b >= 0xE0 && b <= 0xEF) {
+      need = 2;
+      if (b == 0xE0) lo = 0xA0;
+      if (b == 0xED) hi = 0x9F;
+    } else if (b >= 0xF0 && b <= 0xF4) {
+      need = 3;
+      if (b == 0xF0) lo = 0x90;
+      if (b == 0xF4) hi = 0x8F;
+    } else {
+      out->append(kReplacement, 3);
+      i++;
+      continue;
+    }
+
+    size_t k = 1;
+    for (; k <= need && i + k < n; k++) {
+      const unsigned char c = p[i + k];
+      if (c < lo || c > hi) break;
+      lo = 0x80;
+      hi = 0xBF;
+    }
+    if (k <= need && i + k == n && !last) break;  // may complete in the next chunk
+    if (k > need) {
+      out->append((const char*)p + i, need + 1);
+    } else {
+      out->append(kReplacement, 3);  // the breaking byte is decoded afresh
+    }
+    i += k;
+  }
+  *lines += nl;
+  return i;
+}
+
+// DecodeUtf8 over a byte stream fed in chunks: drops a leading BOM and
+// carries a sequence split between chunks over to the next one.
+class Utf8Stream {
+public:
+  void Feed(const unsigned char* p, size_t n, std::string* out) { Feed(p, n, false, out); }
+  void Finish(std::string* out) { Feed(nullptr, 0, true, out); }
+  size_t Lines() const { return lines_; }
+
+private:
+  void Feed(const unsigned char* p, size_t n, bool last, std::string* out) {
+    if (!carry_.empty() || start_) {
+      const size_t take = std::min<size_t>(n, 4);
+      carry_.append((const char*)p, take);
+      p += take;
+      n -= take;
+      const bool end = last && n == 0;
+      if (start_) {
+        if (carry_.size() < 3 && !end) return;
+        start_ = false;
+        if (carry_.compare(0, 3, "\xEF\xBB\xBF") == 0) carry_.erase(0, 3);
+      }
+      const size_t used = DecodeUtf8((const unsigned char*)carry_.data(), carry_.size(), end, out, &lines_);
+      if (n == 0) {
+        carry_.erase(0, used);
+        return;
+      }
+      // A cut-off sequence is at most 3 bytes, all from the 4 taken from p
+      const size_t left = carry_.size() - used;
+      p -= left;
+      n += left;
+      carry_.clear();
+    }
+    if (n == 0) return;
+    const size_t used = DecodeUtf8(p, n, last, out, &lines_);
+    carry_.assign((const char*)p + used, n - used);
+  }
+
+  std::string carry_;
+  bool start_ = true;
+  size_t lines_ = 0;
+};
+
+// Stat half of a read: false when the file is gone.
+static bool StatItem(const DumpItem& it, DumpSlot* s) {
+  double mtime = 0;
+  if (!StatPath(it.path, &s->size, &mtime)) {
+    s->missing = true;
+    return false;
+  }
+  s->stale = it.hasMtime ? (mtime != it.mtimeMs) : it.stale;
+  return true;
+}
+
+// Hashes the whole file and probes it for NULs; its first `want` bytes are
+// decoded into s->text when keep is set, else only their lines are counted.
+static void ReadItem(const DumpItem& it, uint64_t want, bool keep, DumpSlot* s) {
+  std::FILE* f = OpenPath(it.path, "rb");
+  if (!f) {
+    // unreadable: like the TS writer, treat as binary with no hash
+    s->binary = true;
+    s->sha = "n/a";
+    return;
+  }
+
+  if (keep) s->text.reserve((size_t)want);
+  std::vector<unsigned char> buf(kReadChunk);
+  Utf8Stream text;
+
+  EVP_MD_CTX* md = EVP_MD_CTX_new();
+  bool hashed = md && EVP_DigestInit_ex(md, EVP_sha256(), nullptr) == 1;
+  uint64_t off = 0;
+  for (;;) {
+    const size_t got = std::fread(buf.data(), 1, buf.size(), f);
+    if (got == 0) {
+      if (std::ferror(f)) hashed = false;
+      break;
+    }
+    if (off < kNullProbeBytes) {
+      const size_t m = (size_t)std::min<uint64_t>(got, kNullProbeBytes - off);
+      if (std::memchr(buf.data(), 0, m)) s->binary = true;
+    }
+    if (!s->binary && off < want) {
+      const size_t m = (size_t)std::min<uint64_t>(got, want - off);
+      if (keep) {
+        text.Feed(buf.data(), m, &s->text);
+      } else {
+        s->lines += (size_t)std::count(buf.data(), buf.data() + m, (unsigned char)'\n');
+      }
+      s->read += m;
+    }
+    if (hashed) hashed = EVP_DigestUpdate(md, buf.data(), got) == 1;
+    off += got;
+  }
+  std::fclose(f);
+
+  unsigned char digest[EVP_MAX_MD_SIZE];
+  unsigned int len = 0;
+  if (hashed && EVP_DigestFinal_ex(md, digest, &len) == 1) {
+    static const char kHex[] = "0123456789abcdef";
+    s->sha.resize((size_t)len * 2);
+    for (unsigned int i = 0; i < len; i++) {
+      s->sha[i * 2] = kHex[digest[i] >> 4];
+      s->sha[i * 2 + 1] = kHex[digest[i] & 15];
+    }
+  } else {
+    s->sha = "n/a";
+  }
+  EVP_MD_CTX_free(md);
+
+  if (s->binary) {
+    std::string().swap(s->text);
+    s->read = 0;
+    s->lines = 0;
+    return;
+  }
+  if (keep) {
+    text.Finish(&s->text);
+    s->lines = text.Lines();
+  }
+}
+
+static const char* Bool(bool v) { return v ? "true" : "false"; }
+
+class ContextDumpWorker : public Napi::AsyncWorker {
+public:
+  ContextDumpWorker(Napi::Env env)
+    : Napi::AsyncWorker(env, "IdyContextDump"),
+      deferred_(Napi::Promise::Deferred::New(env)),
+      cancel_(std::make_shared<std::atomic<bool>>(false)) {}
+
+  Napi::Promise Promise() { return deferred_.Promise(); }
+
+  void SetProgress(Napi::ThreadSafeFunction fn) {
+    progress_ = fn;
+    hasProgress_ = true;
+  }
+
+  std::string outputPath;
+  std::string header;
+  std::vector<DumpItem> items;
+  DumpOptions opts;
+
+protected:
+  void Execute() override {
+    std::FILE* out = OpenPath(outputPath, "wb");
+    if (!out) {
+      SetError("writeContextDump: cannot open " + outputPath);
+      ReleaseProgress();
+      return;
+    }
+    std::vector<char> obuf(1 << 20);
+    std::setvbuf(out, obuf.data(), _IOFBF, obuf.size());
+    out_ = out;
+
+    const size_t n = items.size();
+    slots_.resize(n);
+    size_t readers = std::max(1u, std::thread::hardware_concurrency());
+    readers = std::min<size_t>(std::min<size_t>(readers, 8), n);
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < readers; t++) pool.emplace_back([this] { ReadLoop(); });
+
+    Emit(header);
+    for (size_t i = 0; i < n; i++) {
+      if (cancel_->load()) {
+        cancelled_ = true;
+        Emit("### Cancelled by user.\n");
+        break;
+      }
+      Progress(i);
+
+      if (opts.maxTotalBytes > 0 && totalBytes_ >= opts.maxTotalBytes) {
+        stoppedByMaxTotal_ = true;
+        Emit("### Reached --max-total=" + std::to_string(opts.maxTotalBytes) + " bytes. Stopping.\n");
+        break;
+      }
+
+      DumpSlot s;
+      {
+        std::unique_lock<std::mutex> lk(mu_);
+        readyCv_.wait(lk, [&] { return slots_[i].ready; });
+        s = std::move(slots_[i]);
+        slots_[i] = DumpSlot();
+        buffered_ -= s.text.size();
+        written_ = i + 1;
+      }
+      spaceCv_.notify_all();
+
+      if (!WriteItem(items[i], s)) break;
+    }
+
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      stop_ = true;
+    }
+    spaceCv_.notify_all();
+    for (auto& th : pool) th.join();
+
+    const bool failed = std::ferror(out) != 0;
+    if (std::fclose(out) != 0 || failed) SetError("writeContextDump: failed writing " + outputPath);
+    ReleaseProgress();
+  }
+
+  void OnOK() override {
+    Napi::Env env = Env();
+    Napi::Object r = Napi::Object::New(env);
+    r.Set("cancelled", Napi::Boolean::New(env, cancelled_));
+    r.Set("includedWritten", Napi::Number::New(env, (double)includedWritten_));
+    r.Set("skippedMissing", Napi::Number::New(env, (double)skippedMissing_));
+    r.Set("skippedBinary", Napi::Number::New(env, (double)skippedBinary_));
+    r.Set("truncatedFiles", Napi::Number::New(env, (double)truncatedFiles_));
+    r.Set("stoppedByMaxTotal", Napi::Boolean::New(env, stoppedByMaxTotal_));
+    r.Set("totalBytesWritten", Napi::Number::New(env, (double)totalBytes_));
+    deferred_.Resolve(r);
+  }
+
+  void OnError(const Napi::Error& e) override {
+    deferred_.Reject(e.Value());
+  }
+
+private:
+  void ReadLoop() {
+    for (;;) {
+      size_t i;
+      {
+        std::unique_lock<std::mutex> lk(mu_);
+        spaceCv_.wait(lk, [&] {
+          return stop_ || next_ >= items.size() ||
+                 (next_ < written_ + kReadaheadItems && (buffered_ < kReadaheadBytes || next_ == written_));
+        });
+        if (stop_ || next_ >= items.size()) return;
+        i = next_++;
+      }
+      DumpSlot s;
+      uint64_t reserved = 0;
+      if (StatItem(items[i], &s)) {
+        const uint64_t want = opts.maxFileBytes > 0 ? std::min(s.size, opts.maxFileBytes) : s.size;
+        s.stream = !opts.listOnly && want > kBufferFileBytes;
+        const bool keep = !opts.listOnly && !s.stream;
+        if (keep) {
+          // Reserve the text before reading it; the writer's next file always fits
+          std::unique_lock<std::mutex> lk(mu_);
+          spaceCv_.wait(lk, [&] { return stop_ || i == written_ || buffered_ + want <= kReadaheadBytes; });
+          if (stop_) return;
+          buffered_ += want;
+          reserved = want;
+        }
+        ReadItem(items[i], want, keep, &s);
+      }
+      {
+        std::lock_guard<std::mutex> lk(mu_);
+        buffered_ = buffered_ - reserved + s.text.size();
+        s.ready = true;
+        slots_[i] = std::move(s);
+      }
+      readyCv_.notify_all();
+    }
+  }
+
+  void Emit(const std::string& s) {
+    if (!s.empty()) std::fwrite(s.data(), 1, s.size(), out_);
+  }
+
+  // Returns false once the max-total limit stops the dump.
+  bool WriteItem(const DumpItem& it, const DumpSlot& s) {
+    if (s.missing) {
+      skippedMissing_++;
+      Emit("===== FILE (skipped missing): " + it.rel + " (hidden=" + Bool(it.hidden) + ") =====\n\n");
+      return true;
+    }
+    const std::string flags = std::string("hidden=") + Bool(it.hidden) + ", stale=" + Bool(s.stale) +
+                              ", indexed=" + Bool(it.indexed);
+    if (s.binary) {
+      skippedBinary_++;
+      Emit("===== FILE (skipped binary): " + it.rel + " (bytes=" + std::to_string(s.size) + ", sha256=" + s.sha +
+           ", " + flags + ") =====\n\n");
+      return true;
+    }
+
+    Emit("===== FILE: " + it.rel + " (bytes=" + std::to_string(s.size) + ", lines=" + std::to_string(s.lines) +
+         ", sha256=" + s.sha + ", " + flags + ") =====\n");
+    if (opts.listOnly) {
+      Emit("\n");
+      includedWritten_++;
+      return true;
+    }
+
+    if (!opts.noFences) Emit(it.lang.empty() ? "```\n" : "```" + it.lang + "\n");
+    if (s.stream) {
+      StreamText(it, s);
+    } else {
+      Emit(s.text);
+    }
+    if (!opts.noFences) Emit("\n```\n");
+    if (opts.maxFileBytes > 0 && s.size > opts.maxFileBytes) {
+      truncatedFiles_++;
+      Emit("<<< TRUNCATED to " + std::to_string(opts.maxFileBytes) + " bytes (original: " + std::to_string(s.size) +
+           " bytes) >>>\n");
+    }
+    Emit("\n");
+
+    includedWritten_++;
+    totalBytes_ += s.read;
+    if (opts.maxTotalBytes > 0 && totalBytes_ >= opts.maxTotalBytes) {
+      stoppedByMaxTotal_ = true;
+      Emit("### Reached --max-total=" + std::to_string(opts.maxTotalBytes) + " bytes. Stopping.\n");
+      return false;
+    }
+    return true;
+  }
+
+  // Emits the first s.read bytes of a file too large to buffer, decoding them
+  // chunk by chunk (the reader already hashed it and counted its lines).
+  void StreamText(const DumpItem& it, const DumpSlot& s) {
+    std::FILE* f = OpenPath(it.path, "rb");
+    if (!f) return;
+    std::vector<unsigned char> buf(kReadChunk);
+    std::string text;
+    Utf8Stream dec;
+    uint64_t left = s.read;
+    while (left > 0) {
+      const size_t got = std::fread(buf.data(), 1, (size_t)std::min<uint64_t>(buf.size(), left), f);
+      if (got == 0) break;
+      left -= got;
+      text.clear();
+      dec.Feed(buf.data(), got, &text);
+      Emit(text);
+    }
+    std::fclose(f);
+    text.clear();
+    dec.Finish(&text);
+    Emit(text);
+  }
+
+  static void CallProgress(Napi::Env env, Napi::Function fn, ProgressMsg* p) {
+    if (env != nullptr && fn != nullptr) {
+      Napi::Value r = fn.Call({
+        Napi::Number::New(env, (double)p->done),
+        Napi::Number::New(env, (double)p->total),
+        Napi::String::New(env, p->rel),
+      });
+      if (env.IsExceptionPending()) {
+        env.GetAndClearPendingException();
+      } else if (r.IsBoolean() && r.As<Napi::Boolean>().Value()) {
+        p->cancel->store(true);
+      }
+    }
+    delete p;
+  }
+
+  void Progress(size_t i) {
+    if (!hasProgress_) return;
+    const auto now = std::chrono::steady_clock::now();
+    if (i != 0 && i + 1 != items.size() && now - lastProgress_ < kProgressEvery) return;
+    lastProgress_ = now;
+    auto* p = new ProgressMsg{i + 1, items.size(), items[i].rel, cancel_};
+    if (progress_.NonBlockingCall(p, CallProgress) != napi_ok) delete p;
+  }
+
+  void ReleaseProgress() {
+    if (hasProgress_) progress_.Release();
+    hasProgress_ = false;
+  }
+
+  Napi::Promise::Deferred deferred_;
+  std::shared_ptr<std::atomic<bool>> cancel_;
+  Napi::ThreadSafeFunction progress_;
+  bool hasProgress_ = false;
+  std::chrono::steady_clock::time_point lastProgress_;
+
+  std::FILE* out_ = nullptr;
+  std::mutex mu_;
+  std::condition_variable readyCv_, spaceCv_;
+  std::vector<DumpSlot> slots_;
+  size_t next_ = 0, written_ = 0;
+  uint64_t buffered_ = 0;
+  bool stop_ = false;
+
+  bool cancelled_ = false, stoppedByMaxTotal_ = false;
+  uint64_t includedWritten_ = 0, skippedMissing_ = 0, skippedBinary_ = 0, truncatedFiles_ = 0;
+  uint64_t totalBytes_ = 0;
+};
+
+static std::string StringProp(const Napi::Object& o, const char* key) {
+  Napi::Value v = o.Get(key);
+  return v.IsString() ? v.As<Napi::String>().Utf8Value() : std::string();
+}
+
+static bool BoolProp(const Napi::Object& o, const char* key) {
+  Napi::Value v = o.Get(key);
+  return v.IsBoolean() && v.As<Napi::Boolean>().Value();
+}
+
+static uint64_t SizeProp(const Napi::Object& o, const char* key) {
+  Napi::Value v = o.Get(key);
+  if (!v.IsNumber()) return 0;
+  const double d = v.As<Napi::Number>().DoubleValue();
+  return d > 0 ? (uint64_t)d : 0;
+}
+
+Napi::Value WriteContextDump(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 4 || !info[0].IsString() || !info[1].IsArray() || !info[2].IsArray() || !info[3].IsObject()) {
+    Napi::TypeError::New(env, "writeContextDump(outputPath, headerLines, items, opts, onProgress?)")
+      .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  auto* w = new ContextDumpWorker(env);
+  w->outputPath = info[0].As<Napi::String>().Utf8Value();
+
+  Napi::Array headerJs = info[1].As<Napi::Array>();
+  for (uint32_t i = 0; i < headerJs.Length(); i++) {
+    Napi::Value v = headerJs.Get(i);
+    if (v.IsString()) w->header += v.As<Napi::String>().Utf8Value();
+    w->header += "\n";
+  }
+  w->header += "\n";
+
+  Napi::Array itemsJs = info[2].As<Napi::Array>();
+  w->items.reserve(itemsJs.Length());
+  for (uint32_t i = 0; i < itemsJs.Length(); i++) {
+    Napi::Value v = itemsJs.Get(i);
+    if (!v.IsObject()) continue;
+    Napi::Object o = v.As<Napi::Object>();
+    DumpItem it;
+    it.path = StringProp(o, "path");
+    it.rel = StringProp(o, "rel");
+    it.lang = StringProp(o, "lang");
+    it.hidden = BoolProp(o, "hidden");
+    it.indexed = BoolProp(o, "indexed");
+    it.stale = BoolProp(o, "stale");
+    Napi::Value m = o.Get("mtimeMs");
+    if (m.IsNumber()) {
+      it.hasMtime = true;
+      it.mtimeMs = m.As<Napi::Number>().DoubleValue();
+    }
+    w->items.push_back(std::move(it));
+  }
+
+  Napi::Object optsJs = info[3].As<Napi::Object>();
+  w->opts.maxFileBytes = SizeProp(optsJs, "maxFileBytes");
+  w->opts.maxTotalBytes = SizeProp(optsJs, "maxTotalBytes");
+  w->opts.noFences = BoolProp(optsJs, "noFences");
+  w->opts.listOnly = BoolProp(optsJs, "listOnly");
+
+  if (info.Length() >= 5 && info[4].IsFunction()) {
+    w->SetProgress(Napi::ThreadSafeFunction::New(env, info[4].As<Napi::Function>(), "IdyContextDumpProgress", 0, 1));
+  }
+
+  Napi::Promise promise = w->Promise();
+  w->Queue();
+  return promise;
+}
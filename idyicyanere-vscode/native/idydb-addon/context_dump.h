@@ -0,0 +1,9 @@
+#pragma once
+#include <napi.h>
+
+// JS: writeContextDump(outputPath, headerLines, items, opts, onProgress) -> Promise<result>
+//  items: [{ path, rel, lang, hidden, indexed, stale, mtimeMs? }] in output order
+//  opts:  { maxFileBytes, maxTotalBytes, noFences, listOnly }
+//  onProgress(done, total, rel) -> true to cancel; called from the JS thread
+// Same text format as src/export/contextDumpWriter.ts.
+Napi::Value WriteContextDump(const Napi::CallbackInfo& info);
@@ -0,0 +1,97 @@
+/* idydb engine throughput through the C ABI, as both front-ends use it
+   (the addon and the terminal client link the same library):
+     cmake -S . -B build -DIDYDB_BUILD_BENCH=ON && cmake --build build
+     ./build/idydb_bench [rows] [dims] [queries]
+   Times vector and text inserts, a full extract scan and kNN queries,
+   on a scratch file that is removed afterwards. The defaults (2000 rows of
+   384 dims, 50 queries) run in about 6 s, mostly inserts; insert time grows
+   quadratically with rows (4000 rows: about 20 s, 20000 rows: minutes). */
+#include "db.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define COL_VEC 1
+#define COL_TXT 2
+
+static double now_s(void){
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static unsigned rng_state = 2463534242u;
+static float frand(void){
+    rng_state ^= rng_state << 13; rng_state ^= rng_state >> 17; rng_state ^= rng_state << 5;
+    return (float)(rng_state >> 8) / (float)(1u << 24) - 0.5f;
+}
+
+static void report(const char *what, size_t n, double secs){
+    printf("%-22s %10zu ops %10.3f s %12.0f ops/s\n", what, n, secs, secs > 0 ? (double)n / secs : 0.0);
+}
+
+static int fail(idydb **db, const char *what){
+    fprintf(stderr, "%s failed: %s\n", what, *db ? idydb_errmsg(db) : "(no handle)");
+    if(*db) idydb_close(db);
+    return 1;
+}
+
+int main(int argc, char **argv){
+    size_t rows = argc > 1 ? (size_t)atol(argv[1]) : 2000;
+    unsigned short dims = argc > 2 ? (unsigned short)atoi(argv[2]) : 384;
+    size_t queries = argc > 3 ? (size_t)atol(argv[3]) : 50;
+    if(rows < 1) rows = 1;
+    if(dims < 1) dims = 1;
+
+    char path[] = "/tmp/idydb-bench-XXXXXX";
+    int fd = mkstemp(path);
+    if(fd < 0){ perror("mkstemp"); return 1; }
+    close(fd); unlink(path);
+
+    float *vecs = (float*)malloc(rows * dims * sizeof(float));
+    if(!vecs){ fprintf(stderr, "out of memory\n"); return 1; }
+    for(size_t i = 0; i < rows * dims; i++) vecs[i] = frand();
+
+    idydb *db = NULL;
+    if(idydb_open(path, &db, IDYDB_CREATE) != IDYDB_SUCCESS) return fail(&db, "open");
+    printf("idydb %#x: rows=%zu dims=%u queries=%zu\n", idydb_version_check(), rows, (unsigned)dims, queries);
+
+    double t0 = now_s();
+    for(size_t r = 0; r < rows; r++)
+        if(idydb_insert_vector(&db, COL_VEC, (idydb_column_row_sizing)(r + 1), vecs + r * dims, dims) != IDYDB_DONE)
+            return fail(&db, "insert_vector");
+    report("insert vector", rows, now_s() - t0);
+
+    char text[96];
+    t0 = now_s();
+    for(size_t r = 0; r < rows; r++){
+        snprintf(text, sizeof(text), "chunk %zu of the benchmark corpus", r);
+        if(idydb_insert_const_char(&db, COL_TXT, (idydb_column_row_sizing)(r + 1), text) != IDYDB_DONE)
+            return fail(&db, "insert_const_char");
+    }
+    report("insert text", rows, now_s() - t0);
+    idydb_close(&db);
+
+    if(idydb_open(path, &db, IDYDB_READONLY) != IDYDB_SUCCESS) return fail(&db, "reopen");
+    size_t seen = 0;
+    t0 = now_s();
+    for(size_t r = 0; r < rows; r++)
+        if(idydb_extract(&db, COL_TXT, (idydb_column_row_sizing)(r + 1)) == IDYDB_DONE) seen++;
+    report("extract text", rows, now_s() - t0);
+    if(seen != rows){ fprintf(stderr, "extract: %zu of %zu rows\n", seen, rows); idydb_close(&db); return 1; }
+
+    idydb_knn_result res[10];
+    t0 = now_s();
+    for(size_t q = 0; q < queries; q++){
+        const float *query = vecs + (q % rows) * dims;
+        int n = idydb_knn_search_vector_column(&db, COL_VEC, query, dims, 10, IDYDB_SIM_COSINE, res);
+        if(n <= 0 || res[0].row != (idydb_column_row_sizing)(q % rows + 1)) return fail(&db, "knn (self match)");
+    }
+    report("knn top-10 (cosine)", queries, now_s() - t0);
+
+    idydb_close(&db);
+    unlink(path);
+    free(vecs);
+    return 0;
+}
@@ -3501,6 +3501,135 @@ idydb_column_row_sizing idydb_column_next_row(idydb **handler, idydb_column_row_
 	return (idydb_column_row_sizing)(max_row + 1);
 }
 
+/* ---------------- storage statistics ---------------- */
+
+static bool idydb_stats_read(idydb **handler, idydb_sizing_max position, void* out, size_t size)
+{
+	if ((position + size) > (*handler)->size) return false;
+#ifdef IDYDB_MMAP_OK
+	if ((*handler)->read_only == IDYDB_READONLY_MMAPPED)
+	{
+		memcpy(out, ((const char*)(*handler)->buffer) + position, size);
+		return true;
+	}
+#endif
+	if (fseek((*handler)->file_descriptor, (long)position, SEEK_SET) != 0) return false;
+	return fread(out, 1, size, (*handler)->file_descriptor) == size;
+}
+
+/* One sequential pass over the partitions. Each segment (row, type, payload) is
+ * charged to its cell and a partition header (skip, row count) to the cell that
+ * opens it, so the per-column and the per-row byte totals both sum to the file. */
+int idydb_stats_collect(idydb **handler, bool per_row, idydb_stats* out)
+{
+	if (!out) return IDYDB_ERROR;
+	memset(out, 0, sizeof(*out));
+	if (!handler || !(*handler)) return IDYDB_ERROR;
+	if (!(*handler)->configured)
+	{
+		idydb_error_state(handler, 8);
+		return IDYDB_ERROR;
+	}
+	out->file_bytes = (unsigned long long)(*handler)->size;
+	out->next_row = 1;
+	if (per_row)
+	{
+		out->row_bytes = (unsigned long long*)calloc((size_t)IDYDB_ROW_POSITION_MAX + 2, sizeof(unsigned long long));
+		if (!out->row_bytes)
+		{
+			idydb_error_state(handler, 24);
+			return IDYDB_ERROR;
+		}
+	}
+
+	size_t capacity = 0;
+	idydb_sizing_max offset = 0;
+	idydb_column_row_sizing column = 0;
+	unsigned int remaining = 0;
+	unsigned char error_id = 0;
+	while (offset < (*handler)->size)
+	{
+		unsigned long long header = IDYDB_SEGMENT_SIZE;
+		if (remaining == 0)
+		{
+			unsigned short partition[2];
+			if (!idydb_stats_read(handler, offset, partition, sizeof(partition))) { error_id = 13; break; }
+			column += (idydb_column_row_sizing)partition[0] + 1;
+			remaining = (unsigned int)partition[1] + 1;
+			offset += IDYDB_PARTITION_SIZE;
+			header += IDYDB_PARTITION_SIZE;
+			if (out->ncolumns == capacity)
+			{
+				size_t grown = capacity ? capacity * 2 : 16;
+				idydb_column_stats* columns = (idydb_column_stats*)realloc(out->columns, grown * sizeof(idydb_column_stats));
+				if (!columns) { error_id = 24; break; }
+				out->columns = columns;
+				capacity = grown;
+			}
+			memset(&out->columns[out->ncolumns], 0, sizeof(idydb_column_stats));
+			out->columns[out->ncolumns++].column = column;
+		}
+		unsigned char segment[IDYDB_SEGMENT_SIZE];
+		if (!idydb_stats_read(handler, offset, segment, sizeof(segment))) { error_id = 13; break; }
+		unsigned short row_position;
+		memcpy(&row_position, segment, sizeof(short));
+		if (row_position > IDYDB_ROW_POSITION_MAX) { error_id = 22; break; }
+		offset += IDYDB_SEGMENT_SIZE;
+
+		unsigned long long payload = 0;
+		unsigned short length = 0;
+		switch (segment[sizeof(short)])
+		{
+		case IDYDB_READ_INT:   payload = sizeof(int); break;
+		case IDYDB_READ_FLOAT: payload = sizeof(float); break;
+		case IDYDB_READ_BOOL_TRUE:
+		case IDYDB_READ_BOOL_FALSE:
+			break;
+		case IDYDB_READ_CHAR:
+			if (!idydb_stats_read(handler, offset, &length, sizeof(short))) { error_id = 14; break; }
+			payload = sizeof(short) + (unsigned long long)length + 1;
+			break;
+		case IDYDB_READ_VECTOR:
+			if (!idydb_stats_read(handler, offset, &length, sizeof(short))) { error_id = 14; break; }
+			payload = sizeof(short) + (unsigned long long)length * sizeof(float);
+			break;
+		default:
+			error_id = 20;
+			break;
+		}
+		if (error_id) break;
+		offset += payload;
+		if (offset > (*handler)->size) { error_id = 13; break; }
+
+		idydb_column_stats* c = &out->columns[out->ncolumns - 1];
+		idydb_column_row_sizing row = (idydb_column_row_sizing)row_position + 1;
+		c->cells += 1;
+		c->bytes += header + payload;
+		if (row >= c->next_row) c->next_row = row + 1;
+		if (c->next_row > out->next_row) out->next_row = c->next_row;
+		if (per_row) out->row_bytes[row] += header + payload;
+		out->cells += 1;
+		remaining -= 1;
+	}
+	if (error_id)
+	{
+		idydb_stats_free(out);
+		idydb_error_state(handler, error_id);
+		return (error_id == 14 || error_id == 24) ? IDYDB_ERROR : IDYDB_CORRUPT;
+	}
+	return IDYDB_DONE;
+}
+
+void idydb_stats_free(idydb_stats* stats)
+{
+	if (!stats) return;
+	free(stats->columns);
+	free(stats->row_bytes);
+	stats->columns = NULL;
+	stats->row_bytes = NULL;
+	stats->ncolumns = 0;
+}
+
 /* ---------------- RAG helpers (unchanged from your version) ---------------- */
 
 void idydb_set_embedder(idydb **handler, idydb_embed_fn fn, void* user) {
@@ -5,6 +5,9 @@
 #define idydb_h
 
 /* ---------------- Symbol visibility / DLL support ----------------
+ * The functions below are the library's C ABI, shared by the N-API addon and
+ * the terminal client (see CMakeLists.txt for the installable static/shared
+ * library). Only idydb_extern symbols are exported from a shared build.
  * - Static builds: nothing special.
  * - Windows DLL:
  *     - Define IDYDB_BUILD_DLL when building the library
@@ -18,11 +21,15 @@
   #else
     #define IDYDB_API
   #endif
+#elif defined(__GNUC__) && __GNUC__ >= 4
+  #define IDYDB_API __attribute__((visibility("default")))
 #else
   #define IDYDB_API
 #endif
 
-#define CUWACUNU_CAMAHJUCUNU_DB_VERBOSE_DEBUG 1 // enable debug mode
+/* Verbose "[DB]" tracing of every cell write goes to stdout, so it is opt-in:
+ * define CUWACUNU_CAMAHJUCUNU_DB_VERBOSE_DEBUG when compiling db.cpp
+ * (CMake: -DIDYDB_VERBOSE_DEBUG=ON). */
 
 #include <stdbool.h>
 #include <stddef.h>
@@ -235,6 +242,31 @@ idydb_extern int idydb_knn_search_vector_column_filtered(idydb **handler,
  
 idydb_extern idydb_column_row_sizing idydb_column_next_row(idydb **handler, idydb_column_row_sizing column);
 
+/* --------------------------- Storage statistics --------------------------- */
+
+typedef struct {
+    idydb_column_row_sizing column;   /* 1-based */
+    unsigned long long cells;         /* non-null cells */
+    unsigned long long bytes;         /* on-disk bytes, headers included */
+    idydb_column_row_sizing next_row; /* highest occupied row + 1 */
+} idydb_column_stats;
+
+typedef struct {
+    unsigned long long file_bytes;     /* plaintext store size */
+    unsigned long long cells;          /* non-null cells, all columns */
+    idydb_column_row_sizing next_row;  /* highest occupied row + 1, any column */
+    size_t ncolumns;
+    idydb_column_stats* columns;       /* occupied columns, ascending */
+    unsigned long long* row_bytes;     /* on-disk bytes per row, indexed [1, next_row); NULL unless per_row */
+} idydb_stats;
+
+/**
+ * @brief Collect cell/byte counts per column (and optionally per row) in one pass over the store.
+ * Returns IDYDB_DONE on success; release the arrays with idydb_stats_free.
+ */
+idydb_extern int idydb_stats_collect(idydb **handler, bool per_row, idydb_stats* out);
+idydb_extern void idydb_stats_free(idydb_stats* stats);
+
 idydb_extern int idydb_rag_upsert_text(idydb **handler,
                                        idydb_column_row_sizing text_column,
                                        idydb_column_row_sizing vector_column,
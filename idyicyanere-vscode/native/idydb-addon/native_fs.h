@@ -0,0 +1,59 @@
+#pragma once
+// Filesystem helpers for the addon's worker threads. Paths are UTF-8 on every
+// platform (what JS strings convert to); Windows goes through the wide APIs.
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#ifdef _WIN32
+static inline std::wstring WidePath(const std::string& path) {
+  int n = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+  if (n <= 0) return std::wstring();
+  std::wstring w((size_t)n, L'\0');
+  MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &w[0], n);
+  w.resize((size_t)n - 1);
+  return w;
+}
+#endif
+
+// Size and modification time in whole milliseconds, as vscode.workspace.fs.stat
+// reports it. False when the path cannot be stat'ed (treated as missing).
+static inline bool StatPath(const std::string& path, uint64_t* size, double* mtimeMs) {
+#ifdef _WIN32
+  std::wstring w = WidePath(path);
+  WIN32_FILE_ATTRIBUTE_DATA a;
+  if (w.empty() || !GetFileAttributesExW(w.c_str(), GetFileExInfoStandard, &a)) return false;
+  ULARGE_INTEGER t;
+  t.LowPart = a.ftLastWriteTime.dwLowDateTime;
+  t.HighPart = a.ftLastWriteTime.dwHighDateTime;
+  if (size) *size = ((uint64_t)a.nFileSizeHigh << 32) | a.nFileSizeLow;
+  if (mtimeMs) *mtimeMs = (double)((t.QuadPart - 116444736000000000ULL) / 10000ULL);
+#else
+  struct stat st;
+  if (::stat(path.c_str(), &st) != 0) return false;
+#ifdef __APPLE__
+  const struct timespec& m = st.st_mtimespec;
+#else
+  const struct timespec& m = st.st_mtim;
+#endif
+  if (size) *size = (uint64_t)st.st_size;
+  if (mtimeMs) *mtimeMs = (double)((long long)m.tv_sec * 1000LL + (long long)(m.tv_nsec / 1000000L));
+#endif
+  return true;
+}
+
+static inline std::FILE* OpenPath(const std::string& path, const char* mode) {
+#ifdef _WIN32
+  std::wstring w = WidePath(path);
+  std::wstring wm(mode, mode + std::char_traits<char>::length(mode));
+  return w.empty() ? nullptr : _wfopen(w.c_str(), wm.c_str());
+#else
+  return std::fopen(path.c_str(), mode);
+#endif
+}
@@ -0,0 +1,1509 @@
+#include "pdf_text.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <zlib.h>
+
+// Objects are located through the xref (tables, xref streams, /Prev chains and
+// hybrid /XRefStm sections); when it is missing or points at the wrong bytes,
+// every "N G obj" header in the file is indexed instead. Streams are decoded
+// from views into the caller's buffer. The page tree is walked once, then each
+// page's content streams are inflated and parsed on a worker thread. Inflated
+// output is capped per stream and per document (zip bombs end as warnings).
+static const uint64_t kMaxObjects = 1ULL << 23;
+static const int kMaxDepth = 64;  // nesting, page tree, /Prev chain and ref chain guard
+static const size_t kInflateChunk = 256 * 1024;
+static const size_t kMaxStreamBytes = 64u << 20;
+static const uint64_t kMaxDocBytes = 256ULL << 20;
+static const size_t kMaxWorkers = 8;
+static const double kKernSpace = 200;  // TJ gap (1/1000 em) read as a word break
+
+struct Bytes {
+  const uint8_t* p = nullptr;
+  size_t n = 0;
+};
+
+static const size_t kNpos = (size_t)-1;
+
+// ---- lexing ----
+
+static inline bool PdfWs(uint8_t c) {
+  return c == 0 || c == '\t' || c == '\n' || c == '\f' || c == '\r' || c == ' ';
+}
+
+static inline bool PdfDelim(uint8_t c) {
+  return c == '(' || c == ')' || c == '<' || c == '>' || c == '[' || c == ']' || c == '{' || c == '}' ||
+         c == '/' || c == '%';
+}
+
+static inline bool PdfRegular(uint8_t c) { return !PdfWs(c) && !PdfDelim(c); }
+static inline bool IsDigit(uint8_t c) { return c >= '0' && c <= '9'; }
+
+static inline int HexVal(uint8_t c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+static bool Match(Bytes b, size_t i, const char* s) {
+  size_t k = std::strlen(s);
+  return i <= b.n && b.n - i >= k && std::memcmp(b.p + i, s, k) == 0;
+}
+
+// s at i, not followed by another regular byte
+static bool MatchKeyword(Bytes b, size_t i, const char* s) {
+  size_t k = std::strlen(s);
+  return Match(b, i, s) && (i + k == b.n || !PdfRegular(b.p[i + k]));
+}
+
+static size_t Find(Bytes b, size_t from, const char* s) {
+  size_t k = std::strlen(s);
+  while (from < b.n && b.n - from >= k) {
+    const void* hit = std::memchr(b.p + from, s[0], b.n - from - k + 1);
+    if (!hit) return kNpos;
+    size_t i = (size_t)((const uint8_t*)hit - b.p);
+    if (std::memcmp(b.p + i, s, k) == 0) return i;
+    from = i + 1;
+  }
+  return kNpos;
+}
+
+static size_t FindLast(Bytes b, const char* s) {
+  size_t k = std::strlen(s);
+  if (b.n < k) return kNpos;
+  for (size_t i = b.n - k + 1; i-- > 0;) {
+    if (b.p[i] == (uint8_t)s[0] && std::memcmp(b.p + i, s, k) == 0) return i;
+  }
+  return kNpos;
+}
+
+// whitespace and comments
+static void SkipWs(Bytes b, size_t* i) {
+  while (*i < b.n) {
+    uint8_t c = b.p[*i];
+    if (PdfWs(c)) {
+      (*i)++;
+    } else if (c == '%') {
+      while (*i < b.n && b.p[*i] != '\n' && b.p[*i] != '\r') (*i)++;
+    } else {
+      break;
+    }
+  }
+}
+
+static bool ReadUInt(Bytes b, size_t* i, uint64_t* out) {
+  SkipWs(b, i);
+  size_t s = *i;
+  uint64_t v = 0;
+  while (*i < b.n && IsDigit(b.p[*i])) {
+    if (v < (1ULL << 56)) v = v * 10 + (uint64_t)(b.p[*i] - '0');
+    (*i)++;
+  }
+  *out = v;
+  return *i > s;
+}
+
+// Literal string at *i ('('); decoded into out unless it is null.
+// Escapes follow pdfTextPreview.ts parseLiteralString; octal escapes keep the low byte.
+static void ReadLiteral(Bytes b, size_t* i, std::string* out) {
+  size_t k = *i + 1;
+  int depth = 1;
+  while (k < b.n && depth > 0) {
+    uint8_t ch = b.p[k++];
+    if (ch == '\\') {
+      if (k >= b.n) break;
+      uint8_t esc = b.p[k++];
+      if (!out) continue;
+      if (esc == 'n') out->push_back('\n');
+      else if (esc == 'r') out->push_back('\r');
+      else if (esc == 't') out->push_back('\t');
+      else if (esc == 'b') out->push_back('\b');
+      else if (esc == 'f') out->push_back('\f');
+      else if (esc == '\n') {
+        // line continuation
+      } else if (esc == '\r') {
+        if (k < b.n && b.p[k] == '\n') k++;
+      } else if (esc >= '0' && esc <= '7') {
+        unsigned v = esc - '0';
+        for (int j = 0; j < 2 && k < b.n && b.p[k] >= '0' && b.p[k] <= '7'; j++) v = v * 8 + (b.p[k++] - '0');
+        out->push_back((char)(v & 0xFF));
+      } else {
+        out->push_back((char)esc);
+      }
+      continue;
+    }
+    if (ch == '(') depth++;
+    else if (ch == ')' && --depth == 0) break;
+    if (out) out->push_back((char)ch);
+  }
+  *i = k;
+}
+
+// Hex string at *i ('<'); non-hex bytes are ignored, an odd digit count is padded with 0.
+static void ReadHex(Bytes b, size_t* i, std::string* out) {
+  size_t k = *i + 1;
+  int hi = -1;
+  while (k < b.n && b.p[k] != '>') {
+    int v = HexVal(b.p[k++]);
+    if (v < 0 || !out) continue;
+    if (hi < 0) {
+      hi = v;
+    } else {
+      out->push_back((char)(hi * 16 + v));
+      hi = -1;
+    }
+  }
+  if (out && hi >= 0) out->push_back((char)(hi * 16));
+  if (k < b.n) k++;
+  *i = k;
+}
+
+// ---- objects ----
+
+enum class Kind : uint8_t { Bad, Null, Bool, Int, Real, Name, String, Array, Dict, Ref, Keyword };
+
+struct Value {
+  Kind kind = Kind::Bad;
+  Bytes span;        // whole token; Name without the '/'
+  int64_t i = 0;     // Int, Bool, Ref object number
+  uint32_t gen = 0;  // Ref
+};
+
+static bool ParseValue(Bytes b, size_t* pos, Value* v, int depth);
+
+static bool ParseNumber(Bytes b, size_t* pos, Value* v) {
+  size_t s = *pos, j = s;
+  bool neg = false;
+  if (j < b.n && (b.p[j] == '+' || b.p[j] == '-')) neg = b.p[j++] == '-';
+  bool digits = false, dot = false;
+  int64_t iv = 0;
+  for (; j < b.n; j++) {
+    uint8_t c = b.p[j];
+    if (IsDigit(c)) {
+      digits = true;
+      if (!dot && iv < (1LL << 56)) iv = iv * 10 + (c - '0');
+    } else if (c == '.' && !dot) {
+      dot = true;
+    } else {
+      break;
+    }
+  }
+  if (!digits) return false;
+  v->kind = dot ? Kind::Real : Kind::Int;
+  v->i = neg ? -iv : iv;
+  v->span = Bytes{b.p + s, j - s};
+  *pos = j;
+  return true;
+}
+
+static bool ParseValue(Bytes b, size_t* pos, Value* v, int depth) {
+  if (depth > kMaxDepth) return false;
+  SkipWs(b, pos);
+  if (*pos >= b.n) return false;
+
+  size_t s = *pos;
+  uint8_t c = b.p[s];
+  *v = Value();
+
+  if (c == '<' && s + 1 < b.n && b.p[s + 1] == '<') {
+    *pos += 2;
+    for (;;) {
+      SkipWs(b, pos);
+      if (*pos >= b.n) return false;
+      if (Match(b, *pos, ">>")) {
+        *pos += 2;
+        break;
+      }
+      Value key, val;
+      if (!ParseValue(b, pos, &key, depth + 1) || !ParseValue(b, pos, &val, depth + 1)) return false;
+    }
+    v->kind = Kind::Dict;
+  } else if (c == '<') {
+    ReadHex(b, pos, nullptr);
+    v->kind = Kind::String;
+  } else if (c == '(') {
+    ReadLiteral(b, pos, nullptr);
+    v->kind = Kind::String;
+  } else if (c == '[') {
+    (*pos)++;
+    for (;;) {
+      SkipWs(b, pos);
+      if (*pos >= b.n) return false;
+      if (b.p[*pos] == ']') {
+        (*pos)++;
+        break;
+      }
+      Value item;
+      if (!ParseValue(b, pos, &item, depth + 1)) return false;
+    }
+    v->kind = Kind::Array;
+  } else if (c == '/') {
+    size_t j = s + 1;
+    while (j < b.n && PdfRegular(b.p[j])) j++;
+    v->kind = Kind::Name;
+    v->span = Bytes{b.p + s + 1, j - s - 1};
+    *pos = j;
+    return true;
+  } else if (IsDigit(c) || c == '+' || c == '-' || c == '.') {
+    if (!ParseNumber(b, pos, v)) return false;
+    if (v->kind == Kind::Int && v->i >= 0 && IsDigit(c)) {
+      // "num gen R"
+      size_t j = *pos;
+      uint64_t gen = 0;
+      if (j < b.n && PdfWs(b.p[j]) && ReadUInt(b, &j, &gen)) {
+        SkipWs(b, &j);
+        if (MatchKeyword(b, j, "R")) {
+          v->kind = Kind::Ref;
+          v->gen = (uint32_t)gen;
+          *pos = j + 1;
+        }
+      }
+    }
+  } else if (PdfRegular(c)) {
+    size_t j = s;
+    while (j < b.n && PdfRegular(b.p[j])) j++;
+    *pos = j;
+    Bytes w{b.p + s, j - s};
+    if (w.n == 4 && std::memcmp(w.p, "true", 4) == 0) {
+      v->kind = Kind::Bool;
+      v->i = 1;
+    } else if (w.n == 5 && std::memcmp(w.p, "false", 5) == 0) {
+      v->kind = Kind::Bool;
+    } else if (w.n == 4 && std::memcmp(w.p, "null", 4) == 0) {
+      v->kind = Kind::Null;
+    } else {
+      v->kind = Kind::Keyword;
+    }
+  } else {
+    return false;
+  }
+
+  v->span = Bytes{b.p + s, *pos - s};
+  return true;
+}
+
+static bool DictGet(const Value& dict, const char* key, Value* out) {
+  if (dict.kind != Kind::Dict) return false;
+  Bytes b = dict.span;
+  size_t klen = std::strlen(key);
+  size_t i = 2;
+  for (;;) {
+    SkipWs(b, &i);
+    if (i >= b.n || Match(b, i, ">>")) return false;
+    Value k, val;
+    if (!ParseValue(b, &i, &k, 1) || !ParseValue(b, &i, &val, 1)) return false;
+    if (k.kind == Kind::Name && k.span.n == klen && std::memcmp(k.span.p, key, klen) == 0) {
+      *out = val;
+      return true;
+    }
+  }
+}
+
+static void ArrayItems(const Value& arr, std::vector<Value>* out) {
+  out->clear();
+  if (arr.kind != Kind::Array) return;
+  Bytes b = arr.span;
+  size_t i = 1;
+  for (;;) {
+    SkipWs(b, &i);
+    if (i >= b.n || b.p[i] == ']') return;
+    Value item;
+    if (!ParseValue(b, &i, &item, 1)) return;
+    out->push_back(item);
+  }
+}
+
+static bool NameIs(const Value& v, const char* name) {
+  size_t k = std::strlen(name);
+  return v.kind == Kind::Name && v.span.n == k && std::memcmp(v.span.p, name, k) == 0;
+}
+
+static std::string Label(uint64_t num, uint32_t gen) { return std::to_string(num) + " " + std::to_string(gen); }
+
+// ---- stream filters ----
+
+struct StreamFilter {
+  std::string name;
+  int64_t predictor = 1;
+  int64_t colors = 1;
+  int64_t bpc = 8;
+  int64_t columns = 1;
+};
+
+// Inflated bytes one document may still produce, shared by its worker threads.
+struct DecodeBudget {
+  std::atomic<uint64_t> left{kMaxDocBytes};
+  std::atomic<bool> reported{false};
+
+  size_t Take(size_t n) {
+    uint64_t have = left.load();
+    while (have > 0) {
+      const uint64_t take = std::min<uint64_t>(have, n);
+      if (left.compare_exchange_weak(have, have - take)) return (size_t)take;
+    }
+    return 0;
+  }
+  void Give(size_t n) { left.fetch_add(n); }
+};
+
+// 1 = complete, 0 = truncated, corrupt or capped after some output (kept),
+// -1 = nothing usable. Output stops at kMaxStreamBytes or when budget runs out.
+static int Inflate(Bytes in, std::vector<uint8_t>* out, DecodeBudget* budget, std::string* err) {
+  std::string firstErr;
+  for (int attempt = 0; attempt < 2; attempt++) {
+    // zlib/gzip header first; some writers emit raw deflate
+    z_stream zs;
+    std::memset(&zs, 0, sizeof zs);
+    if (inflateInit2(&zs, attempt == 0 ? 15 + 32 : -15) != Z_OK) {
+      *err = "inflateInit failed";
+      return -1;
+    }
+
+    out->clear();
+    out->reserve(std::min<size_t>(in.n * 4 + kInflateChunk, kMaxStreamBytes));
+    size_t fed = 0;
+    int rc = Z_OK;
+    std::string capped;
+    for (;;) {
+      if (zs.avail_in == 0 && fed < in.n) {
+        size_t take = std::min<size_t>(in.n - fed, 1u << 30);
+        zs.next_in = const_cast<Bytef*>(in.p + fed);
+        zs.avail_in = (uInt)take;
+        fed += take;
+      }
+      size_t have = out->size();
+      size_t room = budget->Take(std::min(kInflateChunk, kMaxStreamBytes - have));
+      if (room == 0) {
+        capped = budget->left.load() == 0
+                   ? "document output capped at " + std::to_string(kMaxDocBytes) + " bytes; later streams are skipped"
+                   : "output capped at " + std::to_string(kMaxStreamBytes) + " bytes";
+        break;
+      }
+      out->resize(have + room);
+      zs.next_out = out->data() + have;
+      zs.avail_out = (uInt)room;
+      rc = inflate(&zs, Z_NO_FLUSH);
+      budget->Give(zs.avail_out);
+      out->resize(have + (room - zs.avail_out));
+      if (rc == Z_OK) continue;
+      if (rc == Z_BUF_ERROR && (zs.avail_in > 0 || fed < in.n)) continue;
+      break;
+    }
+    std::string msg = zs.msg ? zs.msg : "";
+    inflateEnd(&zs);
+
+    if (!capped.empty()) {
+      *err = capped;
+      return out->empty() ? -1 : 0;
+    }
+    if (rc == Z_STREAM_END) return 1;
+    if (rc == Z_BUF_ERROR) msg = "unexpected end of file";
+    if (msg.empty()) msg = "zlib error " + std::to_string(rc);
+    if (attempt == 0 && out->empty()) {
+      firstErr = msg;
+      continue;
+    }
+    *err = out->empty() ? firstErr : msg;
+    return out->empty() ? -1 : 0;
+  }
+  *err = firstErr;
+  return -1;
+}
+
+static bool Unpredict(const StreamFilter& f, std::vector<uint8_t>* data) {
+  if (f.predictor <= 1) return true;
+  if (f.colors < 1 || f.bpc < 1 || f.columns < 1 || f.colors * f.bpc * f.columns > (1LL << 31)) return false;
+
+  const size_t bpp = (size_t)std::max<int64_t>(1, (f.colors * f.bpc + 7) / 8);
+  const size_t rowLen = (size_t)((f.colors * f.bpc * f.columns + 7) / 8);
+
+  if (f.predictor == 2) {
+    if (f.bpc != 8) return false;
+    for (size_t r = 0; r + rowLen <= data->size(); r += rowLen) {
+      uint8_t* row = data->data() + r;
+      for (size_t k = bpp; k < rowLen; k++) row[k] = (uint8_t)(row[k] + row[k - bpp]);
+    }
+    return true;
+  }
+  if (f.predictor < 10) return false;
+
+  // PNG: every row carries its own filter type byte
+  const size_t stride = rowLen + 1;
+  const size_t rows = data->size() / stride;
+  std::vector<uint8_t> out(rows * rowLen);
+  std::vector<uint8_t> zero(rowLen, 0);
+  for (size_t r = 0; r < rows; r++) {
+    const uint8_t* in = data->data() + r * stride;
+    uint8_t* cur = out.data() + r * rowLen;
+    const uint8_t* up = r ? cur - rowLen : zero.data();
+    const uint8_t type = in[0];
+    std::memcpy(cur, in + 1, rowLen);
+    for (size_t k = 0; k < rowLen; k++) {
+      int a = k >= bpp ? cur[k - bpp] : 0;
+      int b = up[k];
+      int c = k >= bpp ? up[k - bpp] : 0;
+      int add = 0;
+      if (type == 1) add = a;
+      else if (type == 2) add = b;
+      else if (type == 3) add = (a + b) / 2;
+      else if (type == 4) {
+        int p = a + b - c, pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+        add = (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+      }
+      cur[k] = (uint8_t)(cur[k] + add);
+    }
+  }
+  data->swap(out);
+  return true;
+}
+
+static void DecodeAsciiHex(Bytes in, std::vector<uint8_t>* out) {
+  int hi = -1;
+  for (size_t i = 0; i < in.n && in.p[i] != '>'; i++) {
+    int v = HexVal(in.p[i]);
+    if (v < 0) continue;
+    if (hi < 0) {
+      hi = v;
+    } else {
+      out->push_back((uint8_t)(hi * 16 + v));
+      hi = -1;
+    }
+  }
+  if (hi >= 0) out->push_back((uint8_t)(hi * 16));
+}
+
+static void DecodeAscii85(Bytes in, std::vector<uint8_t>* out) {
+  size_t i = 0;
+  while (i < in.n && PdfWs(in.p[i])) i++;
+  if (Match(in, i, "<~")) i += 2;
+
+  uint32_t group[5];
+  int n = 0;
+  auto emit = [&](int count) {
+    uint32_t value = 0;
+    for (int k = 0; k < 5; k++) value = value * 85 + group[k];
+    for (int k = 0; k < count; k++) out->push_back((uint8_t)(value >> (24 - 8 * k)));
+  };
+
+  for (; i < in.n && in.p[i] != '~'; i++) {
+    uint8_t c = in.p[i];
+    if (c == 'z' && n == 0) {
+      out->insert(out->end(), 4, 0);
+      continue;
+    }
+    if (c < 33 || c > 117) continue;
+    group[n++] = c - 33;
+    if (n == 5) {
+      emit(4);
+      n = 0;
+    }
+  }
+  if (n > 0) {
+    int kept = n;
+    while (n < 5) group[n++] = 84;
+    emit(kept - 1);
+  }
+}
+
+// Runs the filter chain. *out views either raw (no filters) or *buf.
+static bool DecodeStream(Bytes raw, const std::vector<StreamFilter>& filters, const std::string& label,
+                         std::vector<uint8_t>* buf, Bytes* out, DecodeBudget* budget,
+                         std::vector<std::string>* warnings) {
+  Bytes cur = raw;
+  std::vector<uint8_t> tmp;
+  for (const StreamFilter& f : filters) {
+    tmp.clear();
+    if (f.name == "FlateDecode") {
+      std::string err;
+      int rc = Inflate(cur, &tmp, budget, &err);
+      // once the document budget is spent, every later stream would fail the same way
+      const bool quiet = rc <= 0 && budget->left.load() == 0 && budget->reported.exchange(true);
+      if (rc < 0) {
+        if (!quiet) warnings->push_back("FlateDecode failed on object " + label + ": " + err);
+        return false;
+      }
+      if (rc == 0 && !quiet) warnings->push_back("FlateDecode truncated on object " + label + ": " + err);
+      if (!Unpredict(f, &tmp)) {
+        warnings->push_back("Unsupported /Predictor " + std::to_string(f.predictor) + " on object " + label + ".");
+        return false;
+      }
+    } else if (f.name == "ASCIIHexDecode") {
+      DecodeAsciiHex(cur, &tmp);
+    } else if (f.name == "ASCII85Decode") {
+      DecodeAscii85(cur, &tmp);
+    } else {
+      warnings->push_back("Unsupported stream filter /" + f.name + " on object " + label + ".");
+      return false;
+    }
+    buf->swap(tmp);
+    cur = Bytes{buf->data(), buf->size()};
+  }
+  *out = cur;
+  return true;
+}
+
+// ---- document ----
+
+struct XrefEntry {
+  uint8_t type = 0;  // 0 unset, 1 at a file offset, 2 inside an object stream
+  uint64_t a = 0;    // offset, or object stream number
+  uint32_t b = 0;    // index within the object stream
+};
+
+struct PdfObject {
+  uint64_t num = 0;
+  uint32_t gen = 0;
+  Value value;
+  bool hasStream = false;
+  Bytes stream;  // still filtered
+};
+
+struct ObjStm {
+  bool ok = false;
+  Bytes data;  // decoded body past /First
+  std::vector<std::pair<uint64_t, size_t>> entries;  // (object number, offset into data), header order
+};
+
+class PdfDoc {
+public:
+  PdfDoc(Bytes file, std::vector<std::string>* warnings)
+    : file_(file), warnings_(warnings), denseLimit_(std::min<uint64_t>(kMaxObjects, file.n / 4 + 1024)) {}
+
+  // False when no object could be located at all.
+  bool Open() {
+    uint64_t start = 0;
+    if (FindStartXref(&start) && ReadXrefChain(start) && !Numbers().empty()) {
+      // lookups made while the index was incomplete may have cached misses
+      cache_.clear();
+      objstms_.clear();
+      return true;
+    }
+
+    // No usable xref: index every object header, then the object streams they hold
+    index_.clear();
+    sparse_.clear();
+    cache_.clear();
+    objstms_.clear();
+    trailer_ = Value();
+    scanMode_ = true;
+    EnsureScan();
+    for (const auto& kv : scan_) SetEntry(kv.first, 1, kv.second, 0);
+    for (uint64_t num : Numbers()) {
+      const PdfObject* o = Get(num);
+      Value type;
+      if (!o || !DictGet(o->value, "Type", &type) || !NameIs(type, "ObjStm")) continue;
+      const ObjStm* s = GetObjStm(num);
+      if (!s) continue;
+      for (size_t k = 0; k < s->entries.size(); k++) SetEntry(s->entries[k].first, 2, num, (uint32_t)k);
+    }
+    return !Numbers().empty();
+  }
+
+  DecodeBudget* Budget() { return &budget_; }
+
+  bool Encrypted() const {
+    Value v;
+    return DictGet(trailer_, "Encrypt", &v) && v.kind != Kind::Null;
+  }
+
+  std::vector<uint64_t> Numbers() const {
+    std::vector<uint64_t> out;
+    for (size_t i = 0; i < index_.size(); i++) {
+      if (index_[i].type) out.push_back(i);
+    }
+    const size_t dense = out.size();
+    for (const auto& kv : sparse_) out.push_back(kv.first);
+    std::sort(out.begin() + dense, out.end());
+    return out;
+  }
+
+  const PdfObject* Get(uint64_t num) {
+    auto it = cache_.find(num);
+    if (it != cache_.end()) return it->second.get();
+    if (!loading_.insert(num).second) return nullptr;  // reference cycle
+
+    std::unique_ptr<PdfObject> obj(new PdfObject());
+    bool ok = false;
+    const XrefEntry e = Entry(num);
+    if (e.type == 1) {
+      ok = ParseIndirect(e.a, num, obj.get());
+    } else if (e.type == 2) {
+      ok = LoadCompressed(e.a, e.b, num, obj.get());
+    }
+    if (!ok && !scanMode_) {
+      // stale or shifted xref offsets
+      EnsureScan();
+      auto s = scan_.find(num);
+      if (s != scan_.end()) ok = ParseIndirect(s->second, num, obj.get());
+    }
+    loading_.erase(num);
+
+    PdfObject* raw = ok ? obj.get() : nullptr;
+    cache_[num] = ok ? std::move(obj) : nullptr;
+    return raw;
+  }
+
+  bool Resolve(const Value& v, Value* out) {
+    Value cur = v;
+    for (int k = 0; cur.kind == Kind::Ref && k < kMaxDepth; k++) {
+      const PdfObject* o = Get((uint64_t)cur.i);
+      if (!o) return false;
+      cur = o->value;
+    }
+    *out = cur;
+    return cur.kind != Kind::Ref;
+  }
+
+  bool DictInt(const Value& dict, const char* key, int64_t* out) {
+    Value v;
+    if (!DictGet(dict, key, &v) || !Resolve(v, &v) || v.kind != Kind::Int) return false;
+    *out = v.i;
+    return true;
+  }
+
+  void Filters(const PdfObject& o, std::vector<StreamFilter>* out) {
+    out->clear();
+    Value f, parms;
+    if (!DictGet(o.value, "Filter", &f) || !Resolve(f, &f)) return;
+    bool hasParms = (DictGet(o.value, "DecodeParms", &parms) || DictGet(o.value, "DP", &parms)) && Resolve(parms, &parms);
+
+    std::vector<Value> names, params;
+    if (f.kind == Kind::Array) {
+      ArrayItems(f, &names);
+      if (hasParms) ArrayItems(parms, &params);
+    } else {
+      names.push_back(f);
+      if (hasParms) params.push_back(parms);
+    }
+
+    for (size_t k = 0; k < names.size(); k++) {
+      Value name;
+      if (!Resolve(names[k], &name) || name.kind != Kind::Name) continue;
+      StreamFilter sf;
+      sf.name.assign((const char*)name.span.p, name.span.n);
+      if (sf.name == "Fl") sf.name = "FlateDecode";
+      else if (sf.name == "AHx") sf.name = "ASCIIHexDecode";
+      else if (sf.name == "A85") sf.name = "ASCII85Decode";
+
+      Value p;
+      if (k < params.size() && Resolve(params[k], &p) && p.kind == Kind::Dict) {
+        DictInt(p, "Predictor", &sf.predictor);
+        DictInt(p, "Colors", &sf.colors);
+        DictInt(p, "BitsPerComponent", &sf.bpc);
+        DictInt(p, "Columns", &sf.columns);
+      }
+      out->push_back(std::move(sf));
+    }
+  }
+
+  // Page objects in page-tree order; every /Type /Page object by number when
+  // the tree is missing or empty.
+  std::vector<const PdfObject*> Pages() {
+    std::vector<const PdfObject*> pages;
+
+    Value catalog;
+    bool haveCatalog = false;
+    Value root;
+    if (DictGet(trailer_, "Root", &root) && Resolve(root, &catalog) && catalog.kind == Kind::Dict) {
+      haveCatalog = true;
+    } else {
+      for (uint64_t num : Numbers()) {
+        const PdfObject* o = Get(num);
+        Value type;
+        if (o && DictGet(o->value, "Type", &type) && NameIs(type, "Catalog")) {
+          catalog = o->value;
+          haveCatalog = true;
+          break;
+        }
+      }
+    }
+
+    Value tree;
+    if (haveCatalog && DictGet(catalog, "Pages", &tree)) {
+      std::unordered_set<uint64_t> seen;
+      CollectPages(tree, &pages, &seen, 0);
+    }
+    if (!pages.empty()) return pages;
+
+    for (uint64_t num : Numbers()) {
+      const PdfObject* o = Get(num);
+      Value type;
+      if (o && DictGet(o->value, "Type", &type) && NameIs(type, "Page")) pages.push_back(o);
+    }
+    return pages;
+  }
+
+  // Content stream objects of a page, in /Contents order.
+  std::vector<const PdfObject*> Contents(const PdfObject& page, std::vector<std::string>* warnings) {
+    std::vector<const PdfObject*> out;
+    Value c;
+    if (!DictGet(page.value, "Contents", &c)) {
+      if (page.hasStream) out.push_back(&page);
+      return out;
+    }
+
+    std::vector<Value> refs;
+    if (c.kind == Kind::Ref) {
+      const PdfObject* o = Get((uint64_t)c.i);
+      if (o && !o->hasStream && o->value.kind == Kind::Array) ArrayItems(o->value, &refs);  // indirect array
+      else refs.push_back(c);
+    } else {
+      ArrayItems(c, &refs);
+    }
+
+    for (const Value& r : refs) {
+      if (r.kind != Kind::Ref) continue;
+      const PdfObject* o = Get((uint64_t)r.i);
+      if (!o || !o->hasStream) {
+        warnings->push_back("Missing contents object " + Label((uint64_t)r.i, r.gen) + " for page " +
+                            std::to_string(page.num) + ".");
+        continue;
+      }
+      out.push_back(o);
+    }
+    return out;
+  }
+
+private:
+  Bytes file_;
+  std::vector<std::string>* warnings_;
+  Value trailer_;
+  // Object numbers below denseLimit_ (which scales with the file size) index
+  // index_; the rare larger ones go to sparse_, which holds at most as many.
+  // A single bogus xref row can then no longer allocate a huge table.
+  uint64_t denseLimit_;
+  std::vector<XrefEntry> index_;
+  std::unordered_map<uint64_t, XrefEntry> sparse_;
+  bool scanMode_ = false;
+  bool scanned_ = false;
+  std::unordered_map<uint64_t, uint64_t> scan_;  // object number -> header offset, last one wins
+  std::unordered_map<uint64_t, std::unique_ptr<PdfObject>> cache_;
+  std::unordered_set<uint64_t> loading_;
+  std::unordered_map<uint64_t, ObjStm> objstms_;
+  std::vector<std::unique_ptr<std::vector<uint8_t>>> owned_;  // decoded object streams
+  DecodeBudget budget_;
+
+  // Newer sections are read first, so the first entry set for a number wins.
+  void SetEntry(uint64_t num, uint8_t type, uint64_t a, uint32_t b) {
+    if (num >= kMaxObjects) return;
+    XrefEntry* slot;
+    if (num < denseLimit_) {
+      if (num >= index_.size()) index_.resize((size_t)num + 1);
+      slot = &index_[(size_t)num];
+    } else {
+      auto it = sparse_.find(num);
+      if (it == sparse_.end()) {
+        if (sparse_.size() >= denseLimit_) return;
+        it = sparse_.emplace(num, XrefEntry()).first;
+      }
+      slot = &it->second;
+    }
+    XrefEntry& e = *slot;
+    if (e.type) return;
+    e.type = type;
+    e.a = a;
+    e.b = b;
+  }
+
+  XrefEntry Entry(uint64_t num) const {
+    if (num < index_.size()) return index_[(size_t)num];
+    auto it = sparse_.find(num);
+    return it != sparse_.end() ? it->second : XrefEntry();
+  }
+
+  bool FindStartXref(uint64_t* start) {
+    size_t at = FindLast(file_, "startxref");
+    if (at == kNpos) return false;
+    size_t i = at + 9;
+    return ReadUInt(file_, &i, start) && *start < file_.n;
+  }
+
+  bool ReadXrefChain(uint64_t off) {
+    std::unordered_set<uint64_t> seen;
+    bool first = true;
+    while (seen.insert(off).second && seen.size() <= (size_t)kMaxDepth) {
+      Value trailer;
+      if (!ReadXrefSection(off, &trailer)) {
+        if (first) return false;
+        warnings_->push_back("Broken /Prev xref section at offset " + std::to_string(off) + "; ignoring older sections.");
+        break;
+      }
+      if (first) trailer_ = trailer;
+      first = false;
+
+      int64_t v = 0;
+      Value ignored;
+      if (DictInt(trailer, "XRefStm", &v) && v >= 0) ReadXrefSection((uint64_t)v, &ignored);
+      if (!DictInt(trailer, "Prev", &v) || v < 0) break;
+      off = (uint64_t)v;
+    }
+    return true;
+  }
+
+  bool ReadXrefSection(uint64_t off, Value* trailer) {
+    if (off >= file_.n) return false;
+    size_t i = (size_t)off;
+    SkipWs(file_, &i);
+
+    if (MatchKeyword(file_, i, "xref")) {
+      i += 4;
+      for (;;) {
+        SkipWs(file_, &i);
+        if (MatchKeyword(file_, i, "trailer")) {
+          i += 7;
+          return ParseValue(file_, &i, trailer, 0) && trailer->kind == Kind::Dict;
+        }
+        uint64_t first = 0, count = 0;
+        if (!ReadUInt(file_, &i, &first) || !ReadUInt(file_, &i, &count)) return false;
+        if (first + count > kMaxObjects) return false;
+        for (uint64_t k = 0; k < count; k++) {
+          uint64_t ofs = 0, gen = 0;
+          if (!ReadUInt(file_, &i, &ofs) || !ReadUInt(file_, &i, &gen)) return false;
+          SkipWs(file_, &i);
+          if (i >= file_.n) return false;
+          // free entries are skipped: hybrid files list compressed objects as free here
+          if (file_.p[i++] == 'n') SetEntry(first + k, 1, ofs, 0);
+        }
+      }
+    }
+
+    // xref stream
+    PdfObject x;
+    if (!ParseIndirect(off, UINT64_MAX, &x) || !x.hasStream) return false;
+    Value w;
+    std::vector<Value> ws;
+    if (!DictGet(x.value, "W", &w) || !Resolve(w, &w)) return false;
+    ArrayItems(w, &ws);
+    if (ws.size() < 3) return false;
+    size_t width[3];
+    for (int k = 0; k < 3; k++) {
+      if (ws[k].kind != Kind::Int || ws[k].i < 0 || ws[k].i > 8) return false;
+      width[k] = (size_t)ws[k].i;
+    }
+    const size_t rowLen = width[0] + width[1] + width[2];
+    if (!rowLen) return false;
+
+    std::vector<StreamFilter> filters;
+    Filters(x, &filters);
+    std::vector<uint8_t> buf;
+    Bytes data;
+    if (!DecodeStream(x.stream, filters, Label(x.num, x.gen), &buf, &data, &budget_, warnings_)) return false;
+
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+    Value index;
+    std::vector<Value> idx;
+    if (DictGet(x.value, "Index", &index) && Resolve(index, &index)) ArrayItems(index, &idx);
+    for (size_t k = 0; k + 1 < idx.size(); k += 2) {
+      if (idx[k].kind == Kind::Int && idx[k + 1].kind == Kind::Int && idx[k].i >= 0 && idx[k + 1].i >= 0) {
+        ranges.emplace_back((uint64_t)idx[k].i, (uint64_t)idx[k + 1].i);
+      }
+    }
+    if (ranges.empty()) {
+      int64_t size = 0;
+      if (!DictInt(x.value, "Size", &size) || size < 0) return false;
+      ranges.emplace_back(0, (uint64_t)size);
+    }
+
+    auto field = [&](const uint8_t* p, size_t n, uint64_t dflt) {
+      if (!n) return dflt;
+      uint64_t v = 0;
+      for (size_t k = 0; k < n; k++) v = (v << 8) | p[k];
+      return v;
+    };
+
+    size_t row = 0;
+    for (const auto& r : ranges) {
+      if (r.first + r.second > kMaxObjects) return false;
+      for (uint64_t k = 0; k < r.second; k++, row++) {
+        if ((row + 1) * rowLen > data.n) break;
+        const uint8_t* p = data.p + row * rowLen;
+        uint64_t type = field(p, width[0], 1);
+        uint64_t a = field(p + width[0], width[1], 0);
+        uint64_t b = field(p + width[0] + width[1], width[2], 0);
+        if (type == 1 || type == 2) SetEntry(r.first + k, (uint8_t)type, a, (uint32_t)b);
+      }
+    }
+
+    *trailer = x.value;
+    return true;
+  }
+
+  // "num gen obj <value> [stream ... endstream]" at off; expect = UINT64_MAX accepts any number.
+  bool ParseIndirect(uint64_t off, uint64_t expect, PdfObject* obj) {
+    if (off >= file_.n) return false;
+    size_t i = (size_t)off;
+    uint64_t num = 0, gen = 0;
+    if (!ReadUInt(file_, &i, &num) || !ReadUInt(file_, &i, &gen)) return false;
+    SkipWs(file_, &i);
+    if (!MatchKeyword(file_, i, "obj")) return false;
+    if (expect != UINT64_MAX && num != expect) return false;
+    i += 3;
+
+    obj->num = num;
+    obj->gen = (uint32_t)gen;
+    if (!ParseValue(file_, &i, &obj->value, 0)) return false;
+    if (obj->value.kind != Kind::Dict) return true;
+
+    SkipWs(file_, &i);
+    if (!MatchKeyword(file_, i, "stream")) return true;
+    i += 6;
+    if (Match(file_, i, "\r\n")) i += 2;
+    else if (i < file_.n && (file_.p[i] == '\n' || file_.p[i] == '\r')) i++;
+    const size_t start = i;
+
+    int64_t len = -1;
+    if (DictInt(obj->value, "Length", &len) && len >= 0 && (uint64_t)len <= file_.n - start) {
+      size_t j = start + (size_t)len;
+      SkipWs(file_, &j);
+      if (Match(file_, j, "endstream")) {
+        obj->hasStream = true;
+        obj->stream = Bytes{file_.p + start, (size_t)len};
+        return true;
+      }
+    }
+
+    // missing or wrong /Length: up to "endstream", minus the EOL before it
+    size_t end = Find(file_, start, "endstream");
+    if (end == kNpos) return true;
+    while (end > start && (file_.p[end - 1] == '\n' || file_.p[end - 1] == '\r')) end--;
+    obj->hasStream = true;
+    obj->stream = Bytes{file_.p + start, end - start};
+    return true;
+  }
+
+  bool LoadCompressed(uint64_t stm, uint32_t index, uint64_t num, PdfObject* obj) {
+    const ObjStm* s = GetObjStm(stm);
+    if (!s) return false;
+
+    size_t k = index;
+    if (k >= s->entries.size() || s->entries[k].first != num) {
+      for (k = 0; k < s->entries.size() && s->entries[k].first != num; k++) {
+      }
+      if (k == s->entries.size()) return false;
+    }
+
+    size_t pos = s->entries[k].second;
+    if (pos >= s->data.n) return false;
+    obj->num = num;
+    obj->gen = 0;
+    return ParseValue(s->data, &pos, &obj->value, 0);
+  }
+
+  const ObjStm* GetObjStm(uint64_t stm) {
+    auto it = objstms_.find(stm);
+    if (it != objstms_.end()) return it->second.ok ? &it->second : nullptr;
+    ObjStm& s = objstms_[stm];  // inserted first: also breaks cycles through Get()
+
+    const PdfObject* o = Get(stm);
+    if (!o || !o->hasStream) return nullptr;
+    const std::string label = Label(o->num, o->gen);
+
+    int64_t n = 0, first = 0;
+    if (!DictInt(o->value, "N", &n) || !DictInt(o->value, "First", &first)) {
+      warnings_->push_back("ObjStm " + label + " missing /N or /First.");
+      return nullptr;
+    }
+
+    std::vector<StreamFilter> filters;
+    Filters(*o, &filters);
+    std::unique_ptr<std::vector<uint8_t>> buf(new std::vector<uint8_t>());
+    Bytes data;
+    if (!DecodeStream(o->stream, filters, label, buf.get(), &data, &budget_, warnings_)) return nullptr;
+
+    if (n <= 0 || first < 0 || (uint64_t)first > data.n) {
+      warnings_->push_back("ObjStm " + label + " has invalid /N or /First values.");
+      return nullptr;
+    }
+
+    Bytes header{data.p, (size_t)first};
+    size_t i = 0;
+    for (int64_t k = 0; k < n; k++) {
+      uint64_t objNum = 0, ofs = 0;
+      if (!ReadUInt(header, &i, &objNum) || !ReadUInt(header, &i, &ofs)) break;
+      s.entries.emplace_back(objNum, (size_t)ofs);
+    }
+    if ((int64_t)s.entries.size() < n) {
+      warnings_->push_back("ObjStm " + label + " header shorter than /N (" + std::to_string(s.entries.size()) + "/" +
+                           std::to_string(n) + "); using available entries.");
+    }
+    if (s.entries.empty()) return nullptr;
+
+    s.data = Bytes{data.p + first, data.n - (size_t)first};
+    if (data.p == buf->data()) owned_.push_back(std::move(buf));
+    s.ok = true;
+    return &s;
+  }
+
+  void EnsureScan() {
+    if (scanned_) return;
+    scanned_ = true;
+
+    const uint8_t* p = file_.p;
+    for (size_t at = 0; (at = Find(file_, at, "obj")) != kNpos; at += 3) {
+      if (at + 3 < file_.n && PdfRegular(p[at + 3])) continue;
+      // walk back over "num ws+ gen ws+"
+      size_t j = at;
+      if (!j || !PdfWs(p[j - 1])) continue;
+      while (j && PdfWs(p[j - 1])) j--;
+      size_t genEnd = j;
+      while (j && IsDigit(p[j - 1])) j--;
+      if (j == genEnd || !j || !PdfWs(p[j - 1])) continue;
+      while (j && PdfWs(p[j - 1])) j--;
+      size_t numEnd = j;
+      while (j && IsDigit(p[j - 1])) j--;
+      if (j == numEnd || numEnd - j > 9) continue;
+
+      uint64_t num = 0;
+      for (size_t k = j; k < numEnd; k++) num = num * 10 + (p[k] - '0');
+      scan_[num] = j;
+    }
+  }
+
+  void CollectPages(const Value& node, std::vector<const PdfObject*>* out, std::unordered_set<uint64_t>* seen,
+                    int depth) {
+    if (depth > kMaxDepth || node.kind != Kind::Ref) return;
+    if (!seen->insert((uint64_t)node.i).second) return;
+
+    const PdfObject* o = Get((uint64_t)node.i);
+    if (!o) {
+      warnings_->push_back("Missing object " + Label((uint64_t)node.i, node.gen) + " while traversing page tree.");
+      return;
+    }
+
+    Value type, kids;
+    bool typed = DictGet(o->value, "Type", &type) && Resolve(type, &type);
+    if (typed && NameIs(type, "Page")) {
+      out->push_back(o);
+      return;
+    }
+    if (DictGet(o->value, "Kids", &kids) && Resolve(kids, &kids)) {
+      std::vector<Value> items;
+      ArrayItems(kids, &items);
+      for (const Value& kid : items) CollectPages(kid, out, seen, depth + 1);
+      return;
+    }
+    Value contents;
+    if (!typed && DictGet(o->value, "Contents", &contents)) out->push_back(o);  // untyped leaf
+  }
+};
+
+// ---- content streams -> text (pdfTextPreview.ts parseTextSegment / extractTextFromContent) ----
+
+static inline bool TextWs(uint8_t c) {
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f' || c == '\v';
+}
+
+static inline bool TextDelim(uint8_t c) {
+  return TextWs(c) || c == '[' || c == ']' || c == '(' || c == ')' || c == '<' || c == '>' || c == '{' ||
+         c == '}' || c == '/' || c == '%';
+}
+
+// [+-]?(\d+\.?\d*|\.\d+), parsed without the C locale's help
+static bool ParseNumberToken(Bytes t, double* out) {
+  size_t i = 0;
+  bool neg = false;
+  if (i < t.n && (t.p[i] == '+' || t.p[i] == '-')) neg = t.p[i++] == '-';
+  double v = 0, scale = 1;
+  size_t intDigits = 0, fracDigits = 0;
+  while (i < t.n && IsDigit(t.p[i])) {
+    v = v * 10 + (t.p[i++] - '0');
+    intDigits++;
+  }
+  if (i < t.n && t.p[i] == '.') {
+    i++;
+    while (i < t.n && IsDigit(t.p[i])) {
+      scale /= 10;
+      v += (t.p[i++] - '0') * scale;
+      fracDigits++;
+    }
+  }
+  if (i != t.n || (!intDigits && !fracDigits)) return false;
+  *out = neg ? -v : v;
+  return true;
+}
+
+static bool TokenIs(Bytes t, const char* s) {
+  size_t k = std::strlen(s);
+  return t.n == k && std::memcmp(t.p, s, k) == 0;
+}
+
+static inline bool JsTrimByte(uint8_t c) { return (c >= 0x09 && c <= 0x0D) || c == 0x20 || c == 0xA0; }
+
+static void TrimJs(std::string* s) {
+  size_t a = 0, b = s->size();
+  while (a < b && JsTrimByte((uint8_t)(*s)[a])) a++;
+  while (b > a && JsTrimByte((uint8_t)(*s)[b - 1])) b--;
+  *s = s->substr(a, b - a);
+}
+
+// \n{3,} -> \n\n
+static void CollapseNewlines(std::string* s) {
+  std::string out;
+  out.reserve(s->size());
+  size_t run = 0;
+  for (char c : *s) {
+    run = c == '\n' ? run + 1 : 0;
+    if (run <= 2) out.push_back(c);
+  }
+  s->swap(out);
+}
+
+static void NormalizeSegment(std::string* s) {
+  // [ \t]+\n -> \n
+  std::string out;
+  out.reserve(s->size());
+  for (size_t i = 0; i < s->size();) {
+    char c = (*s)[i];
+    if (c == ' ' || c == '\t') {
+      size_t j = i;
+      while (j < s->size() && ((*s)[j] == ' ' || (*s)[j] == '\t')) j++;
+      if (j == s->size() || (*s)[j] != '\n') out.append(*s, i, j - i);
+      i = j;
+      continue;
+    }
+    out.push_back(c);
+    i++;
+  }
+  CollapseNewlines(&out);
+  out.erase(std::remove(out.begin(), out.end(), '\0'), out.end());
+  TrimJs(&out);
+  s->swap(out);
+}
+
+struct TextOperands {
+  bool hasStr = false;
+  std::string str;  // last string operand
+  bool hasArr = false;
+  std::string arr;  // last array operand, its strings joined
+  int nums = 0;
+  double lastNum = 0;
+
+  void Clear() {
+    hasStr = hasArr = false;
+    str.clear();
+    arr.clear();
+    nums = 0;
+  }
+};
+
+static std::string PageText(Bytes c) {
+  std::string text, seg;
+  TextOperands ops;
+  bool sawBT = false, inBT = false;
+
+  auto flush = [&]() {
+    NormalizeSegment(&seg);
+    if (!seg.empty()) {
+      if (!text.empty()) text += "\n\n";
+      text += seg;
+    }
+    seg.clear();
+    ops.Clear();
+  };
+  auto newline = [&]() {
+    if (!seg.empty() && seg.back() != '\n') seg.push_back('\n');
+  };
+
+  size_t i = 0;
+  while (i < c.n) {
+    const uint8_t ch = c.p[i];
+    // text outside BT/ET only counts when the stream has no BT at all
+    const bool active = inBT || !sawBT;
+
+    if (TextWs(ch)) {
+      i++;
+      continue;
+    }
+    if (ch == '%') {
+      while (i < c.n && c.p[i] != '\n' && c.p[i] != '\r') i++;
+      continue;
+    }
+    if (ch == '(') {
+      if (active) {
+        ops.hasStr = true;
+        ops.str.clear();
+        ReadLiteral(c, &i, &ops.str);
+      } else {
+        ReadLiteral(c, &i, nullptr);
+      }
+      continue;
+    }
+    if (ch == '<' && i + 1 < c.n && c.p[i + 1] == '<') {
+      i += 2;  // inline dictionary (marked content properties)
+      continue;
+    }
+    if (ch == '<') {
+      if (active) {
+        ops.hasStr = true;
+        ops.str.clear();
+        ReadHex(c, &i, &ops.str);
+      } else {
+        ReadHex(c, &i, nullptr);
+      }
+      continue;
+    }
+    if (ch == '[') {
+      std::string* arr = active ? &ops.arr : nullptr;
+      if (arr) arr->clear();
+      i++;
+      while (i < c.n && c.p[i] != ']') {
+        uint8_t a = c.p[i];
+        if (TextWs(a)) {
+          i++;
+        } else if (a == '%') {
+          while (i < c.n && c.p[i] != '\n' && c.p[i] != '\r') i++;
+        } else if (a == '(') {
+          ReadLiteral(c, &i, arr);
+        } else if (a == '<' && !(i + 1 < c.n && c.p[i + 1] == '<')) {
+          ReadHex(c, &i, arr);
+        } else {
+          // kerning numbers and anything else: skip the token only
+          size_t s = i;
+          while (i < c.n && !TextDelim(c.p[i])) i++;
+          if (i == s) {
+            i++;
+            continue;
+          }
+          double kern = 0;
+          if (arr && ParseNumberToken(Bytes{c.p + s, i - s}, &kern) && kern < -kKernSpace && !arr->empty() &&
+              arr->back() != ' ') {
+            arr->push_back(' ');
+          }
+        }
+      }
+      if (i < c.n) i++;
+      if (active) ops.hasArr = true;
+      continue;
+    }
+
+    const size_t s = i;
+    while (i < c.n && !TextDelim(c.p[i])) i++;
+    if (i == s) {
+      i++;
+      continue;
+    }
+    const Bytes tok{c.p + s, i - s};
+
+    double num = 0;
+    if (ParseNumberToken(tok, &num)) {
+      if (active) {
+        ops.nums++;
+        ops.lastNum = num;
+      }
+      continue;
+    }
+
+    if (TokenIs(tok, "BT")) {
+      if (!inBT) {
+        seg.clear();
+        ops.Clear();
+        sawBT = inBT = true;
+      }
+      continue;
+    }
+    if (TokenIs(tok, "ET")) {
+      if (inBT) {
+        flush();
+        inBT = false;
+      }
+      continue;
+    }
+    if (TokenIs(tok, "ID")) {
+      // inline image data runs to "EI" after whitespace
+      size_t k = i + 1;
+      while ((k = Find(c, k, "EI")) != kNpos && !(TextWs(c.p[k - 1]) && (k + 2 == c.n || TextDelim(c.p[k + 2])))) k++;
+      i = k == kNpos ? c.n : k + 2;
+      continue;
+    }
+    if (!active) continue;
+
+    if (TokenIs(tok, "Tj")) {
+      if (ops.hasStr) seg += ops.str;
+    } else if (TokenIs(tok, "TJ")) {
+      if (ops.hasArr) seg += ops.arr;
+    } else if (TokenIs(tok, "'") || TokenIs(tok, "\"")) {
+      newline();
+      if (ops.hasStr) seg += ops.str;
+    } else if (TokenIs(tok, "T*")) {
+      newline();
+    } else if (TokenIs(tok, "Td") || TokenIs(tok, "TD") || TokenIs(tok, "Tm")) {
+      if (ops.nums >= 2 && (ops.lastNum > 0.001 || ops.lastNum < -0.001)) newline();
+    } else {
+      continue;  // other operators leave the operand stack alone
+    }
+    ops.Clear();
+  }
+  if (inBT || !sawBT) flush();
+
+  CollapseNewlines(&text);
+  TrimJs(&text);
+  return text;
+}
+
+static std::string Latin1ToUtf8(const std::string& s) {
+  std::string out;
+  out.reserve(s.size() + s.size() / 8);
+  for (unsigned char c : s) {
+    if (c < 0x80) {
+      out.push_back((char)c);
+    } else {
+      out.push_back((char)(0xC0 | (c >> 6)));
+      out.push_back((char)(0x80 | (c & 0x3F)));
+    }
+  }
+  return out;
+}
+
+// ---- driver ----
+
+struct PageJob {
+  struct Stream {
+    std::string label;
+    Bytes raw;
+    std::vector<StreamFilter> filters;
+  };
+  std::vector<Stream> streams;
+  std::string text;  // UTF-8
+  std::vector<std::string> warnings;
+};
+
+static void RunPage(PageJob* job, DecodeBudget* budget) {
+  std::vector<uint8_t> buf;
+  std::string joined;
+  Bytes content;
+  size_t decoded = 0;
+  for (const PageJob::Stream& s : job->streams) {
+    Bytes out;
+    if (!DecodeStream(s.raw, s.filters, s.label, &buf, &out, budget, &job->warnings)) continue;
+    // one stream is parsed in place; several are joined with a separator
+    if (decoded++ == 0) {
+      content = out;
+      if (job->streams.size() > 1) joined.assign((const char*)out.p, out.n);
+    } else {
+      joined.push_back('\n');
+      joined.append((const char*)out.p, out.n);
+    }
+  }
+  if (!decoded) return;
+  if (job->streams.size() > 1) content = Bytes{(const uint8_t*)joined.data(), joined.size()};
+  job->text = Latin1ToUtf8(PageText(content));
+}
+
+static void ExtractPages(Bytes file, std::vector<std::string>* pages, std::vector<std::string>* warnings) {
+  PdfDoc doc(file, warnings);
+  if (!doc.Open()) {
+    warnings->assign(1, "No PDF objects were parsed. File may be malformed or unsupported by the native parser.");
+    return;
+  }
+  if (doc.Encrypted()) {
+    warnings->push_back("PDF is encrypted; page text cannot be extracted.");
+    return;
+  }
+
+  std::vector<const PdfObject*> pageObjs = doc.Pages();
+  if (pageObjs.empty()) {
+    warnings->push_back("No /Page objects found in PDF structure.");
+    return;
+  }
+
+  // Object lookups share caches, so jobs are prepared here; decoding and
+  // parsing only touch the job and the immutable input.
+  std::vector<PageJob> jobs(pageObjs.size());
+  for (size_t k = 0; k < pageObjs.size(); k++) {
+    for (const PdfObject* o : doc.Contents(*pageObjs[k], warnings)) {
+      PageJob::Stream s;
+      s.label = Label(o->num, o->gen);
+      s.raw = o->stream;
+      doc.Filters(*o, &s.filters);
+      jobs[k].streams.push_back(std::move(s));
+    }
+  }
+
+  const size_t n = jobs.size();
+  size_t workers = std::max(1u, std::thread::hardware_concurrency());
+  workers = std::min(std::min(workers, kMaxWorkers), n);
+
+  std::atomic<size_t> next(0);
+  auto run = [&]() {
+    for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < n;) RunPage(&jobs[i], doc.Budget());
+  };
+  std::vector<std::thread> pool;
+  for (size_t t = 1; t < workers; t++) pool.emplace_back(run);
+  run();
+  for (std::thread& t : pool) t.join();
+
+  pages->reserve(n);
+  for (PageJob& j : jobs) {
+    pages->push_back(std::move(j.text));
+    for (std::string& w : j.warnings) warnings->push_back(std::move(w));
+  }
+}
+
+class PdfTextWorker : public Napi::AsyncWorker {
+public:
+  PdfTextWorker(Napi::Env env, Napi::Uint8Array bytes)
+    : Napi::AsyncWorker(env, "IdyPdfText"),
+      deferred_(Napi::Promise::Deferred::New(env)),
+      bytesRef_(Napi::Persistent(bytes)) {
+    file_.p = bytes.Data();
+    file_.n = bytes.ByteLength();
+  }
+
+  Napi::Promise Promise() { return deferred_.Promise(); }
+
+protected:
+  void Execute() override { ExtractPages(file_, &pages_, &warnings_); }
+
+  void OnOK() override {
+    Napi::Env env = Env();
+    bytesRef_.Reset();
+
+    Napi::Array pages = Napi::Array::New(env, pages_.size());
+    for (size_t i = 0; i < pages_.size(); i++) pages.Set((uint32_t)i, Napi::String::New(env, pages_[i]));
+    Napi::Array warnings = Napi::Array::New(env, warnings_.size());
+    for (size_t i = 0; i < warnings_.size(); i++) warnings.Set((uint32_t)i, Napi::String::New(env, warnings_[i]));
+
+    Napi::Object out = Napi::Object::New(env);
+    out.Set("pages", pages);
+    out.Set("warnings", warnings);
+    deferred_.Resolve(out);
+  }
+
+  void OnError(const Napi::Error& e) override {
+    bytesRef_.Reset();
+    deferred_.Reject(e.Value());
+  }
+
+private:
+  Napi::Promise::Deferred deferred_;
+  Napi::Reference<Napi::Uint8Array> bytesRef_;  // keeps the viewed bytes alive
+  Bytes file_;
+  std::vector<std::string> pages_;
+  std::vector<std::string> warnings_;
+};
+
+Napi::Value ExtractPdfText(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1 || !info[0].IsTypedArray() ||
+      info[0].As<Napi::TypedArray>().TypedArrayType() != napi_uint8_array) {
+    Napi::TypeError::New(env, "extractPdfText(bytes: Uint8Array)").ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  auto* w = new PdfTextWorker(env, info[0].As<Napi::Uint8Array>());
+  Napi::Promise promise = w->Promise();
+  w->Queue();
+  return promise;
+}
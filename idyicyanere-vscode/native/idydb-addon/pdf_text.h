@@ -0,0 +1,8 @@
+#pragma once
+#include <napi.h>
+
+// JS: extractPdfText(bytes: Uint8Array) -> Promise<{ pages: string[], warnings: string[] }>
+//  bytes is read in place on worker threads; the caller must not modify it
+//  until the promise settles. One string per page, in page-tree order.
+// Same text rules as src/views/pdfView/pdfTextPreview.ts.
+Napi::Value ExtractPdfText(const Napi::CallbackInfo& info);
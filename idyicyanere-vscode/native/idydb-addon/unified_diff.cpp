@@ -0,0 +1,535 @@
+#include "unified_diff.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Text stays UTF-16 (as JS sees it) so comparisons, JSON quoting and line
+// numbers agree with the TS implementation. Lines are views into the two input
+// buffers; only the joined result is copied. Hunks that moved are found through
+// a line -> positions index built on first use.
+using Text = std::u16string;
+using Span = std::u16string_view;
+
+static const int kMaxFuzz = 2;
+static const int64_t kMaxOffset = 1000;  // lines a hunk may be found away from where it was expected
+static const int64_t kMaxLineNo = 1000000000000000LL;  // keeps header arithmetic exact
+
+struct Issue {
+  bool warn = false;
+  Text message;
+  int64_t atLine = 0;  // 0 = unset
+  bool hasMismatch = false;
+  Text expected;
+  Text found;
+  Text context;
+  const char* code = "";
+};
+
+struct Hunk {
+  int64_t oldStart = 0;
+  int64_t oldCount = 1;
+  std::vector<Span> lines;
+};
+
+struct Op {
+  char16_t kind;  // ' ', '-', '+'
+  Span text;
+};
+
+// ---- JS string semantics ----
+
+static bool IsJsSpace(char16_t c) {
+  return (c >= 0x09 && c <= 0x0D) || c == 0x20 || c == 0xA0 || c == 0x1680 || (c >= 0x2000 && c <= 0x200A) ||
+         c == 0x2028 || c == 0x2029 || c == 0x202F || c == 0x205F || c == 0x3000 || c == 0xFEFF;
+}
+
+static Span TrimJs(Span s) {
+  size_t b = 0, e = s.size();
+  while (b < e && IsJsSpace(s[b])) b++;
+  while (e > b && IsJsSpace(s[e - 1])) e--;
+  return s.substr(b, e - b);
+}
+
+static Text U(const char* s) {
+  Text out;
+  while (*s) out.push_back((char16_t)(unsigned char)*s++);
+  return out;
+}
+
+static Text Num(int64_t v) { return U(std::to_string(v).c_str()); }
+
+static bool StartsWith(Span s, const char* prefix) {
+  size_t i = 0;
+  for (; prefix[i]; i++) {
+    if (i >= s.size() || s[i] != (char16_t)(unsigned char)prefix[i]) return false;
+  }
+  return true;
+}
+
+// JSON.stringify(s) for a string (well-formed: lone surrogates are escaped)
+static Text JsonQuote(Span s) {
+  static const char* hex = "0123456789abcdef";
+  Text out;
+  out.reserve(s.size() + 2);
+  out.push_back(u'"');
+  for (size_t i = 0; i < s.size(); i++) {
+    char16_t c = s[i];
+    switch (c) {
+      case u'"': out += u"\\\""; continue;
+      case u'\\': out += u"\\\\"; continue;
+      case u'\b': out += u"\\b"; continue;
+      case u'\f': out += u"\\f"; continue;
+      case u'\n': out += u"\\n"; continue;
+      case u'\r': out += u"\\r"; continue;
+      case u'\t': out += u"\\t"; continue;
+      default: break;
+    }
+    bool lone = false;
+    if (c >= 0xD800 && c <= 0xDBFF) {
+      if (i + 1 < s.size() && s[i + 1] >= 0xDC00 && s[i + 1] <= 0xDFFF) {
+        out.push_back(c);
+        out.push_back(s[++i]);
+        continue;
+      }
+      lone = true;
+    } else if (c >= 0xDC00 && c <= 0xDFFF) {
+      lone = true;
+    }
+    if (c < 0x20 || lone) {
+      out += u"\\u";
+      for (int sh = 12; sh >= 0; sh -= 4) out.push_back((char16_t)hex[(c >> sh) & 0xF]);
+      continue;
+    }
+    out.push_back(c);
+  }
+  out.push_back(u'"');
+  return out;
+}
+
+// ---- lines ----
+
+// Splits on \r\n, \r and \n alike (normalizeToLF + split("\n")).
+static std::vector<Span> SplitLines(Span s) {
+  std::vector<Span> out;
+  size_t b = 0;
+  for (size_t i = 0; i < s.size(); i++) {
+    char16_t c = s[i];
+    if (c != u'\n' && c != u'\r') continue;
+    out.push_back(s.substr(b, i - b));
+    if (c == u'\r' && i + 1 < s.size() && s[i + 1] == u'\n') i++;
+    b = i + 1;
+  }
+  out.push_back(s.substr(b));
+  return out;
+}
+
+static bool DominantCrlf(Span s) {
+  int64_t lf = 0, crlf = 0;
+  for (size_t i = 0; i < s.size(); i++) {
+    if (s[i] != u'\n') continue;
+    lf++;
+    if (i > 0 && s[i - 1] == u'\r') crlf++;
+  }
+  int64_t lfOnly = std::max<int64_t>(0, lf - crlf);
+  return crlf >= lfOnly && crlf > 0;
+}
+
+static Text SnippetWithLineNumbers(const std::vector<Span>& lines, int64_t at0, int64_t radius) {
+  int64_t n = (int64_t)lines.size();
+  int64_t lo = std::max<int64_t>(0, at0 - radius);
+  int64_t hi = std::min<int64_t>(n - 1, at0 + radius);
+  size_t pad = std::max<size_t>(4, std::to_string(n).size());
+
+  Text out;
+  for (int64_t i = lo; i <= hi; i++) {
+    if (i > lo) out.push_back(u'\n');
+    Text no = Num(i + 1);
+    if (no.size() < pad) out.append(pad - no.size(), u'0');
+    out += no;
+    out.push_back(u'|');
+    out.append(lines[(size_t)i]);
+  }
+  return out;
+}
+
+// ---- hunks ----
+
+static bool ReadJsSpaces(Span s, size_t* i) {
+  size_t b = *i;
+  while (*i < s.size() && IsJsSpace(s[*i])) (*i)++;
+  return *i > b;
+}
+
+static bool ReadDigits(Span s, size_t* i, int64_t* out) {
+  size_t b = *i;
+  int64_t v = 0;
+  while (*i < s.size() && s[*i] >= u'0' && s[*i] <= u'9') {
+    v = std::min(kMaxLineNo, v * 10 + (s[*i] - u'0'));
+    (*i)++;
+  }
+  *out = v;
+  return *i > b;
+}
+
+// /^@@\s+-(\d+)(?:,(\d+))?\s+\+(\d+)(?:,(\d+))?\s+@@/
+static bool ParseHunkHeader(Span s, Hunk* h) {
+  size_t i = 2;
+  int64_t unused = 0;
+  if (!StartsWith(s, "@@") || !ReadJsSpaces(s, &i)) return false;
+  if (i >= s.size() || s[i++] != u'-' || !ReadDigits(s, &i, &h->oldStart)) return false;
+  h->oldCount = 1;
+  if (i < s.size() && s[i] == u',') {
+    i++;
+    if (!ReadDigits(s, &i, &h->oldCount)) return false;
+  }
+  if (!ReadJsSpaces(s, &i)) return false;
+  if (i >= s.size() || s[i++] != u'+' || !ReadDigits(s, &i, &unused)) return false;
+  if (i < s.size() && s[i] == u',') {
+    i++;
+    if (!ReadDigits(s, &i, &unused)) return false;
+  }
+  if (!ReadJsSpaces(s, &i)) return false;
+  return StartsWith(s.substr(i), "@@");
+}
+
+static void ParseHunks(const std::vector<Span>& lines, std::vector<Hunk>* hunks, std::vector<Issue>* issues) {
+  size_t i = 0;
+  while (i < lines.size()) {
+    Span line = lines[i];
+    if (!StartsWith(line, "@@")) { i++; continue; }
+
+    Hunk h;
+    if (!ParseHunkHeader(line, &h)) {
+      Issue is;
+      is.message = U("Bad hunk header: ") + Text(line);
+      is.code = "bad_hunk_header";
+      issues->push_back(std::move(is));
+      i++;
+      continue;
+    }
+
+    i++;
+    while (i < lines.size() && !StartsWith(lines[i], "@@")) h.lines.push_back(lines[i++]);
+    hunks->push_back(std::move(h));
+  }
+
+  if (hunks->empty()) {
+    Issue is;
+    is.message = U("No @@ hunks found in diff (not a unified diff, or missing hunks).");
+    is.code = "no_hunks";
+    issues->push_back(std::move(is));
+  }
+}
+
+static bool HunkOps(const Hunk& h, std::vector<Op>* ops, Issue* issue) {
+  for (Span raw : h.lines) {
+    // ignore meta
+    if (StartsWith(raw, "\\ No newline at end of file")) continue;
+
+    // A blank line is an empty context line whose leading space was stripped
+    if (raw.empty()) {
+      ops->push_back({u' ', Span()});
+      continue;
+    }
+
+    char16_t prefix = raw[0];
+    if (prefix == u' ' || prefix == u'-' || prefix == u'+') {
+      ops->push_back({prefix, raw.substr(1)});
+      continue;
+    }
+
+    issue->message = U("Malformed hunk line (must start with ' ', '+', '-', or '\\\\'): ") + JsonQuote(raw);
+    issue->code = "bad_hunk_line";
+    return false;
+  }
+  return true;
+}
+
+class LineMatcher {
+public:
+  explicit LineMatcher(const std::vector<Span>& lines) : lines_(lines) {}
+
+  // Lines past the end read as "".
+  Span Line(int64_t pos) const {
+    return pos >= 0 && pos < (int64_t)lines_.size() ? lines_[(size_t)pos] : Span();
+  }
+
+  bool MatchesAt(int64_t pos, const std::vector<Span>& seq) const {
+    for (size_t i = 0; i < seq.size(); i++) {
+      if (Line(pos + (int64_t)i) != seq[i]) return false;
+    }
+    return true;
+  }
+
+  // Start of seq at or after minStart and at most kMaxOffset lines from want:
+  // the nearest match or, when unique is set (fuzzed seq), the only one in
+  // range. -1 if absent; *ambiguous is also set when several qualify.
+  int64_t Find(const std::vector<Span>& seq, int64_t want, int64_t minStart, bool unique, bool* ambiguous) {
+    *ambiguous = false;
+    if (!unique && want >= minStart && MatchesAt(want, seq)) return want;
+
+    if (!indexed_) {
+      index_.reserve(lines_.size());
+      for (size_t i = 0; i < lines_.size(); i++) index_[lines_[i]].push_back((uint32_t)i);
+      indexed_ = true;
+    }
+
+    // Candidates come from the rarest line of seq
+    const std::vector<uint32_t>* occ = nullptr;
+    int64_t anchor = -1;
+    for (size_t i = 0; i < seq.size(); i++) {
+      auto it = index_.find(seq[i]);
+      if (it == index_.end()) return -1;
+      if (!occ || it->second.size() < occ->size()) {
+        occ = &it->second;
+        anchor = (int64_t)i;
+      }
+    }
+    if (!occ) return -1;
+
+    int64_t found = -1;
+    int64_t best = INT64_MAX;
+    int ties = 0;
+    int64_t n = (int64_t)lines_.size();
+    for (uint32_t at : *occ) {
+      int64_t c = (int64_t)at - anchor;
+      if (c < minStart || c + (int64_t)seq.size() > n) continue;
+      int64_t d = std::llabs(c - want);
+      if (d > kMaxOffset || (!unique && d > best) || !MatchesAt(c, seq)) continue;
+      if (found < 0 || (!unique && d < best)) {
+        found = c;
+        best = d;
+        ties = 1;
+      } else if (c != found) {
+        ties++;
+      }
+    }
+    if (ties > 1) {
+      *ambiguous = true;
+      return -1;
+    }
+    return found;
+  }
+
+private:
+  const std::vector<Span>& lines_;
+  std::unordered_map<Span, std::vector<uint32_t>> index_;
+  bool indexed_ = false;
+};
+
+struct ApplyResult {
+  bool ok = false;
+  Text afterText;
+  std::vector<Issue> issues;
+};
+
+static ApplyResult Fail(Issue issue) {
+  ApplyResult r;
+  r.issues.push_back(std::move(issue));
+  return r;
+}
+
+static ApplyResult Apply(Span relRaw, Span oldText, Span diffRaw) {
+  Text rel(TrimJs(relRaw));
+
+  if (TrimJs(diffRaw).empty()) {
+    Issue is;
+    is.message = U("Empty diff.");
+    is.code = "empty_diff";
+    return Fail(std::move(is));
+  }
+
+  bool crlf = DominantCrlf(oldText);
+
+  // trimEdgeNewlinesOnly
+  size_t db = 0, de = diffRaw.size();
+  while (db < de && (diffRaw[db] == u'\n' || diffRaw[db] == u'\r')) db++;
+  while (de > db && (diffRaw[de - 1] == u'\n' || diffRaw[de - 1] == u'\r')) de--;
+
+  std::vector<Span> oldLines = SplitLines(oldText);
+  std::vector<Span> diffLines = SplitLines(diffRaw.substr(db, de - db));
+
+  ApplyResult r;
+  std::vector<Hunk> hunks;
+  ParseHunks(diffLines, &hunks, &r.issues);
+  if (!r.issues.empty()) return r;
+
+  LineMatcher matcher(oldLines);
+  const int64_t n = (int64_t)oldLines.size();
+  std::vector<Span> outLines;
+  outLines.reserve(oldLines.size());
+  int64_t origPos = 0;
+  int64_t drift = 0;
+
+  std::vector<Op> ops;
+  std::vector<Span> seq;
+  for (size_t k = 0; k < hunks.size(); k++) {
+    const Hunk& h = hunks[k];
+    ops.clear();
+    Issue bad;
+    if (!HunkOps(h, &ops, &bad)) return Fail(std::move(bad));
+
+    // "-N,0" inserts after line N
+    int64_t headerPos = h.oldCount == 0 ? std::max<int64_t>(0, h.oldStart) : std::max<int64_t>(0, h.oldStart - 1);
+    int64_t expected = headerPos + drift;
+
+    if (expected < origPos) {
+      Issue is;
+      is.message = U("Overlapping/out-of-order hunks (hunk oldStart=") + Num(h.oldStart) + U(" < current=") +
+                   Num(origPos + 1) + U(").");
+      is.code = "hunks_out_of_order";
+      return Fail(std::move(is));
+    }
+
+    size_t oldSide = 0;
+    for (const Op& op : ops) oldSide += op.kind != u'+';
+    size_t leadCtx = 0;
+    while (leadCtx < ops.size() && ops[leadCtx].kind == u' ') leadCtx++;
+    size_t trailCtx = 0;
+    while (trailCtx < ops.size() && ops[ops.size() - 1 - trailCtx].kind == u' ') trailCtx++;
+
+    // Fuzz never drops the last context line of a side that has any
+    const size_t maxLead = leadCtx ? leadCtx - 1 : 0;
+    const size_t maxTrail = trailCtx ? trailCtx - 1 : 0;
+
+    int64_t pos = -1;
+    size_t lead = 0, trail = 0;
+    bool ambiguous = false;
+    for (int f = 0; f <= kMaxFuzz && pos < 0 && !ambiguous; f++) {
+      size_t l = std::min<size_t>(f, maxLead);
+      size_t t = std::min<size_t>(f, maxTrail);
+      if (f > 0 && l == lead && t == trail) continue;
+      lead = l;
+      trail = t;
+      if (lead + trail >= ops.size() && oldSide > 0) break;
+
+      seq.clear();
+      for (size_t i = lead; i < ops.size() - trail; i++) {
+        if (ops[i].kind != u'+') seq.push_back(ops[i].text);
+      }
+      if (oldSide > 0 && seq.empty()) break;
+
+      pos = !seq.empty() ? matcher.Find(seq, expected + (int64_t)lead, origPos, lead + trail > 0, &ambiguous)
+                         : std::max(origPos, std::min(expected, n));
+    }
+
+    if (ambiguous) {
+      Issue is;
+      is.message = U("Hunk #") + Num((int64_t)k + 1) + U(" matches more than one place near ") + rel + U(":") +
+                   Num(expected + 1) + U("; add context lines to tell them apart.");
+      is.atLine = expected + 1;
+      is.context = SnippetWithLineNumbers(oldLines, expected, 3);
+      is.code = "ambiguous_hunk";
+      return Fail(std::move(is));
+    }
+
+    if (pos < 0) {
+      // Report the first mismatch of a strict apply at the expected line
+      int64_t at = expected;
+      for (const Op& op : ops) {
+        if (op.kind == u'+') continue;
+        Span found = matcher.Line(at);
+        if (found != op.text) {
+          bool isContext = op.kind == u' ';
+          Issue is;
+          is.message = U(isContext ? "Context" : "Deletion") + U(" mismatch at ") + rel + U(":") + Num(at + 1) +
+                       U(".");
+          is.atLine = at + 1;
+          is.hasMismatch = true;
+          is.expected = Text(op.text);
+          is.found = Text(found);
+          is.context = SnippetWithLineNumbers(oldLines, at, 3);
+          is.code = isContext ? "context_mismatch" : "delete_mismatch";
+          return Fail(std::move(is));
+        }
+        at++;
+      }
+      pos = expected;
+      lead = trail = 0;
+    }
+
+    // Copy unchanged lines before the hunk (including context left unverified by fuzz)
+    for (int64_t i = origPos; i < std::min(pos, n); i++) outLines.push_back(oldLines[(size_t)i]);
+    origPos = pos;
+
+    for (size_t i = lead; i < ops.size() - trail; i++) {
+      const Op& op = ops[i];
+      if (op.kind == u'+') {
+        outLines.push_back(op.text);
+        continue;
+      }
+      if (op.kind == u' ') outLines.push_back(matcher.Line(origPos));
+      origPos++;
+    }
+
+    int64_t start = pos - (int64_t)lead;
+    size_t fuzz = std::max(lead, trail);
+    drift = start - headerPos;
+    if (drift != 0 || fuzz > 0) {
+      Issue is;
+      is.warn = true;
+      is.message = U("Hunk #") + Num((int64_t)k + 1) + U(" applied at ") + rel + U(":") + Num(start + 1) +
+                   U(" (offset ") + Num(drift) + U(" line(s)");
+      if (fuzz) is.message += U(", fuzz ") + Num((int64_t)fuzz);
+      is.message += U(").");
+      is.atLine = start + 1;
+      is.code = fuzz ? "hunk_fuzz" : "hunk_offset";
+      r.issues.push_back(std::move(is));
+    }
+  }
+
+  // Copy remainder
+  for (int64_t i = origPos; i < n; i++) outLines.push_back(oldLines[(size_t)i]);
+
+  size_t total = 0;
+  for (Span s : outLines) total += s.size() + 2;
+  r.afterText.reserve(total);
+  for (size_t i = 0; i < outLines.size(); i++) {
+    if (i) r.afterText += crlf ? u"\r\n" : u"\n";
+    r.afterText.append(outLines[i]);
+  }
+  r.ok = true;
+  return r;
+}
+
+Napi::Value ApplyUnifiedDiff(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 3 || !info[0].IsString() || !info[1].IsString() || !info[2].IsString()) {
+    Napi::TypeError::New(env, "applyUnifiedDiff(rel: string, oldText: string, diff: string)")
+      .ThrowAsJavaScriptException();
+    return env.Null();
+  }
+
+  Text rel = info[0].As<Napi::String>().Utf16Value();
+  Text oldText = info[1].As<Napi::String>().Utf16Value();
+  Text diff = info[2].As<Napi::String>().Utf16Value();
+
+  ApplyResult r = Apply(rel, oldText, diff);
+
+  Napi::Object out = Napi::Object::New(env);
+  out.Set("ok", Napi::Boolean::New(env, r.ok));
+  if (r.ok) out.Set("afterText", Napi::String::New(env, r.afterText));
+
+  Napi::Array issues = Napi::Array::New(env, r.issues.size());
+  for (size_t i = 0; i < r.issues.size(); i++) {
+    const Issue& is = r.issues[i];
+    Napi::Object o = Napi::Object::New(env);
+    o.Set("severity", Napi::String::New(env, is.warn ? "warn" : "error"));
+    o.Set("message", Napi::String::New(env, is.message));
+    if (is.atLine) o.Set("atLine", Napi::Number::New(env, (double)is.atLine));
+    if (is.hasMismatch) {
+      o.Set("expected", Napi::String::New(env, is.expected));
+      o.Set("found", Napi::String::New(env, is.found));
+    }
+    if (is.hasMismatch || !is.context.empty()) o.Set("context", Napi::String::New(env, is.context));
+    o.Set("code", Napi::String::New(env, is.code));
+    issues.Set((uint32_t)i, o);
+  }
+  out.Set("issues", issues);
+  return out;
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include <napi.h>
+
+// JS: applyUnifiedDiff(rel, oldText, diff) -> { ok, afterText?, issues }
+//  Synchronous; issues use the UnifiedDiffIssue shape. afterText keeps the
+//  dominant line ending of oldText.
+// Same rules as src/editing/pipeline/tools/unitDiff.ts (tryApplyUnifiedDiff).
+Napi::Value ApplyUnifiedDiff(const Napi::CallbackInfo& info);
@@ -96,6 +96,17 @@ function snippetWithLineNumbers(lines: string[], at0: number, radius = 3): strin
 }
 
 // ---------- unified diff parsing/apply ----------
+
+// Native applier from the idydb addon, registered at activation. Same rules and
+// result shape as the TS implementation below, which stays the fallback.
+export type NativeUnifiedDiffApplier = (rel: string, oldText: string, diff: string) => ApplyUnifiedDiffResult;
+
+let nativeApply: NativeUnifiedDiffApplier | undefined;
+
+export function setNativeUnifiedDiffApplier(fn: NativeUnifiedDiffApplier | undefined): void {
+  nativeApply = fn;
+}
+
 type Hunk = {
   oldStart: number; oldCount: number;
   newStart: number; newCount: number;
@@ -156,6 +167,112 @@ function trimEdgeNewlinesOnly(s: string): string {
   return t;
 }
 
+// A hunk that no longer matches at its header line is looked up within
+// MAX_OFFSET lines of it through a line -> positions index; the candidate
+// nearest to where it was expected wins, and equally near ones are rejected as
+// ambiguous. Failing that, up to MAX_FUZZ leading/trailing context lines are
+// left unverified (patch's fuzz factor), keeping at least one on each side
+// that has context; a fuzzed hunk must match in exactly one place. Offsets
+// carry over to the next hunk. native/idydb-addon/unified_diff.cpp implements
+// the same rules.
+const MAX_FUZZ = 2;
+const MAX_OFFSET = 1000;
+
+type HunkOp = { kind: " " | "-" | "+"; text: string };
+
+function hunkOps(h: Hunk): { ops: HunkOp[]; issue?: UnifiedDiffIssue } {
+  const ops: HunkOp[] = [];
+  for (const rawLine of h.lines) {
+    if (rawLine.startsWith("\\ No newline at end of file")) {
+      // ignore meta
+      continue;
+    }
+
+    // A blank line is an empty context line whose leading space was stripped
+    if (!rawLine) {
+      ops.push({ kind: " ", text: "" });
+      continue;
+    }
+
+    const prefix = rawLine[0];
+    if (prefix === " " || prefix === "-" || prefix === "+") {
+      ops.push({ kind: prefix, text: rawLine.slice(1) });
+      continue;
+    }
+
+    // If the line doesn't start with expected prefixes, it's malformed
+    return {
+      ops,
+      issue: {
+        severity: "error",
+        message: `Malformed hunk line (must start with ' ', '+', '-', or '\\\\'): ${JSON.stringify(rawLine)}`,
+        code: "bad_hunk_line"
+      }
+    };
+  }
+  return { ops };
+}
+
+class LineMatcher {
+  private index?: Map<string, number[]>;
+
+  constructor(private readonly lines: string[]) {}
+
+  // Lines past the end read as "" (as the strict walk always did).
+  matchesAt(pos: number, seq: string[]): boolean {
+    for (let i = 0; i < seq.length; i++) {
+      if ((this.lines[pos + i] ?? "") !== seq[i]) return false;
+    }
+    return true;
+  }
+
+  // Start of seq at or after minStart and at most MAX_OFFSET lines from want:
+  // the nearest match or, when unique is set (fuzzed seq), the only one in
+  // range. -1 if absent; ambiguous when several qualify.
+  find(seq: string[], want: number, minStart: number, unique: boolean): { pos: number; ambiguous: boolean } {
+    if (!unique && want >= minStart && this.matchesAt(want, seq)) return { pos: want, ambiguous: false };
+
+    if (!this.index) {
+      this.index = new Map();
+      this.lines.forEach((line, i) => {
+        const at = this.index!.get(line);
+        if (at) at.push(i);
+        else this.index!.set(line, [i]);
+      });
+    }
+
+    // Candidates come from the rarest line of seq
+    let anchor = -1;
+    let occ: number[] | undefined;
+    for (let i = 0; i < seq.length; i++) {
+      const at = this.index.get(seq[i]);
+      if (!at) return { pos: -1, ambiguous: false };
+      if (!occ || at.length < occ.length) {
+        occ = at;
+        anchor = i;
+      }
+    }
+
+    let found = -1;
+    let best = Infinity;
+    let ties = 0;
+    for (const at of occ ?? []) {
+      const c = at - anchor;
+      if (c < minStart || c + seq.length > this.lines.length) continue;
+      const d = Math.abs(c - want);
+      if (d > MAX_OFFSET || (!unique && d > best) || !this.matchesAt(c, seq)) continue;
+      if (found < 0 || (!unique && d < best)) {
+        found = c;
+        best = d;
+        ties = 1;
+      } else if (c !== found) {
+        ties++;
+      }
+    }
+    return ties > 1 ? { pos: -1, ambiguous: true } : { pos: found, ambiguous: false };
+  }
+}
+
 export function tryApplyUnifiedDiff(params: {
   rel: string;
   oldText: string;
@@ -165,6 +282,14 @@ export function tryApplyUnifiedDiff(params: {
   const oldText = String(params.oldText ?? "");
   const diffRaw = String(params.diff ?? "");
 
+  if (nativeApply) {
+    try {
+      return nativeApply(rel, oldText, diffRaw);
+    } catch {
+      // fall through to the TS implementation
+    }
+  }
+
   if (!diffRaw.trim()) {
     return {
       ok: false,
@@ -181,13 +306,22 @@ export function tryApplyUnifiedDiff(params: {
   const { hunks, issues: parseIssues } = parseHunks(diffLF);
   if (parseIssues.length) return { ok: false, issues: parseIssues };
 
+  const matcher = new LineMatcher(oldLines);
+  const warnings: UnifiedDiffIssue[] = [];
   const outLines: string[] = [];
   let origPos = 0;
+  let drift = 0;
+
+  for (let k = 0; k < hunks.length; k++) {
+    const h = hunks[k];
+    const { ops, issue } = hunkOps(h);
+    if (issue) return { ok: false, issues: [issue] };
 
-  for (const h of hunks) {
-    const targetPos = Math.max(0, h.oldStart - 1);
+    // "-N,0" inserts after line N
+    const headerPos = h.oldCount === 0 ? Math.max(0, h.oldStart) : Math.max(0, h.oldStart - 1);
+    const expected = headerPos + drift;
 
-    if (targetPos < origPos) {
+    if (expected < origPos) {
       return {
         ok: false,
         issues: [{
@@ -198,80 +332,103 @@ export function tryApplyUnifiedDiff(params: {
       };
     }
 
-    // Copy unchanged lines before the hunk start
-    outLines.push(...oldLines.slice(origPos, targetPos));
-    origPos = targetPos;
-
-    for (const rawLine of h.lines) {
-      if (!rawLine) {
-        // empty line is valid; it will be treated by prefix rules below
+    const oldSide = ops.filter((op) => op.kind !== "+").length;
+    let leadCtx = 0;
+    while (leadCtx < ops.length && ops[leadCtx].kind === " ") leadCtx++;
+    let trailCtx = 0;
+    while (trailCtx < ops.length && ops[ops.length - 1 - trailCtx].kind === " ") trailCtx++;
+
+    // Fuzz never drops the last context line of a side that has any
+    const maxLead = leadCtx ? leadCtx - 1 : 0;
+    const maxTrail = trailCtx ? trailCtx - 1 : 0;
+
+    let pos = -1;
+    let lead = 0;
+    let trail = 0;
+    let ambiguous = false;
+    for (let f = 0; f <= MAX_FUZZ && pos < 0 && !ambiguous; f++) {
+      const l = Math.min(f, maxLead);
+      const t = Math.min(f, maxTrail);
+      if (f > 0 && l === lead && t === trail) continue;
+      lead = l;
+      trail = t;
+      if (lead + trail >= ops.length && oldSide > 0) break;
+
+      const seq = ops.slice(lead, ops.length - trail).filter((op) => op.kind !== "+").map((op) => op.text);
+      if (oldSide > 0 && !seq.length) break;
+
+      if (seq.length) {
+        ({ pos, ambiguous } = matcher.find(seq, expected + lead, origPos, lead + trail > 0));
+      } else {
+        pos = Math.max(origPos, Math.min(expected, oldLines.length));
       }
+    }
 
-      const prefix = rawLine[0];
-      const content = rawLine.slice(1);
-
-      if (rawLine.startsWith("\\ No newline at end of file")) {
-        // ignore meta
-        continue;
-      }
+    if (ambiguous) {
+      return {
+        ok: false,
+        issues: [{
+          severity: "error",
+          message: `Hunk #${k + 1} matches more than one place near ${rel}:${expected + 1}; add context lines to tell them apart.`,
+          atLine: expected + 1,
+          context: snippetWithLineNumbers(oldLines, expected, 3),
+          code: "ambiguous_hunk"
+        }]
+      };
+    }
 
-      if (prefix === " ") {
-        const found = oldLines[origPos] ?? "";
-        if (found !== content) {
-          const atLine = origPos + 1;
+    if (pos < 0) {
+      // Report the first mismatch of a strict apply at the expected line
+      let at = expected;
+      for (const op of ops) {
+        if (op.kind === "+") continue;
+        const found = oldLines[at] ?? "";
+        if (found !== op.text) {
+          const atLine = at + 1;
+          const isContext = op.kind === " ";
           return {
             ok: false,
             issues: [{
               severity: "error",
-              message: `Context mismatch at ${rel}:${atLine}.`,
+              message: `${isContext ? "Context" : "Deletion"} mismatch at ${rel}:${atLine}.`,
               atLine,
-              expected: content,
+              expected: op.text,
               found,
-              context: snippetWithLineNumbers(oldLines, origPos, 3),
-              code: "context_mismatch"
+              context: snippetWithLineNumbers(oldLines, at, 3),
+              code: isContext ? "context_mismatch" : "delete_mismatch"
             }]
           };
         }
-        outLines.push(found);
-        origPos++;
-        continue;
+        at++;
       }
+      pos = expected;
+      lead = trail = 0;
+    }
 
-      if (prefix === "-") {
-        const found = oldLines[origPos] ?? "";
-        if (found !== content) {
-          const atLine = origPos + 1;
-          return {
-            ok: false,
-            issues: [{
-              severity: "error",
-              message: `Deletion mismatch at ${rel}:${atLine}.`,
-              atLine,
-              expected: content,
-              found,
-              context: snippetWithLineNumbers(oldLines, origPos, 3),
-              code: "delete_mismatch"
-            }]
-          };
-        }
-        origPos++;
-        continue;
-      }
+    // Copy unchanged lines before the hunk (including context left unverified by fuzz)
+    outLines.push(...oldLines.slice(origPos, pos));
+    origPos = pos;
 
-      if (prefix === "+") {
-        outLines.push(content);
+    for (let i = lead; i < ops.length - trail; i++) {
+      const op = ops[i];
+      if (op.kind === "+") {
+        outLines.push(op.text);
         continue;
       }
+      if (op.kind === " ") outLines.push(oldLines[origPos] ?? "");
+      origPos++;
+    }
 
-      // If the line doesn't start with expected prefixes, it's malformed
-      return {
-        ok: false,
-        issues: [{
-          severity: "error",
-          message: `Malformed hunk line (must start with ' ', '+', '-', or '\\\\'): ${JSON.stringify(rawLine)}`,
-          code: "bad_hunk_line"
-        }]
-      };
+    const start = pos - lead;
+    const fuzz = Math.max(lead, trail);
+    drift = start - headerPos;
+    if (drift !== 0 || fuzz > 0) {
+      warnings.push({
+        severity: "warn",
+        message: `Hunk #${k + 1} applied at ${rel}:${start + 1} (offset ${drift} line(s)${fuzz ? `, fuzz ${fuzz}` : ""}).`,
+        atLine: start + 1,
+        code: fuzz ? "hunk_fuzz" : "hunk_offset"
+      });
     }
   }
 
@@ -281,7 +438,7 @@ export function tryApplyUnifiedDiff(params: {
   const afterLF = outLines.join("\n");
   const after = convertLineEndings(afterLF, fileLE);
 
-  return { ok: true, afterText: after, issues: [] };
+  return { ok: true, afterText: after, issues: warnings };
 }
 
 export function renderUnifiedDiffIssues(issues: UnifiedDiffIssue[]): string {
@@ -3,6 +3,7 @@ import * as vscode from "vscode";
 import { StoragePaths } from "../storage/paths";
 import { ConfigService } from "../storage/configService";
 import { ManifestService, ManifestEntry } from "../storage/manifestService";
+import { loadAddon } from "../storage/idyDbStore";
 import { log } from "../logging/logger";
 
 import {
@@ -25,15 +26,21 @@ import {
   DumpTreeNode
 } from "./contextDumpUtils";
 
-import { writeContextDump } from "./contextDumpWriter";
+import { NativeDumpWriter, writeContextDump } from "./contextDumpWriter";
 
 export class ContextDumpService {
   constructor(
+    private readonly context: vscode.ExtensionContext,
     private readonly paths: StoragePaths,
     private readonly config: ConfigService,
     private readonly manifest: ManifestService
   ) {}
 
+  // Native writer from the idydb addon; undefined falls back to the TS writer.
+  private nativeWriter(): NativeDumpWriter | undefined {
+    return loadAddon(this.context).writeContextDump;
+  }
+
   private buildExcludedSegments(): string[] {
     return deriveExcludedSegments([
       ...(this.config.data.indexing?.excludeGlobs ?? []),
@@ -168,18 +175,9 @@ export class ContextDumpService {
       const entry = manifestMap.get(key);
       const indexed = !!entry;
 
-      let stale = false;
-      if (entry) {
-        try {
-          const st = await vscode.workspace.fs.stat(u);
-          stale = st.mtime !== entry.mtimeMs;
-        } catch {
-          stale = false;
-        }
-      }
-
+      // stale is derived by the writer from its own stat vs the indexed mtime
       const hidden = isProbablyHiddenRel(rel);
-      items.push({ uri: u, rel, hidden, indexed, stale });
+      items.push({ uri: u, rel, hidden, indexed, stale: false, mtimeMs: entry?.mtimeMs });
     }
 
     items.sort((a, b) => a.rel.localeCompare(b.rel));
@@ -201,6 +199,7 @@ export class ContextDumpService {
       opts: wopts,
       report: (m) => report(m),
       token,
+      native: this.nativeWriter(),
     });
 
     // For tree/URI-driven selections, keep an immediate labeled backup.
@@ -515,16 +514,8 @@ export class ContextDumpService {
         }
 
         const rel = normalizeRel(vscode.workspace.asRelativePath(uri, false));
-        // stale computed by writer from fs stat vs entry? no: we compute here (cheap) per-item
-        let stale = false;
-        try {
-          const st = await vscode.workspace.fs.stat(uri);
-          stale = st.mtime !== entry.mtimeMs;
-        } catch {
-          // missing handled by writer; keep stale=false
-        }
-
-        items.push({ uri, rel, hidden, stale, indexed: true });
+        // stale is derived by the writer from the stat it already does per file
+        items.push({ uri, rel, hidden, stale: false, indexed: true, mtimeMs: entry.mtimeMs });
       } catch {
         continue;
       }
@@ -548,6 +539,7 @@ export class ContextDumpService {
       opts: wopts,
       report: (m) => report(m),
       token,
+      native: this.nativeWriter(),
     });
 
     // Footer summary appended after streaming body: do it here (small + simple)
@@ -45,6 +45,8 @@ export type DumpWriterItem = {
   // flags show up in headers; the writer doesn’t compute them
   stale?: boolean;
   indexed?: boolean;
+  // indexed mtime: when set, the writer derives `stale` from its own stat
+  mtimeMs?: number;
 };
 
 export function normalizeRel(rel: string): string {
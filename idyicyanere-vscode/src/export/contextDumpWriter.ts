@@ -47,6 +47,36 @@ async function readUpTo(fsPath: string, maxBytes: number): Promise<Buffer> {
   }
 }
 
+export type NativeDumpItem = {
+  path: string;
+  rel: string;
+  lang: string;
+  hidden: boolean;
+  indexed: boolean;
+  stale: boolean;
+  mtimeMs?: number;
+};
+
+export type NativeDumpResult = {
+  cancelled: boolean;
+  includedWritten: number;
+  skippedMissing: number;
+  skippedBinary: number;
+  truncatedFiles: number;
+  stoppedByMaxTotal: boolean;
+  totalBytesWritten: number;
+};
+
+// native/idydb-addon/context_dump.cpp: same output, files are read, hashed and
+// decoded on worker threads and written in order. onProgress returns true to cancel.
+export type NativeDumpWriter = (
+  outputPath: string,
+  headerLines: string[],
+  items: NativeDumpItem[],
+  opts: DumpWriteOptions,
+  onProgress?: (done: number, total: number, rel: string) => boolean
+) => Promise<NativeDumpResult>;
+
 type WriterArgs = {
   outputFsPath: string;
   headerLines: string[];
@@ -55,9 +85,56 @@ type WriterArgs = {
   opts: DumpWriteOptions;
   report?: (msg: string) => void;
   token?: vscode.CancellationToken;
+  native?: NativeDumpWriter;
 };
 
+async function writeContextDumpNative(args: WriterArgs, native: NativeDumpWriter): Promise<{ cancelled: boolean }> {
+  const { outputFsPath, headerLines, items, stats, opts, report, token } = args;
+
+  const nativeItems: NativeDumpItem[] = items.map((it) => ({
+    path: it.uri.fsPath,
+    rel: it.rel,
+    lang: langForRel(it.rel),
+    hidden: it.hidden,
+    indexed: !!it.indexed,
+    stale: !!it.stale,
+    mtimeMs: it.mtimeMs,
+  }));
+
+  try {
+    const r = await native(
+      outputFsPath,
+      headerLines,
+      nativeItems,
+      {
+        maxFileBytes: opts.maxFileBytes,
+        maxTotalBytes: opts.maxTotalBytes,
+        noFences: opts.noFences,
+        listOnly: opts.listOnly,
+      },
+      (done, total, rel) => {
+        report?.(`Dumping ${done}/${total}: ${rel}`);
+        return !!token?.isCancellationRequested;
+      }
+    );
+
+    stats.includedWritten += r.includedWritten;
+    stats.skippedMissing += r.skippedMissing;
+    stats.skippedBinary += r.skippedBinary;
+    stats.truncatedFiles += r.truncatedFiles;
+    stats.totalBytesWritten += r.totalBytesWritten;
+    stats.stoppedByMaxTotal = stats.stoppedByMaxTotal || r.stoppedByMaxTotal;
+
+    return { cancelled: r.cancelled };
+  } catch (err) {
+    log.caught("contextDumpWriter.writeContextDumpNative", err);
+    throw err;
+  }
+}
+
 export async function writeContextDump(args: WriterArgs): Promise<{ cancelled: boolean }> {
+  if (args.native) return writeContextDumpNative(args, args.native);
+
   const { outputFsPath, headerLines, items, stats, opts, report, token } = args;
 
   const ws = fs.createWriteStream(outputFsPath, { encoding: "utf8" });
@@ -104,7 +181,7 @@ export async function writeContextDump(args: WriterArgs): Promise<{ cancelled: b
       }
 
       const size = st.size;
-      const stale = !!it.stale;
+      const stale = it.mtimeMs !== undefined ? st.mtime !== it.mtimeMs : !!it.stale;
       const indexed = !!it.indexed;
 
       // detect binary
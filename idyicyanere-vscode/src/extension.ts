@@ -4,9 +4,10 @@ import { ConfigService } from "./storage/configService";
 import { ManifestService } from "./storage/manifestService";
 import { OpenAIService } from "./openai/openaiService";
 import { IndexService } from "./indexing/indexService";
-import { IdyDbStore } from "./storage/idyDbStore";
+import { IdyDbStore, loadAddon } from "./storage/idyDbStore";
 import { log, registerLogger } from "./logging/logger";
 import { ContextDumpService } from "./export/contextDumpService";
+import { setNativeUnifiedDiffApplier } from "./editing/pipeline/tools/unitDiff";
 
 import { ChatViewProvider } from "./views/chatView/chatViewProvider";
 import { DbViewProvider } from "./views/dbView/dbViewProvider";
@@ -254,14 +255,17 @@ export async function activate(context: vscode.ExtensionContext) {
   const manifest = new ManifestService(paths);
   await withTimeout(manifest.load(), 10000, "ManifestService.load()");
 
-  const contextDump = new ContextDumpService(paths, config, manifest);
+  const contextDump = new ContextDumpService(context, paths, config, manifest);
 
   // Native vector store (IdyDB C++ addon)
   const store = new IdyDbStore(context, paths.dbPath);
   await withTimeout(store.open(), 15000, "IdyDbStore.open()");
 
+  // Unified diffs are applied natively when the addon provides it (pure TS otherwise)
+  setNativeUnifiedDiffApplier(loadAddon(context).applyUnifiedDiff);
+
   const openai = new OpenAIService(context, config);
-  const indexer = new IndexService(config, manifest, store, openai);
+  const indexer = new IndexService(context, config, manifest, store, openai);
 
   // Proposed-content provider for main-editor diffs
   const proposedProvider = new ProposedContentProvider();
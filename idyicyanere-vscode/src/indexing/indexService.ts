@@ -3,6 +3,7 @@ import { ManifestService } from "../storage/manifestService";
 import { ConfigService } from "../storage/configService";
 import { OpenAIService } from "../openai/openaiService";
 import { IdyDbStore } from "../storage/idyDbStore";
+import { extractPdfText } from "../views/pdfView/pdfTextPreview";
 import { log } from "../logging/logger";
 import * as path from "path";
 import * as crypto from "crypto";
@@ -87,6 +88,7 @@ export class IndexService {
   }
 
   constructor(
+    private readonly context: vscode.ExtensionContext,
     private readonly config: ConfigService,
     private readonly manifest: ManifestService,
     private readonly store: IdyDbStore,
@@ -212,7 +214,9 @@ export class IndexService {
         return;
       }
 
-      for (let i = 0; i < Math.min(bytes.length, 2048); i++) {
+      const isPdf = this.normalizeExt(path.extname(rel)) === ".pdf";
+
+      for (let i = 0; !isPdf && i < Math.min(bytes.length, 2048); i++) {
         if (bytes[i] === 0) {
           log.warn("Skipped (binary)", { file: rel });
           vscode.window.showWarningMessage(`Skipped (binary): ${uri.fsPath}`);
@@ -220,7 +224,9 @@ export class IndexService {
         }
       }
 
-      const text = new TextDecoder("utf-8", { fatal: false }).decode(bytes);
+      const text = isPdf
+        ? await this.pdfText(rel, bytes)
+        : new TextDecoder("utf-8", { fatal: false }).decode(bytes);
 
       if (text.trim().length === 0) {
         const old = this.manifest.get(key);
@@ -290,6 +296,16 @@ export class IndexService {
     }
   }
 
+  // Pages are separated by a blank line; a PDF with no extractable text ends up
+  // in the whitespace-only branch like an empty file.
+  private async pdfText(rel: string, bytes: Uint8Array): Promise<string> {
+    const { pages, warnings } = await extractPdfText(this.context, bytes);
+    if (warnings.length) {
+      log.warn("PDF text extraction warnings", { file: rel, count: warnings.length, first: warnings.slice(0, 3) });
+    }
+    return pages.join("\n\n");
+  }
+
   async reindexStaleIncluded(
     opts?: {
       limit?: number;
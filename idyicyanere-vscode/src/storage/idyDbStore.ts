@@ -3,6 +3,9 @@ import * as fsp from "fs/promises";
 import * as path from "path";
 import * as fs from "fs";
 import type * as vscode from "vscode";
+import type { NativeDumpWriter } from "../export/contextDumpWriter";
+import type { PdfTextPreview } from "../views/pdfView/pdfTextPreview";
+import type { NativeUnifiedDiffApplier } from "../editing/pipeline/tools/unitDiff";
 
 type Metric = "cosine" | "l2";
 
@@ -42,6 +45,38 @@ type FallbackRow = {
   values: Map<number, any>;
 };
 
+export type DbColumnStats = { column: number; cells: number; bytes: number; nextRow: number };
+
+/** Per manifest file, aligned with the `files` passed to statsSnapshot(). */
+export type DbFileStats = {
+  checked: boolean; // false: not a local path, stale/missing left to the caller
+  stale: boolean;
+  missing: boolean;
+  storedRows: number; // rows of this file that hold data in the DB
+  bytes: number;
+};
+
+export type DbStatsSnapshot = {
+  fileBytes: number;
+  cells: number;
+  nextRow: number; // row the next insert would take
+  columns: DbColumnStats[];
+  liveRows: number;
+  liveBytes: number;
+  deadRows: number; // rows holding data that no manifest entry references
+  deadBytes: number;
+  uniqueRowsAll: number;
+  uniqueRowsIncluded: number;
+  files: DbFileStats[];
+};
+
+export type DbStatsFile = {
+  fsPath: string; // "" when the file is not on the local disk
+  mtimeMs: number;
+  included: boolean;
+  rows: number[];
+};
+
 type IdyDbRuntime = {
   open: (dbPath: string, flags: number) => void;
   close: () => void;
@@ -63,10 +98,21 @@ type IdyDbRuntime = {
     metaCols: number[],
     relFilter: string
   ) => Array<{ row?: number; score: number; text: string; meta?: Record<string, any> }>;
+  statsSnapshot: (
+    paths: string[],
+    mtimesMs: Float64Array,
+    included: Uint8Array,
+    rows: Uint32Array,
+    rowEnds: Uint32Array
+  ) => Promise<DbStatsSnapshot>;
 };
 
 type AddonModule = {
   IdyDb: new () => IdyDbRuntime;
+  // Absent on the fallback and on builds that predate it; callers keep a TS path.
+  writeContextDump?: NativeDumpWriter;
+  extractPdfText?: (bytes: Uint8Array) => Promise<PdfTextPreview>;
+  applyUnifiedDiff?: NativeUnifiedDiffApplier;
   __fallback?: boolean;
   __reason?: string;
 };
@@ -268,6 +314,103 @@ function createFallbackAddon(reason: string): AddonModule {
       out.sort((a, b) => b.score - a.score);
       return out.slice(0, Math.max(1, Math.trunc(Number(limit ?? 1))));
     }
+
+    // Approximates the native on-disk cell size (segment header + payload).
+    private static cellBytes(v: any): number {
+      if (v instanceof Float32Array) return 3 + 2 + v.length * 4;
+      if (typeof v === "string") return 3 + 2 + Buffer.byteLength(v, "utf8") + 1;
+      if (typeof v === "boolean") return 3;
+      return 3 + 4;
+    }
+
+    async statsSnapshot(
+      paths: string[],
+      mtimesMs: Float64Array,
+      included: Uint8Array,
+      rows: Uint32Array,
+      rowEnds: Uint32Array
+    ): Promise<DbStatsSnapshot> {
+      const rowBytes = new Map<number, number>();
+      const cols = new Map<number, DbColumnStats>();
+      let cells = 0;
+      let nextRow = 1;
+      for (const [row, rec] of this.rows.entries()) {
+        for (const [col, val] of rec.values.entries()) {
+          const b = FallbackIdyDb.cellBytes(val);
+          let c = cols.get(col);
+          if (!c) cols.set(col, (c = { column: col, cells: 0, bytes: 0, nextRow: 1 }));
+          c.cells++;
+          c.bytes += b;
+          c.nextRow = Math.max(c.nextRow, row + 1);
+          rowBytes.set(row, (rowBytes.get(row) ?? 0) + b);
+          cells++;
+          nextRow = Math.max(nextRow, row + 1);
+        }
+      }
+
+      const all = new Set<number>();
+      const inc = new Set<number>();
+      const files: DbFileStats[] = [];
+      let begin = 0;
+      for (let i = 0; i < paths.length; i++) {
+        let storedRows = 0;
+        let bytes = 0;
+        for (let j = begin; j < rowEnds[i]; j++) {
+          const b = rowBytes.get(rows[j]) ?? 0;
+          if (b) {
+            storedRows++;
+            bytes += b;
+          }
+          all.add(rows[j]);
+          if (included[i]) inc.add(rows[j]);
+        }
+        begin = Math.max(begin, rowEnds[i]);
+        files.push({ checked: false, stale: false, missing: false, storedRows, bytes });
+      }
+
+      await Promise.all(
+        paths.map(async (p, i) => {
+          if (!p) return;
+          files[i].checked = true;
+          try {
+            const st = await fsp.stat(p);
+            files[i].stale = Math.trunc(st.mtimeMs) !== mtimesMs[i];
+          } catch {
+            files[i].missing = true;
+          }
+        })
+      );
+
+      let liveRows = 0;
+      let liveBytes = 0;
+      let deadRows = 0;
+      let deadBytes = 0;
+      let fileBytes = 0;
+      for (const [row, b] of rowBytes.entries()) {
+        fileBytes += b;
+        if (all.has(row)) {
+          liveRows++;
+          liveBytes += b;
+        } else {
+          deadRows++;
+          deadBytes += b;
+        }
+      }
+
+      return {
+        fileBytes,
+        cells,
+        nextRow,
+        columns: [...cols.values()].sort((a, b) => a.column - b.column),
+        liveRows,
+        liveBytes,
+        deadRows,
+        deadBytes,
+        uniqueRowsAll: all.size,
+        uniqueRowsIncluded: inc.size,
+        files,
+      };
+    }
   }
 
   return {
@@ -277,7 +420,14 @@ function createFallbackAddon(reason: string): AddonModule {
   };
 }
 
-export function loadAddon(context: vscode.ExtensionContext) {
+// One module per extension host: the DB store and the context dump share it.
+let loadedAddon: AddonModule | undefined;
+
+export function loadAddon(context: vscode.ExtensionContext): AddonModule {
+  return (loadedAddon ??= loadAddonModule(context));
+}
+
+function loadAddonModule(context: vscode.ExtensionContext): AddonModule {
   const addonPath = path.join(
     context.extensionPath,
     "native",
@@ -447,6 +597,54 @@ export class IdyDbStore {
     });
   }
 
+  /**
+   * One native call for the DB view: engine cell/byte counters, live vs dead
+   * rows against the manifest, and stale/missing for every local file
+   * (stat'ed in parallel off the extension host thread).
+   */
+  async statsSnapshot(files: DbStatsFile[]): Promise<DbStatsSnapshot> {
+    return this.runExclusive("statsSnapshot", async () => {
+      const fn = (this.db as any)?.statsSnapshot;
+      if (typeof fn !== "function") {
+        throw new Error("Native addon missing statsSnapshot(). Rebuild native/idydb-addon.");
+      }
+
+      const n = files.length;
+      const mtimes = new Float64Array(n);
+      const included = new Uint8Array(n);
+      const rowEnds = new Uint32Array(n);
+      let total = 0;
+      for (const f of files) total += f.rows.length;
+      const rows = new Uint32Array(total);
+
+      let at = 0;
+      for (let i = 0; i < n; i++) {
+        const f = files[i];
+        mtimes[i] = Number(f.mtimeMs) || 0;
+        included[i] = f.included ? 1 : 0;
+        for (const r of f.rows) {
+          const row = Math.trunc(Number(r));
+          rows[at++] = Number.isFinite(row) && row > 0 ? row : 0;
+        }
+        rowEnds[i] = at;
+      }
+
+      const raw = (await fn.call(
+        this.db,
+        files.map((f) => f.fsPath),
+        mtimes,
+        included,
+        rows,
+        rowEnds
+      )) as DbStatsSnapshot;
+
+      // native nextRow spans every column; inserts continue from TEXT_COL
+      const text = raw.columns.find((c) => c.column === TEXT_COL);
+      log.debug("IdyDbStore.statsSnapshot()", { files: n, cells: raw.cells, deadRows: raw.deadRows });
+      return { ...raw, nextRow: text ? text.nextRow : 1 };
+    });
+  }
+
   takeFreeRow(): number | undefined {
     const r = this.freeRows.pop();
     if (r === undefined) return undefined;
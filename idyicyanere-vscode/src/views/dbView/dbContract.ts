@@ -17,6 +17,8 @@ export type DbFileRow = {
   uri: string;
   rel: string;
   rows: number;
+  storedRows: number;
+  bytes: number;
   mtimeMs: number;
   stale: boolean;
   missing: boolean;
@@ -46,6 +48,12 @@ export type DbStatsPayload = {
   dbMtimeMs: number | null;
   nextRow: number | null;
 
+  cells: number | null;
+  columns: number | null;
+  liveBytes: number | null;
+  deadBytes: number | null;
+  deadRows: number | null;
+
   embeddingModel: string;
   chatModel: string;
   rag: { k: number; maxChars: number; metric: RagMetric };
@@ -1,9 +1,9 @@
 import * as vscode from "vscode";
 import { StoragePaths } from "../../storage/paths";
-import { ManifestService } from "../../storage/manifestService";
+import { ManifestService, ManifestEntry } from "../../storage/manifestService";
 import { ConfigService, RagMetric } from "../../storage/configService";
 import { OpenAIService } from "../../openai/openaiService";
-import { IdyDbStore } from "../../storage/idyDbStore";
+import { IdyDbStore, DbStatsSnapshot } from "../../storage/idyDbStore";
 import { IndexService } from "../../indexing/indexService";
 import { log } from "../../logging/logger";
 
@@ -60,6 +60,15 @@ async function ensureFreshIncludedIndex(host: DbHost, deps: DbDeps, limit: numbe
   if (refresh.found > 0) log.info("DB: refreshed stale files", refresh);
 }
 
+function uniqueRows(entries: Array<[string, ManifestEntry]>, includedOnly: boolean): number {
+  const set = new Set<number>();
+  for (const [, entry] of entries) {
+    if (includedOnly && entry.included === false) continue;
+    for (const r of entry.rows ?? []) set.add(r);
+  }
+  return set.size;
+}
+
 export async function sendStats(host: DbHost, deps: DbDeps): Promise<void> {
   await deps.config.ensure();
 
@@ -77,18 +86,31 @@ export async function sendStats(host: DbHost, deps: DbDeps): Promise<void> {
     dbExists = false;
   }
 
-  let nextRow: number | null = null;
+  const entries = [...deps.manifest.entries()];
+  const uris = entries.map(([key]) => {
+    try {
+      return vscode.Uri.parse(key);
+    } catch {
+      return undefined;
+    }
+  });
+
+  let snap: DbStatsSnapshot | undefined;
   try {
-    nextRow = await deps.store.getNextRow();
-  } catch {
-    nextRow = null;
+    snap = await deps.store.statsSnapshot(
+      entries.map(([, entry], i) => ({
+        fsPath: uris[i]?.scheme === "file" ? uris[i]!.fsPath : "",
+        mtimeMs: entry.mtimeMs,
+        included: entry.included !== false,
+        rows: entry.rows ?? [],
+      }))
+    );
+  } catch (e: any) {
+    log.caught("sendStats.statsSnapshot", e);
   }
 
   const files: DbFileRow[] = [];
 
-  const uniqueAll = new Set<number>();
-  const uniqueIncluded = new Set<number>();
-
   let totalFiles = 0;
   let hiddenFiles = 0;
   let includedFiles = 0;
@@ -96,7 +118,13 @@ export async function sendStats(host: DbHost, deps: DbDeps): Promise<void> {
   let trackedRowsAll = 0;
   let trackedRowsIncluded = 0;
 
-  for (const [key, entry] of deps.manifest.entries()) {
+  // Files the native snapshot could not stat (non-file schemes, or no snapshot)
+  const unchecked: Array<{ row: DbFileRow; uri: vscode.Uri; mtimeMs: number }> = [];
+
+  for (let i = 0; i < entries.length; i++) {
+    const [key, entry] = entries[i];
+    const uri = uris[i];
+    const native = snap?.files[i];
     totalFiles++;
 
     const isHidden = entry.included === false;
@@ -107,45 +135,31 @@ export async function sendStats(host: DbHost, deps: DbDeps): Promise<void> {
     trackedRowsAll += rowsLen;
     if (!isHidden) trackedRowsIncluded += rowsLen;
 
-    for (const r of entry.rows ?? []) uniqueAll.add(r);
-    if (!isHidden) for (const r of entry.rows ?? []) uniqueIncluded.add(r);
-
-    let rel = key;
-    let missing = false;
-    let stale = false;
-
-    try {
-      const uri = vscode.Uri.parse(key);
-      rel = vscode.workspace.asRelativePath(uri, false);
+    const row: DbFileRow = {
+      uri: uri ? uri.toString() : key,
+      rel: uri ? vscode.workspace.asRelativePath(uri, false) : key,
+      rows: rowsLen,
+      storedRows: native?.storedRows ?? rowsLen,
+      bytes: native?.bytes ?? 0,
+      mtimeMs: entry.mtimeMs,
+      stale: native?.stale ?? false,
+      missing: uri ? (native?.missing ?? false) : true,
+      hidden: isHidden,
+    };
+    files.push(row);
+    if (uri && !native?.checked) unchecked.push({ row, uri, mtimeMs: entry.mtimeMs });
+  }
 
+  await Promise.all(
+    unchecked.map(async ({ row, uri, mtimeMs }) => {
       try {
         const st = await vscode.workspace.fs.stat(uri);
-        stale = st.mtime !== entry.mtimeMs;
+        row.stale = st.mtime !== mtimeMs;
       } catch {
-        missing = true;
+        row.missing = true;
       }
-
-      files.push({
-        uri: uri.toString(),
-        rel,
-        rows: rowsLen,
-        mtimeMs: entry.mtimeMs,
-        stale,
-        missing,
-        hidden: isHidden,
-      });
-    } catch {
-      files.push({
-        uri: key,
-        rel,
-        rows: rowsLen,
-        mtimeMs: entry.mtimeMs,
-        stale: false,
-        missing: true,
-        hidden: isHidden,
-      });
-    }
-  }
+    })
+  );
 
   files.sort((a, b) => a.rel.localeCompare(b.rel));
 
@@ -156,7 +170,13 @@ export async function sendStats(host: DbHost, deps: DbDeps): Promise<void> {
       dbExists,
       dbSizeBytes,
       dbMtimeMs,
-      nextRow,
+      nextRow: snap ? snap.nextRow : null,
+
+      cells: snap ? snap.cells : null,
+      columns: snap ? snap.columns.length : null,
+      liveBytes: snap ? snap.liveBytes : null,
+      deadBytes: snap ? snap.deadBytes : null,
+      deadRows: snap ? snap.deadRows : null,
 
       embeddingModel: deps.config.data.openai.embeddingModel,
       chatModel: deps.config.data.openai.modelHeavy,
@@ -168,8 +188,8 @@ export async function sendStats(host: DbHost, deps: DbDeps): Promise<void> {
 
       trackedRowsAll,
       trackedRowsIncluded,
-      uniqueRowsAll: uniqueAll.size,
-      uniqueRowsIncluded: uniqueIncluded.size,
+      uniqueRowsAll: snap ? snap.uniqueRowsAll : uniqueRows(entries, false),
+      uniqueRowsIncluded: snap ? snap.uniqueRowsIncluded : uniqueRows(entries, true),
 
       files,
     },
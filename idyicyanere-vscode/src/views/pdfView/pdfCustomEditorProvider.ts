@@ -2,7 +2,7 @@ import * as vscode from "vscode";
 import * as path from "path";
 import { createHash } from "crypto";
 import { log } from "../../logging/logger";
-import { extractPdfTextPreview } from "./pdfTextPreview";
+import { extractPdfText } from "./pdfTextPreview";
 
 type ActiveContentMarker = {
   token: string;
@@ -182,7 +182,7 @@ export class PdfCustomEditorProvider implements vscode.CustomReadonlyEditorProvi
       }
 
       // Build fallback content up-front. Used when CDN is unavailable or render fails.
-      const preview = extractPdfTextPreview(bytes);
+      const preview = await extractPdfText(this.context, bytes);
       state.previewPages = preview.pages;
       state.previewWarnings = preview.warnings;
     } catch (err) {
@@ -1,4 +1,8 @@
 import * as zlib from "zlib";
+import type * as vscode from "vscode";
+
+import { log } from "../../logging/logger";
+import { loadAddon } from "../../storage/idyDbStore";
 
 export type PdfTextPreview = {
   pages: string[];
@@ -14,6 +18,14 @@ type PdfObject = {
   stream?: Buffer;
 };
 
+// Inflated output caps, as in native/idydb-addon/pdf_text.cpp: per stream and
+// per document, so a small compressed bomb cannot exhaust memory.
+const MAX_STREAM_BYTES = 64 * 1024 * 1024;
+const MAX_DOC_BYTES = 256 * 1024 * 1024;
+
+// Inflated bytes the document may still produce.
+type DecodeBudget = { left: number; reported: boolean };
+
 function refKey(ref: PdfRef): string {
   return `${ref.num} ${ref.gen}`;
 }
@@ -167,7 +179,7 @@ function decodeAscii85(src: string): Buffer | null {
   return Buffer.from(out) as Buffer;
 }
 
-function decodeStream(obj: PdfObject, warnings: string[]): Buffer | null {
+function decodeStream(obj: PdfObject, warnings: string[], budget: DecodeBudget): Buffer | null {
   if (!obj.stream) return null;
 
   const filters = parseFilters(obj.dict);
@@ -176,13 +188,34 @@ function decodeStream(obj: PdfObject, warnings: string[]): Buffer | null {
 
   for (const f of filters) {
     if (f === "FlateDecode") {
+      // zlib's sync API cannot stop early with partial output: a stream over
+      // the cap is skipped (the native extractor keeps its first bytes)
+      const cap = Math.min(MAX_STREAM_BYTES, budget.left);
       try {
-        data = zlib.inflateSync(data) as Buffer;
+        if (cap <= 0) throw new RangeError("document budget spent");
+        data = zlib.inflateSync(data, { maxOutputLength: cap }) as Buffer;
       } catch (err) {
+        if (err instanceof RangeError && cap < MAX_STREAM_BYTES) {
+          if (!budget.reported) {
+            budget.reported = true;
+            warnings.push(
+              `FlateDecode output reached the ${MAX_DOC_BYTES}-byte document cap at object ${obj.ref.num} ${obj.ref.gen}; ` +
+                "later compressed streams are skipped."
+            );
+          }
+          return null;
+        }
+        if (err instanceof RangeError) {
+          warnings.push(
+            `FlateDecode output of object ${obj.ref.num} ${obj.ref.gen} exceeds ${MAX_STREAM_BYTES} bytes; skipped.`
+          );
+          return null;
+        }
         const msg = err instanceof Error ? err.message : String(err);
         warnings.push(`FlateDecode failed on object ${obj.ref.num} ${obj.ref.gen}: ${msg}`);
         return null;
       }
+      budget.left -= data.length;
       continue;
     }
 
@@ -232,13 +265,13 @@ function extractTopLevelDict(body: string): string {
   return body;
 }
 
-function expandObjectStreams(objects: Map<string, PdfObject>, warnings: string[]): void {
+function expandObjectStreams(objects: Map<string, PdfObject>, warnings: string[], budget: DecodeBudget): void {
   const baseObjects = Array.from(objects.values());
 
   for (const obj of baseObjects) {
     if (!/\/Type\s*\/ObjStm\b/.test(obj.dict)) continue;
 
-    const decoded = decodeStream(obj, warnings);
+    const decoded = decodeStream(obj, warnings, budget);
     if (!decoded) continue;
 
     const txt = decoded.toString("latin1");
@@ -433,6 +466,10 @@ function parseHexString(src: string, start: number): { value: string; end: numbe
   return { value, end: i };
 }
 
+const NUMBER_RE = /^[+-]?(?:\d+\.?\d*|\.\d+)$/;
+// TJ gap (1/1000 em) read as a word break
+const KERN_SPACE = 200;
+
 function parseArrayStrings(src: string, start: number): { values: string[]; end: number } {
   let i = start + 1;
   const values: string[] = [];
@@ -468,7 +505,21 @@ function parseArrayStrings(src: string, start: number): { values: string[]; end:
       continue;
     }
 
-    while (i < src.length && !isWhitespace(src[i]) && src[i] !== "]") i++;
+    // Kerning numbers (and anything else) end at the next delimiter, so the
+    // string after them is kept. A gap wider than KERN_SPACE reads as a space.
+    const tokenStart = i;
+    while (i < src.length && !isDelimiter(src[i])) i++;
+    if (i === tokenStart) {
+      i++;
+      continue;
+    }
+
+    const token = src.slice(tokenStart, i);
+    if (NUMBER_RE.test(token) && Number(token) < -KERN_SPACE) {
+      let k = values.length - 1;
+      while (k >= 0 && !values[k]) k--;
+      if (k >= 0 && !values[k].endsWith(" ")) values.push(" ");
+    }
   }
 
   return { values, end: i };
@@ -558,7 +609,7 @@ function parseTextSegment(segment: string): string {
       continue;
     }
 
-    if (/^[+-]?(?:\d+\.?\d*|\.\d+)$/.test(token)) {
+    if (NUMBER_RE.test(token)) {
       operands.push({ kind: "number", value: Number(token) });
       continue;
     }
@@ -628,7 +679,8 @@ function extractTextFromContent(content: string): string {
 function extractPageText(
   pageObj: PdfObject,
   objects: Map<string, PdfObject>,
-  warnings: string[]
+  warnings: string[],
+  budget: DecodeBudget
 ): string {
   const refs = getContentsRefs(pageObj);
   const streams: Buffer[] = [];
@@ -640,11 +692,11 @@ function extractPageText(
         warnings.push(`Missing contents object ${ref.num} ${ref.gen} for page ${pageObj.ref.num}.`);
         continue;
       }
-      const decoded = decodeStream(obj, warnings);
+      const decoded = decodeStream(obj, warnings, budget);
       if (decoded) streams.push(decoded);
     }
   } else {
-    const decoded = decodeStream(pageObj, warnings);
+    const decoded = decodeStream(pageObj, warnings, budget);
     if (decoded) streams.push(decoded);
   }
 
@@ -663,7 +715,8 @@ export function extractPdfTextPreview(bytes: Uint8Array): PdfTextPreview {
     };
   }
 
-  expandObjectStreams(objects, warnings);
+  const budget: DecodeBudget = { left: MAX_DOC_BYTES, reported: false };
+  expandObjectStreams(objects, warnings, budget);
 
   const pageRefs = getPageRefs(objects, warnings);
   if (!pageRefs.length) {
@@ -682,8 +735,28 @@ export function extractPdfTextPreview(bytes: Uint8Array): PdfTextPreview {
       continue;
     }
 
-    pages.push(extractPageText(pageObj, objects, warnings));
+    pages.push(extractPageText(pageObj, objects, warnings, budget));
   }
 
   return { pages, warnings };
 }
+
+/**
+ * Page text via the idydb addon (native/idydb-addon/pdf_text.cpp): xref-driven
+ * object lookup, decoding and parsing on worker threads. Falls back to
+ * extractPdfTextPreview when the addon is missing or rejects.
+ */
+export async function extractPdfText(
+  context: vscode.ExtensionContext,
+  bytes: Uint8Array
+): Promise<PdfTextPreview> {
+  const native = loadAddon(context).extractPdfText;
+  if (native) {
+    try {
+      return await native(bytes);
+    } catch (err) {
+      log.caught("pdfTextPreview.extractPdfText", err);
+    }
+  }
+  return extractPdfTextPreview(bytes);
+}